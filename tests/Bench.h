@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_BENCH_H
+#define UITK_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int kMinReps = 3;
+static const int kMaxReps = 1000;
+
+struct Result
+{
+    std::string name;
+    std::string params;
+    int64_t nOps;
+    int reps;
+    double nsPerOp;  // median
+    double minNsPerOp;
+};
+
+class Bench
+{
+public:
+    Bench(const std::string& filter, double minSecs) : mFilter(filter), mMinSecs(minSecs) {}
+
+    bool shouldRun(const std::string& name) const
+    {
+        return (mFilter.empty() || name.find(mFilter) != std::string::npos);
+    }
+
+    // Times body(), which does nOps operations. setup() is called (untimed)
+    // before each repetition, for benchmarks that consume their state.
+    void run(const std::string& name, const std::string& params, int64_t nOps,
+             std::function<void()> body, std::function<void()> setup = nullptr)
+    {
+        if (!shouldRun(name + " " + params)) {
+            return;
+        }
+
+        if (setup) {  // warm up caches, lazily created objects, etc.
+            setup();
+        }
+        body();
+
+        std::vector<double> nsPerOp;
+        double totalSecs = 0.0;
+        while ((int(nsPerOp.size()) < kMinReps || totalSecs < mMinSecs) && int(nsPerOp.size()) < kMaxReps) {
+            if (setup) {
+                setup();
+            }
+            auto start = Clock::now();
+            body();
+            auto ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            nsPerOp.push_back(ns / double(std::max(int64_t(1), nOps)));
+            totalSecs += ns / 1e9;
+        }
+        addResult(name, params, nOps, nsPerOp);
+    }
+
+    void addResult(const std::string& name, const std::string& params, int64_t nOps,
+                   std::vector<double> nsPerOp)
+    {
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        Result r = { name, params, nOps, int(nsPerOp.size()),
+                     nsPerOp[nsPerOp.size() / 2], nsPerOp.front() };
+        mResults.push_back(r);
+
+        std::cerr << std::left << std::setw(32) << r.name << std::setw(24) << r.params
+                  << std::right << std::setw(14) << std::fixed << std::setprecision(1)
+                  << r.nsPerOp << " ns/op" << std::endl;
+    }
+
+    std::string json() const
+    {
+        std::stringstream s;
+        s.precision(15);
+        s << "{\n  \"uitk_bench_version\": 1,\n  \"results\": [";
+        for (size_t i = 0;  i < mResults.size();  ++i) {
+            auto &r = mResults[i];
+            s << (i == 0 ? "\n" : ",\n")
+              << "    { \"name\": \"" << r.name << "\", \"params\": \"" << r.params
+              << "\", \"n_ops\": " << r.nOps << ", \"reps\": " << r.reps
+              << ", \"ns_per_op\": " << r.nsPerOp << ", \"min_ns_per_op\": " << r.minNsPerOp << " }";
+        }
+        s << "\n  ]\n}\n";
+        return s.str();
+    }
+
+private:
+    std::string mFilter;
+    double mMinSecs;
+    std::vector<Result> mResults;
+};
+
+// Defined in bench-timers.cpp
+void benchTimers(Bench& bench);
+
+#endif // UITK_BENCH_H
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+// Measures DeferredFunctions, which backs Application::scheduleLater(), with
+// many concurrent timers. Part of uitk-bench.
+
+#include "Bench.h"
+
+#include <uitk/private/PlatformUtils.h>
+
+#include <memory>
+#include <random>
+
+using namespace uitk;
+
+void benchTimers(Bench& bench)
+{
+    if (!bench.shouldRun("timers/")) {
+        return;
+    }
+
+    int nRun = 0;
+    auto callback = [&nRun](OSApplication::SchedulingId) { nRun += 1; };
+    for (size_t n : { 1000, 10000, 100000 }) {
+        auto params = "n=" + std::to_string(n);
+        std::unique_ptr<DeferredFunctions<int>> timers;
+        std::vector<OSApplication::SchedulingId> ids;
+
+        // Timers far in the future, like idle tooltips and autohide timers
+        auto addFarTimers = [&]() {
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<float> farDelays(60.0f, 3600.0f);
+            ids.clear();
+            for (size_t i = 0;  i < n;  ++i) {
+                ids.push_back(timers->add(int(i % 16), farDelays(rng), (i % 2 == 0), callback));
+            }
+        };
+        bench.run("timers/add", params, n, addFarTimers,
+                  [&]() { timers = std::make_unique<DeferredFunctions<int>>(); });
+
+        // The event loop calls these every time it wakes up
+        const int kNTicks = 10000;
+        bench.run("timers/tick-none-due", params, kNTicks, [&]() {
+            for (int i = 0;  i < kNTicks;  ++i) {
+                timers->executeTick();
+            }
+        });
+        bench.run("timers/next-time", params, kNTicks, [&]() {
+            Clock::time_point next;
+            for (int i = 0;  i < kNTicks;  ++i) {
+                timers->nextTime(&next);
+            }
+        });
+
+        bench.run("timers/remove", params, n / 2, [&]() {
+            for (size_t i = 0;  i < n / 2;  ++i) {
+                timers->remove(ids[i]);
+            }
+        }, [&]() {
+            timers = std::make_unique<DeferredFunctions<int>>();
+            addFarTimers();
+            std::shuffle(ids.begin(), ids.end(), std::mt19937(2));
+        });
+
+        // Timers that are all due, like many spinners animating at once.
+        // The clock is moved forward instead of sleeping.
+        auto now = std::make_shared<Clock::time_point>();
+        bool allRan = true;
+        bench.run("timers/tick-all-due", params, n, [&]() {
+            timers->executeTick();
+            allRan = allRan && (nRun == int(n));
+        }, [&]() {
+            timers = std::make_unique<DeferredFunctions<int>>();
+            *now = Clock::now();
+            timers->setClock([now]() { return *now; });
+            for (size_t i = 0;  i < n;  ++i) {
+                timers->add(int(i % 16), 0.001f, false, callback);
+            }
+            *now += std::chrono::seconds(1);
+            nRun = 0;
+        });
+        if (!allRan) {
+            std::cerr << "    [FAIL] timers/tick-all-due " << params
+                      << ": not every callback ran" << std::endl;
+        }
+    }
+}
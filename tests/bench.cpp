@@ -0,0 +1,480 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+// Repeatable microbenchmarks for tracking performance between releases.
+// Runs on the headless backend, so the results do not depend on the display,
+// and writes the results as JSON (to stdout, or to the file given by --out).
+// Run a release build; times are per operation, and each benchmark is
+// repeated until it has run for --min-time seconds, reporting the median
+// and the fastest repetition.
+//
+//    uitk-bench [--filter <substring>] [--out <path>] [--min-time <secs>]
+
+#include "Bench.h"
+
+#include <uitk/uitk.h>
+#include <uitk/IncDecWidget.h>
+#include <uitk/headless/HeadlessApplication.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace uitk;
+
+namespace {
+
+HeadlessApplication& headless()
+{
+    return static_cast<HeadlessApplication&>(Application::instance().osApplication());
+}
+
+std::unique_ptr<Window> makeWindow(Widget *content, int width = 800, int height = 600)
+{
+    auto w = std::make_unique<Window>("uitk-bench", 0, 0, width, height);
+    w->addChild(content);
+    w->show(true);
+    headless().processEvents();
+    return w;
+}
+
+void mouseMove(Window& w, const Point& p)
+{
+    MouseEvent e;
+    e.type = MouseEvent::Type::kMove;
+    e.pos = p;
+    e.keymods = 0;
+    headless().injectMouse(w, e);
+}
+
+std::string loremIpsum(size_t len)
+{
+    static const std::string kWords = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do "
+                                       "eiusmod tempor incididunt ut labore et dolore magna aliqua. ";
+    std::string s;
+    while (s.size() < len) {
+        s += kWords;
+    }
+    s.resize(len);
+    return s;
+}
+
+// Alternates between two window sizes, so that every op is a full layout.
+void benchResizeLayout(Bench& bench, const std::string& params, Widget *root)
+{
+    auto win = makeWindow(root);
+    int i = 0;
+    bench.run("layout/resize", params, 1, [&win, &i]() {
+        headless().injectResize(*win, 800 + (i++ % 2), 600);
+    });
+}
+
+void benchLayouts(Bench& bench)
+{
+    if (!bench.shouldRun("layout/")) {
+        return;
+    }
+
+    // Deep: alternating VLayouts and HLayouts, each with a label and the next level
+    for (int depth : { 16, 64 }) {
+        Layout1D *root = new VLayout();
+        Layout1D *parent = root;
+        for (int d = 1;  d < depth;  ++d) {
+            Layout1D *child = ((d % 2) ? (Layout1D*)new HLayout() : (Layout1D*)new VLayout());
+            parent->addChild(new Label("Level " + std::to_string(d)));
+            parent->addChild(child);
+            parent = child;
+        }
+        benchResizeLayout(bench, "tree=deep,depth=" + std::to_string(depth), root);
+    }
+
+    // Wide: one layout with many children
+    for (int n : { 100, 1000, 10000 }) {
+        auto *root = new VLayout();
+        for (int i = 0;  i < n;  ++i) {
+            root->addChild(new Label("Item " + std::to_string(i)));
+        }
+        benchResizeLayout(bench, "tree=wide,n=" + std::to_string(n), root);
+    }
+
+    for (int n : { 10, 30, 100 }) {
+        auto *grid = new GridLayout();
+        for (int r = 0;  r < n;  ++r) {
+            for (int c = 0;  c < n;  ++c) {
+                grid->addChild(new Label(std::to_string(r) + "," + std::to_string(c)), r, c);
+            }
+        }
+        benchResizeLayout(bench, "tree=grid,n=" + std::to_string(n) + "x" + std::to_string(n), grid);
+    }
+}
+
+void benchListView(Bench& bench)
+{
+    if (!bench.shouldRun("listview/")) {
+        return;
+    }
+
+    for (int nRows : { 10000, 100000, 1000000 }) {
+        auto *lv = new ListView();
+        ListView::DataSource source;
+        source.nRows = [nRows]() { return nRows; };
+        source.makeCell = []() { return new Label(""); };
+        source.bindCell = [](ListViewCell *cell, int row) {
+            static_cast<Label*>(cell)->setText("Row " + std::to_string(row));
+        };
+        // Varying heights, so that the row offsets need the index
+        source.rowHeight = [](int row) { return PicaPt(14.0f + float(row % 3) * 4.0f); };
+        lv->setDataSource(source);
+        auto win = makeWindow(lv);
+        auto params = "rows=" + std::to_string(nRows);
+
+        bench.run("listview/reload", params, 1, [lv]() {
+            lv->reloadData();
+            headless().processEvents();
+        });
+
+        std::mt19937 rng(1);
+        bench.run("listview/scroll", params, 1, [lv, &rng]() {
+            auto maxY = std::max(1.0f, (lv->bounds().height - lv->frame().height).asFloat());
+            std::uniform_real_distribution<float> dist(0.0f, maxY);
+            lv->scrollTo(PicaPt::kZero, PicaPt(dist(rng)));
+            headless().processEvents();
+        });
+    }
+}
+
+void benchText(Bench& bench)
+{
+    if (!bench.shouldRun("text/")) {
+        return;
+    }
+
+    auto *label = new Label("");
+    auto *wrapped = new Label("");
+    wrapped->setWordWrapEnabled(true);
+    auto *edit = new StringEdit();
+    auto win = makeWindow(new VLayout({ label, wrapped, edit }));
+    auto &theme = *Application::instance().theme();
+    auto dc = headless().windowBitmap(*win);
+    LayoutContext context{ theme, *dc };
+
+    for (size_t len : { 10, 100, 1000 }) {
+        auto params = "len=" + std::to_string(len);
+        // Alternate the text so that each op has to lay it out again
+        std::vector<std::string> texts = { loremIpsum(len), loremIpsum(len - 1) + "." };
+        int i = 0;
+        bench.run("text/label-layout", params, 1, [&]() {
+            label->setText(texts[i++ % 2]);
+            label->cachedPreferredSize(context);
+        });
+        bench.run("text/label-wordwrap", params, 1, [&]() {
+            wrapped->setText(texts[i++ % 2]);
+            wrapped->cachedPreferredSize(context.withWidth(PicaPt(300.0f)));
+        });
+        bench.run("text/stringedit-settext", params, 1, [&]() {
+            edit->setText(texts[i++ % 2]);
+            headless().processEvents();  // StringEdit lays out when it draws
+        });
+    }
+}
+
+void benchDraw(Bench& bench)
+{
+    if (!bench.shouldRun("draw/")) {
+        return;
+    }
+
+    auto *combo = new ComboBox();
+    combo->addItem("Item 1")->addItem("Item 2");
+    auto *progress = new ProgressBar();
+    progress->setValue(50.0f);
+    auto *list = new ListView();
+    for (int i = 0;  i < 10;  ++i) {
+        list->addStringCell("Cell " + std::to_string(i));
+    }
+    auto *numberEdit = new NumberEdit();
+    numberEdit->setValue(42);
+    auto *stringEdit = new StringEdit();
+    stringEdit->setText("Some editable text");
+    std::vector<std::pair<std::string, Widget*>> widgets = {
+        { "Button", new Button("Button") },
+        { "Checkbox", new Checkbox("Checkbox") },
+        { "ColorEdit", new ColorEdit() },
+        { "ComboBox", combo },
+        { "IncDecWidget", new IncDecWidget() },
+        { "Label", new Label("Label") },
+        { "ListView", list },
+        { "NumberEdit", numberEdit },
+        { "ProgressBar", progress },
+        { "RadioButton", new RadioButton("Radio") },
+        { "SearchBar", new SearchBar() },
+        { "SegmentedControl", new SegmentedControl({ "One", "Two", "Three" }) },
+        { "Slider", new Slider() },
+        { "StringEdit", stringEdit },
+    };
+    auto *layout = new VLayout();
+    for (auto &w : widgets) {
+        layout->addChild(w.second);
+    }
+    auto win = makeWindow(layout);
+    auto &theme = *Application::instance().theme();
+    auto dc = headless().windowBitmap(*win);
+
+    const int kNDrawsPerOp = 100;
+    for (auto &w : widgets) {
+        auto *widget = w.second;
+        bench.run("draw/" + w.first, "", kNDrawsPerOp, [&]() {
+            UIContext context{ theme, *dc, widget->bounds(), true };
+            dc->beginDraw();
+            for (int i = 0;  i < kNDrawsPerOp;  ++i) {
+                widget->draw(context);
+            }
+            dc->endDraw();
+        });
+    }
+}
+
+void benchEvents(Bench& bench)
+{
+    if (!bench.shouldRun("events/")) {
+        return;
+    }
+
+    // A plain Widget sets its children's frames to its bounds, so the mouse
+    // is over every level of the tree.
+    for (int depth : { 8, 64, 256 }) {
+        auto *root = new Widget();
+        auto *parent = root;
+        for (int d = 1;  d < depth;  ++d) {
+            auto *child = new Widget();
+            parent->addChild(child);
+            parent = child;
+        }
+        auto win = makeWindow(root);
+
+        const int kNMovesPerOp = 100;
+        bench.run("events/mouse-move", "depth=" + std::to_string(depth), kNMovesPerOp, [&]() {
+            for (int i = 0;  i < kNMovesPerOp;  ++i) {
+                mouseMove(*win, Point(PicaPt(50.0f + float(i % 2)), PicaPt(50.0f)));
+            }
+        });
+    }
+}
+
+// Lays out nothing, so that the children keep the frames they are given.
+class Canvas : public Widget
+{
+};
+
+void benchHitTesting(Bench& bench)
+{
+    if (!bench.shouldRun("events/")) {
+        return;
+    }
+
+    // Many small children scattered over the window, like the items of a
+    // diagram editor.
+    for (bool indexed : { false, true }) {
+        for (int n : { 1000, 10000 }) {
+            auto *canvas = new Canvas();
+            canvas->setUsesHitTestIndex(indexed);
+            std::mt19937 rng(1);
+            std::uniform_real_distribution<float> pos(0.0f, 550.0f);
+            for (int i = 0;  i < n;  ++i) {
+                auto *item = new Widget();
+                item->setFrame(Rect(PicaPt(pos(rng)), PicaPt(pos(rng) * 0.75f), PicaPt(20.0f), PicaPt(10.0f)));
+                canvas->addChild(item);
+            }
+            auto win = makeWindow(canvas);
+
+            const int kNMovesPerOp = 100;
+            bench.run("events/mouse-move-canvas",
+                      std::string(indexed ? "index=on" : "index=off") + ",n=" + std::to_string(n),
+                      kNMovesPerOp, [&]() {
+                for (int i = 0;  i < kNMovesPerOp;  ++i) {
+                    mouseMove(*win, Point(PicaPt(float(5 * i % 550)), PicaPt(float(3 * i % 400))));
+                }
+            });
+        }
+    }
+}
+
+void benchDrawingCache(Bench& bench)
+{
+    if (!bench.shouldRun("draw/")) {
+        return;
+    }
+
+    // A chart-like subtree of many small widgets that does not change
+    for (std::string cached : { "no", "image", "recorded" }) {
+        auto *chart = new Canvas();
+        chart->setCachesDrawing(cached == "image");
+        chart->setRecordsDrawing(cached == "recorded");
+        for (int i = 0;  i < 1000;  ++i) {
+            auto *bar = new Widget();
+            bar->setBackgroundColor(Color(0.2f, 0.4f, 0.8f));
+            bar->setFrame(Rect(PicaPt(float(i % 100) * 5.0f), PicaPt(float(i / 100) * 30.0f),
+                               PicaPt(4.0f), PicaPt(float(5 + i % 20))));
+            chart->addChild(bar);
+        }
+        auto *root = new Widget();
+        root->addChild(chart);
+        auto win = makeWindow(root);
+        auto &theme = *Application::instance().theme();
+        auto dc = headless().windowBitmap(*win);
+
+        bench.run("draw/static-subtree", "cached=" + cached, 1, [&]() {
+            UIContext context{ theme, *dc, root->bounds(), true };
+            dc->beginDraw();
+            root->draw(context);
+            dc->endDraw();
+        });
+    }
+}
+
+void benchFileLines(Bench& bench)
+{
+    if (!bench.shouldRun("file/")) {
+        return;
+    }
+
+    for (size_t nLines : { 100000, 1000000 }) {
+        File file(Application::instance().tempDir() + "/uitk-bench-lines.txt");
+        {
+            std::string contents;
+            auto line = loremIpsum(60);
+            contents.reserve(nLines * (line.size() + 1));
+            for (size_t i = 0;  i < nLines;  ++i) {
+                contents += line;
+                contents += ((i % 2) ? "\r\n" : "\n");
+            }
+            file.writeContents(contents);
+        }
+        auto params = "lines=" + std::to_string(nLines);
+
+        uint64_t nBytes = 0;
+        bench.run("file/lines", params, int64_t(nLines), [&]() {
+            IOError::Error err;
+            for (auto it = file.readLines(&err).begin();  it != File::Lines::Iterator();  ++it) {
+                nBytes += it.len;
+            }
+        });
+        bench.run("file/lines-copy", params, int64_t(nLines), [&]() {
+            IOError::Error err;
+            for (auto line : file.readLines(&err)) {
+                nBytes += line.size();
+            }
+        });
+        file.remove();
+    }
+}
+
+// Records a sweep of the mouse over the widgets panel, and then replays it
+// at maximum speed. Each op is one replayed event (and the frame it caused).
+void benchReplay(Bench& bench)
+{
+    if (!bench.shouldRun("replay/")) {
+        return;
+    }
+
+    auto *layout = new VLayout();
+    for (int i = 0;  i < 20;  ++i) {
+        layout->addChild(new HLayout({ new Button("Button " + std::to_string(i)),
+                                       new Checkbox("Checkbox"),
+                                       new Slider() }));
+    }
+    auto win = makeWindow(layout);
+
+    auto &instr = Application::instance().instrumentation();
+    instr.startRecordingInput();
+    for (int y = 0;  y < 600;  y += 3) {
+        mouseMove(*win, Point(PicaPt(float(2 * y % 400)), PicaPt(float(y))));
+        headless().advanceTime(1.0 / 60.0);
+    }
+    auto trace = instr.stopRecordingInput();
+    trace.deserialize(trace.serialized());  // make sure the file format round-trips
+
+    InputReplayer replayer(trace);
+    bench.run("replay/mouse-sweep", "events=" + std::to_string(trace.events.size()),
+              int64_t(trace.events.size()), [&]() {
+        replayer.start(InputReplayer::Speed::kMaximum, nullptr);
+        while (replayer.isReplaying()) {
+            headless().processEvents();
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    std::string outPath;
+    double minSecs = 0.25;
+    for (int i = 1;  i < argc;  ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSecs = atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--out <path>] [--min-time <secs>]" << std::endl;
+            return 1;
+        }
+    }
+
+    HeadlessApplication::setRequested(true);
+    Application app;
+
+    Bench bench(filter, minSecs);
+    benchLayouts(bench);
+    benchListView(bench);
+    benchText(bench);
+    benchDraw(bench);
+    benchEvents(bench);
+    benchHitTesting(bench);
+    benchDrawingCache(bench);
+    benchTimers(bench);
+    benchFileLines(bench);
+    benchReplay(bench);
+
+    if (outPath.empty()) {
+        std::cout << bench.json();
+    } else {
+        std::ofstream out(outPath);
+        out << bench.json();
+        if (!out) {
+            std::cerr << "Could not write '" << outPath << "'" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
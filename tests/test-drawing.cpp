@@ -0,0 +1,327 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 - 2023 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+// Tests that need to draw. These use the headless backend, which has a fixed
+// DPI, so they are separate from the tests in test.cpp, which should use the
+// platform's real backend.
+
+#include <uitk/uitk.h>
+#include <uitk/headless/HeadlessApplication.h>
+
+#include "TestCase.h"
+
+using namespace uitk;
+
+//-----------------------------------------------------------------------------
+// These draw through the headless backend (which main() requests), so that
+// the drawing caches are used the same way that a real window uses them.
+class DrawingCacheTest : public TestCase
+{
+public:
+    class CountingWidget : public Widget
+    {
+        using Super = Widget;
+    public:
+        explicit CountingWidget(const Color& c) : mColor(c) {}
+
+        int nDraws = 0;
+
+        // Like a widget that updates its appearance when it is laid out,
+        // this only requests a layout, not a draw.
+        void setColorAtNextLayout(const Color& c)
+        {
+            mNextColor = c;
+            mHasNextColor = true;
+            setNeedsLayout();
+        }
+
+        void layout(const LayoutContext& context) override
+        {
+            if (mHasNextColor) {
+                mColor = mNextColor;
+                mHasNextColor = false;
+            }
+            Super::layout(context);
+        }
+
+        void draw(UIContext& context) override
+        {
+            ++nDraws;
+            context.dc.setFillColor(mColor);
+            context.dc.drawRect(bounds(), kPaintFill);
+            Super::draw(context);
+        }
+
+    private:
+        Color mColor;
+        Color mNextColor;
+        bool mHasNextColor = false;
+    };
+
+    DrawingCacheTest(const std::string& name) : TestCase(name) {}
+
+protected:
+    const Color kRed = Color(1.0f, 0.0f, 0.0f);
+    const Color kGreen = Color(0.0f, 1.0f, 0.0f);
+    const Color kBlue = Color(0.0f, 0.0f, 1.0f);
+
+    HeadlessApplication& headless() const
+    {
+        return static_cast<HeadlessApplication&>(Application::instance().osApplication());
+    }
+
+    // Damages the whole window, which does not invalidate any caches itself.
+    void redraw(Window& win) const
+    {
+        win.setNeedsDraw();
+        headless().processEvents();
+    }
+
+    std::string checkPixel(Window& win, int x, int y, const Color& expected,
+                           const std::string& when) const
+    {
+        auto got = headless().windowBitmap(win)->pixelAt(x, y);
+        if (got.toRGBA() != expected.toRGBA()) {
+            return makeError(when + ": pixel (" + std::to_string(x) + ", " + std::to_string(y) + ") RGBA",
+                             got.toRGBA(), expected.toRGBA());
+        }
+        return "";
+    }
+
+    std::string checkRedrawn(const CountingWidget *w, int nDrawsBefore, const std::string& when) const
+    {
+        if (w->nDraws == nDrawsBefore) {
+            return when + ": cached drawing was reused";
+        }
+        return "";
+    }
+};
+
+class CachedDrawingInvalidationTest : public DrawingCacheTest
+{
+public:
+    CachedDrawingInvalidationTest() : DrawingCacheTest("cached drawing invalidation") {}
+
+    std::string run() override
+    {
+        Window win("test", 0, 0, 100, 100);
+        auto dpi = headless().windowBitmap(win)->dpi();
+        auto *parent = new CountingWidget(kBlue);
+        parent->setCachesDrawing(true);
+        auto *child = new CountingWidget(kRed);
+        child->setFrame(Rect::fromPixels(0.0f, 0.0f, 10.0f, 10.0f, dpi));
+        parent->addChild(child);
+        win.addChild(parent);
+        win.show(true);
+        headless().processEvents();
+
+        std::string err;
+        auto n = parent->nDraws;
+        redraw(win);
+        if (parent->nDraws != n) {
+            return "cached drawing was not reused";
+        }
+        if (!(err = checkPixel(win, 5, 5, kRed, "initial")).empty()) { return err; }
+        if (!(err = checkPixel(win, 15, 5, kBlue, "initial")).empty()) { return err; }
+
+        n = parent->nDraws;
+        child->setFrame(Rect::fromPixels(20.0f, 0.0f, 10.0f, 10.0f, dpi));
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "setFrame()")).empty()) { return err; }
+        if (!(err = checkPixel(win, 5, 5, kBlue, "setFrame()")).empty()) { return err; }
+        if (!(err = checkPixel(win, 25, 5, kRed, "setFrame()")).empty()) { return err; }
+
+        n = parent->nDraws;
+        parent->removeChild(child);
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "removeChild()")).empty()) { delete child; return err; }
+        if (!(err = checkPixel(win, 25, 5, kBlue, "removeChild()")).empty()) { delete child; return err; }
+
+        n = parent->nDraws;
+        parent->addChild(child);
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "addChild()")).empty()) { return err; }
+        if (!(err = checkPixel(win, 25, 5, kRed, "addChild()")).empty()) { return err; }
+
+        n = parent->nDraws;
+        parent->removeAllChildren();
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "removeAllChildren()")).empty()) { delete child; return err; }
+        if (!(err = checkPixel(win, 25, 5, kBlue, "removeAllChildren()")).empty()) { delete child; return err; }
+
+        n = parent->nDraws;
+        parent->insertChildren(0, { child });
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "insertChildren()")).empty()) { return err; }
+        if (!(err = checkPixel(win, 25, 5, kRed, "insertChildren()")).empty()) { return err; }
+
+        n = parent->nDraws;
+        child->setColorAtNextLayout(kGreen);
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "setNeedsLayout()")).empty()) { return err; }
+        if (!(err = checkPixel(win, 25, 5, kGreen, "setNeedsLayout()")).empty()) { return err; }
+
+        return "";
+    }
+};
+
+//-----------------------------------------------------------------------------
+class RecordedDrawingReplayTest : public DrawingCacheTest
+{
+public:
+    RecordedDrawingReplayTest() : DrawingCacheTest("recorded drawing replay") {}
+
+    class CountingLabel : public Label
+    {
+        using Super = Label;
+    public:
+        explicit CountingLabel(const std::string& text) : Label(text) {}
+
+        int nDraws = 0;
+
+        void draw(UIContext& context) override
+        {
+            ++nDraws;
+            Super::draw(context);
+        }
+    };
+
+    // The text layout only lives as long as the recording it is drawn into.
+    class TemporaryTextWidget : public CountingWidget
+    {
+        using Super = CountingWidget;
+    public:
+        explicit TemporaryTextWidget(const Color& bg) : CountingWidget(bg) {}
+
+        void draw(UIContext& context) override
+        {
+            Super::draw(context);
+            auto layout = context.dc.createTextLayout("Text", context.theme.params().labelFont,
+                                                      Color(0.0f, 0.0f, 0.0f));
+            context.dc.drawText(*layout, Point::kZero);
+        }
+    };
+
+    std::string run() override
+    {
+        Window win("test", 0, 0, 100, 100);
+        auto dpi = headless().windowBitmap(win)->dpi();
+        // The window's root widget sizes its children to fill it, so put
+        // everything in a holder that leaves the frames alone.
+        auto *holder = new CountingWidget(kGreen);
+        auto *parent = new CountingWidget(kBlue);
+        parent->setFrame(Rect::fromPixels(0.0f, 0.0f, 100.0f, 30.0f, dpi));
+        auto *child = new Label("Child");
+        child->setFrame(Rect::fromPixels(0.0f, 0.0f, 60.0f, 20.0f, dpi));
+        parent->addChild(child);
+        auto *label = new CountingLabel("Label");
+        label->setFrame(Rect::fromPixels(0.0f, 40.0f, 60.2f, 20.0f, dpi));
+        holder->addChild(parent);
+        holder->addChild(label);
+        win.addChild(holder);
+        win.show(true);
+        headless().processEvents();
+
+        // A label makes its layout the first time it draws, so recordings
+        // that start after that only borrow the layouts.
+        parent->setRecordsDrawing(true);
+        label->setRecordsDrawing(true);
+        redraw(win);
+
+        std::string err;
+        auto n = parent->nDraws;
+        auto nLabel = label->nDraws;
+        redraw(win);
+        if (parent->nDraws != n || label->nDraws != nLabel) {
+            return "recording was not replayed";
+        }
+
+        // Resizing a label releases its layout, so replaying a recording
+        // that refers to it would use freed memory.
+        n = parent->nDraws;
+        child->setFrame(Rect::fromPixels(0.0f, 0.0f, 70.0f, 20.0f, dpi));
+        redraw(win);
+        if (!(err = checkRedrawn(parent, n, "child resized")).empty()) { return err; }
+
+        // Same size in whole pixels, but the layout is released all the same.
+        nLabel = label->nDraws;
+        label->setFrame(Rect::fromPixels(0.0f, 40.0f, 60.4f, 20.0f, dpi));
+        redraw(win);
+        if (label->nDraws == nLabel) {
+            return "sub-pixel resize: recording was replayed";
+        }
+
+        // When an inner recording is replayed while the outer one records,
+        // the outer one only borrows the inner one's text layouts.
+        auto *outer = new CountingWidget(kBlue);
+        outer->setFrame(Rect::fromPixels(0.0f, 70.0f, 100.0f, 30.0f, dpi));
+        outer->setRecordsDrawing(true);
+        auto *inner = new TemporaryTextWidget(kRed);
+        inner->setFrame(Rect::fromPixels(0.0f, 0.0f, 100.0f, 30.0f, dpi));
+        inner->setRecordsDrawing(true);
+        outer->addChild(inner);
+        holder->addChild(outer);
+        redraw(win);
+        auto nInner = inner->nDraws;
+        outer->setNeedsDraw();
+        redraw(win);
+        if (inner->nDraws != nInner) {
+            return "nested: inner recording was not replayed";
+        }
+
+        n = outer->nDraws;
+        inner->setRecordsDrawing(false);  // frees the layouts outer borrowed
+        redraw(win);
+        if (!(err = checkRedrawn(outer, n, "nested: inner stopped recording")).empty()) { return err; }
+
+        return "";
+    }
+};
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    HeadlessApplication::setRequested(true);
+    Application app;
+
+    std::vector<std::shared_ptr<TestCase>> tests = {
+        std::make_shared<CachedDrawingInvalidationTest>(),
+        std::make_shared<RecordedDrawingReplayTest>(),
+    };
+
+    int nPass = 0, nFail = 0;
+    for (auto t : tests) {
+        if (t->runTest()) {
+            nPass++;
+        } else {
+            nFail++;
+        }
+    }
+
+    if (nFail == 0) {
+        std::cout << "All tests passed!" << std::endl;
+        return 0;
+    } else {
+        std::cout << nFail << " test" << (nFail == 1 ? "" : "s") << " failed" << std::endl;
+        return nFail;
+    }
+}
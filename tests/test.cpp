@@ -21,9 +21,14 @@
 //-----------------------------------------------------------------------------
 
 #include <uitk/uitk.h>
+#include <uitk/private/HitTestGrid.h>
+#include <uitk/private/IndexRangeSet.h>
+#include <uitk/private/RowHeightIndex.h>
 
 #include "TestCase.h"
 
+#include <random>
+#include <set>
 #include <sstream>
 
 using namespace uitk;
@@ -983,6 +988,500 @@ public:
     }
 };
 
+//-----------------------------------------------------------------------------
+// Compares IndexRangeSet against a std::set<int> after each of a long,
+// deterministic sequence of random operations.
+class IndexRangeSetTest : public TestCase
+{
+public:
+    IndexRangeSetTest() : TestCase("IndexRangeSet") {}
+
+    std::string run() override
+    {
+        // Hand-checked cases first, since they give more readable failures
+        IndexRangeSet s;
+        s.insert(5, 10);
+        s.insert(10, 12);  // adjacent ranges merge
+        s.insert(20);
+        auto err = checkRanges("insert", s, { {5, 12}, {20, 21} });
+        if (!err.empty()) { return err; }
+        s.erase(7, 9);
+        err = checkRanges("erase", s, { {5, 7}, {9, 12}, {20, 21} });
+        if (!err.empty()) { return err; }
+        s.invert(6, 10);
+        err = checkRanges("invert", s, { {5, 6}, {7, 9}, {10, 12}, {20, 21} });
+        if (!err.empty()) { return err; }
+        s.insertGap(8, 3);
+        err = checkRanges("insertGap", s, { {5, 6}, {7, 8}, {11, 12}, {13, 15}, {23, 24} });
+        if (!err.empty()) { return err; }
+        s.removeGap(6, 13);
+        err = checkRanges("removeGap", s, { {5, 8}, {16, 17} });
+        if (!err.empty()) { return err; }
+        auto clipped = s.ranges(6, 17);
+        if (clipped.size() != 2 || clipped[0].first != 6 || clipped[0].end != 8
+            || clipped[1].first != 16 || clipped[1].end != 17) {
+            return "ranges(first, end) did not clip correctly";
+        }
+
+        std::mt19937 rng(1);
+        const int kMax = 100;
+        auto randIdx = [&rng, kMax]() { return int(rng() % kMax); };
+        s.clear();
+        std::set<int> ref;
+        for (int i = 0;  i < 5000;  ++i) {
+            int a = randIdx(), b = randIdx();
+            if (a > b) { std::swap(a, b); }
+            std::string op;
+            switch (rng() % 5) {
+                case 0:
+                    op = "insert";
+                    s.insert(a, b);
+                    for (int j = a;  j < b;  ++j) { ref.insert(j); }
+                    break;
+                case 1:
+                    op = "erase";
+                    s.erase(a, b);
+                    for (int j = a;  j < b;  ++j) { ref.erase(j); }
+                    break;
+                case 2:
+                    op = "invert";
+                    s.invert(a, b);
+                    for (int j = a;  j < b;  ++j) {
+                        if (!ref.erase(j)) { ref.insert(j); }
+                    }
+                    break;
+                case 3: {
+                    op = "insertGap";
+                    int n = b - a;
+                    s.insertGap(a, n);
+                    std::set<int> next;
+                    for (int j : ref) { next.insert(j >= a ? j + n : j); }
+                    ref.swap(next);
+                    break;
+                }
+                case 4: {
+                    op = "removeGap";
+                    s.removeGap(a, b);
+                    std::set<int> next;
+                    for (int j : ref) {
+                        if (j < a) { next.insert(j); }
+                        else if (j >= b) { next.insert(j - (b - a)); }
+                    }
+                    ref.swap(next);
+                    break;
+                }
+            }
+            op += "(" + std::to_string(a) + ", " + std::to_string(b) + ")";
+            err = checkSet(op, s, ref, 2 * kMax);
+            if (!err.empty()) {
+                return err;
+            }
+        }
+        return "";
+    }
+
+private:
+    std::string checkRanges(const std::string& op, const IndexRangeSet& s,
+                            const std::vector<IndexRangeSet::Range>& expected)
+    {
+        auto got = s.ranges();
+        if (got.size() != expected.size()) {
+            return makeError(op + ": number of ranges", got.size(), expected.size());
+        }
+        for (size_t i = 0;  i < got.size();  ++i) {
+            if (got[i].first != expected[i].first || got[i].end != expected[i].end) {
+                return op + ": got range [" + std::to_string(got[i].first) + ", "
+                       + std::to_string(got[i].end) + "), expected ["
+                       + std::to_string(expected[i].first) + ", "
+                       + std::to_string(expected[i].end) + ")";
+            }
+        }
+        return "";
+    }
+
+    std::string checkSet(const std::string& op, const IndexRangeSet& s,
+                         const std::set<int>& ref, int maxIdx)
+    {
+        if (s.count() != int(ref.size())) {
+            return makeError(op + ": count()", s.count(), ref.size());
+        }
+        if (s.empty() != ref.empty()) {
+            return op + ": empty() is wrong";
+        }
+        int first = (ref.empty() ? -1 : *ref.begin());
+        if (s.first() != first) {
+            return op + ": first(): got " + std::to_string(s.first()) + ", expected "
+                   + std::to_string(first);
+        }
+        for (int i = 0;  i < maxIdx;  ++i) {
+            if (s.contains(i) != (ref.count(i) != 0)) {
+                return op + ": contains(" + std::to_string(i) + ") is wrong";
+            }
+        }
+        // ranges() must be sorted, non-empty, non-overlapping, and
+        // non-adjacent, and cover exactly the members.
+        std::set<int> fromRanges;
+        int lastEnd = -1;
+        for (auto &r : s.ranges()) {
+            if (r.first >= r.end || r.first <= lastEnd) {
+                return op + ": ranges() are not normalized";
+            }
+            for (int i = r.first;  i < r.end;  ++i) { fromRanges.insert(i); }
+            lastEnd = r.end;
+        }
+        if (fromRanges != ref) {
+            return op + ": ranges() do not match the members";
+        }
+        return "";
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Compares RowHeightIndex against prefix sums recomputed after every change.
+// The heights are whole numbers so that the sums are exact.
+class RowHeightIndexTest : public TestCase
+{
+public:
+    RowHeightIndexTest() : TestCase("RowHeightIndex") {}
+
+    std::string run() override
+    {
+        std::mt19937 rng(1);
+        RowHeightIndex index;
+        std::vector<float> heights;
+
+        index.reset(0, [](int) { return PicaPt::kZero; });
+        auto err = check("empty", index, heights);
+        if (!err.empty()) {
+            return err;
+        }
+
+        // Sizes around powers of two exercise the edges of the tree
+        for (int n : { 1, 2, 3, 7, 8, 9, 100 }) {
+            heights.clear();
+            for (int i = 0;  i < n;  ++i) {
+                heights.push_back(float(rng() % 20));  // includes zero-height rows
+            }
+            index.reset(n, [&heights](int row) { return PicaPt(heights[row]); });
+            auto op = "reset(" + std::to_string(n) + ")";
+            err = check(op, index, heights);
+            if (!err.empty()) {
+                return err;
+            }
+
+            for (int i = 0;  i < 2 * n;  ++i) {
+                int row = int(rng() % n);
+                heights[row] = float(rng() % 20);
+                index.setHeight(row, PicaPt(heights[row]));
+                err = check(op + ", setHeight(" + std::to_string(row) + ")", index, heights);
+                if (!err.empty()) {
+                    return err;
+                }
+            }
+        }
+
+        index.clear();
+        if (index.size() != 0 || index.totalHeight() != PicaPt::kZero) {
+            return "clear() did not empty the index";
+        }
+        return "";
+    }
+
+private:
+    std::string check(const std::string& op, const RowHeightIndex& index,
+                      const std::vector<float>& heights)
+    {
+        int n = int(heights.size());
+        if (index.size() != n) {
+            return makeError(op + ": size()", index.size(), n);
+        }
+        std::vector<float> offsets(1, 0.0f);
+        for (auto h : heights) {
+            offsets.push_back(offsets.back() + h);
+        }
+        for (int row = 0;  row <= n;  ++row) {
+            if (row < n && index.height(row).asFloat() != heights[row]) {
+                return op + ": height(" + std::to_string(row) + ") is wrong";
+            }
+            if (index.offset(row).asFloat() != offsets[row]) {
+                return op + ": offset(" + std::to_string(row) + "): got "
+                       + std::to_string(index.offset(row).asFloat()) + ", expected "
+                       + std::to_string(offsets[row]);
+            }
+        }
+        if (index.totalHeight().asFloat() != offsets[n]) {
+            return op + ": totalHeight() is wrong";
+        }
+
+        // rowAt(y) is the last row whose offset is <= y, or -1 / size() when
+        // y is out of range. Check on, between, and outside the offsets.
+        for (float y = -1.0f;  y <= offsets[n] + 1.0f;  y += 0.5f) {
+            int expected;
+            if (y < 0.0f) {
+                expected = -1;
+            } else if (y >= offsets[n]) {
+                expected = n;
+            } else {
+                expected = 0;
+                while (expected + 1 < n && offsets[expected + 1] <= y) {
+                    ++expected;
+                }
+            }
+            auto got = index.rowAt(PicaPt(y));
+            if (got != expected) {
+                return op + ": rowAt(" + std::to_string(y) + "): got " + std::to_string(got)
+                       + ", expected " + std::to_string(expected);
+            }
+        }
+        return "";
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Compares HitTestGrid against checking every rectangle, for both small and
+// large (grid-spanning) overlapping rectangles and for points on their edges.
+class HitTestGridTest : public TestCase
+{
+public:
+    HitTestGridTest() : TestCase("HitTestGrid") {}
+
+    std::string run() override
+    {
+        HitTestGrid grid;
+        std::vector<int> got;
+        grid.reset({});
+        grid.indicesAt(Point(PicaPt(1.0f), PicaPt(1.0f)), &got);
+        if (!got.empty()) {
+            return "empty grid returned a hit";
+        }
+
+        std::mt19937 rng(1);
+        auto coord = [&rng](int max) { return PicaPt(float(rng() % max)); };
+        for (int n : { 1, 2, 10, 100, 500 }) {
+            std::vector<Rect> rects;
+            for (int i = 0;  i < n;  ++i) {
+                bool isLarge = (rng() % 10 == 0);
+                int maxSize = (isLarge ? 500 : 30);
+                rects.emplace_back(coord(500), coord(500),
+                                   PicaPt(1.0f) + coord(maxSize), PicaPt(1.0f) + coord(maxSize));
+            }
+            grid.reset(rects);
+
+            std::vector<Point> points;
+            for (int i = 0;  i < 500;  ++i) {
+                points.emplace_back(coord(600) - PicaPt(50.0f), coord(600) - PicaPt(50.0f));
+            }
+            for (auto &r : rects) {
+                points.emplace_back(r.x, r.y);
+                points.emplace_back(r.maxX(), r.maxY());
+                points.emplace_back(r.midX(), r.midY());
+            }
+
+            for (auto &p : points) {
+                std::vector<int> expected;
+                for (int i = 0;  i < int(rects.size());  ++i) {
+                    if (rects[i].contains(p)) {
+                        expected.push_back(i);
+                    }
+                }
+                grid.indicesAt(p, &got);
+                if (got != expected) {
+                    std::stringstream err;
+                    err << n << " rects: indicesAt(" << p.x.asFloat() << ", " << p.y.asFloat()
+                        << ") returned " << got.size() << " hits, expected " << expected.size();
+                    return err.str();
+                }
+            }
+        }
+
+        grid.clear();
+        grid.indicesAt(Point(PicaPt(1.0f), PicaPt(1.0f)), &got);
+        if (!got.empty()) {
+            return "clear() did not empty the grid";
+        }
+        return "";
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Checks that InputTrace::deserialize(serialized()) reproduces every field
+// that is recorded, for each kind of event, and rejects damaged data. The
+// values are exactly representable as floats and the times are whole
+// microseconds, since that is the precision of the format.
+class InputTraceTest : public TestCase
+{
+public:
+    InputTraceTest() : TestCase("InputTrace round trip") {}
+
+    std::string run() override
+    {
+        InputTrace trace;
+        trace.windows.push_back({ "Main", Size(PicaPt(640.0f), PicaPt(480.0f)), 96.0f });
+        trace.windows.push_back({ "Popup \xe2\x9c\x93", Size(PicaPt(120.5f), PicaPt(300.0f)), 144.0f });
+
+        trace.events.reserve(8);  // addMouse() returns a reference into events
+        auto addMouse = [&trace](double time, MouseEvent::Type type) -> MouseEvent& {
+            trace.events.emplace_back();
+            auto &e = trace.events.back();
+            e.type = InputTrace::Event::Type::kMouse;
+            e.time = time;
+            e.window = 0;
+            e.mouse.type = type;
+            e.mouse.pos = Point(PicaPt(10.25f), PicaPt(-3.5f));
+            e.mouse.keymods = KeyModifier::kShift | KeyModifier::kCtrl;
+            return e.mouse;
+        };
+        addMouse(0.0, MouseEvent::Type::kMove);
+        auto &down = addMouse(0.25, MouseEvent::Type::kButtonDown);
+        down.button.button = MouseButton::kLeft;
+        down.button.nClicks = 2;
+        auto &drag = addMouse(0.5, MouseEvent::Type::kDrag);
+        drag.drag.buttons = int(MouseButton::kLeft) | int(MouseButton::kRight);
+        auto &up = addMouse(0.75, MouseEvent::Type::kButtonUp);
+        up.button.button = MouseButton::kRight;
+        up.button.nClicks = 1;
+        auto &scroll = addMouse(1.0, MouseEvent::Type::kScroll);
+        scroll.scroll.dx = PicaPt(-12.0f);
+        scroll.scroll.dy = PicaPt(0.125f);
+
+        trace.events.emplace_back();
+        trace.events.back().type = InputTrace::Event::Type::kKey;
+        trace.events.back().time = 1.000001;
+        trace.events.back().window = 1;
+        trace.events.back().key.type = KeyEvent::Type::kKeyDown;
+        trace.events.back().key.key = Key::kV;
+        trace.events.back().key.nativeKey = -42;
+        trace.events.back().key.keymods = KeyModifier::kAlt;
+        trace.events.back().key.isRepeat = true;
+
+        trace.events.emplace_back();
+        trace.events.back().type = InputTrace::Event::Type::kText;
+        trace.events.back().time = 2.5;
+        trace.events.back().window = 1;
+        trace.events.back().text.utf8 = "h\xc3\xa9llo";
+
+        trace.events.emplace_back();
+        trace.events.back().type = InputTrace::Event::Type::kResize;
+        trace.events.back().time = 3600.0;
+        trace.events.back().window = 0;
+        trace.events.back().contentSize = Size(PicaPt(800.0f), PicaPt(600.5f));
+        trace.events.back().dpi = 192.0f;
+
+        auto data = trace.serialized();
+        InputTrace copy;
+        if (!copy.deserialize(data)) {
+            return "deserialize() failed";
+        }
+        auto err = compare(trace, copy);
+        if (!err.empty()) {
+            return err;
+        }
+        if (copy.duration() != 3600.0) {
+            return "duration() is wrong";
+        }
+
+        // Damaged data must fail and leave the trace unchanged
+        auto bad = data;
+        bad[0] ^= 0xff;
+        if (copy.deserialize(bad)) {
+            return "deserialize() accepted a bad header";
+        }
+        for (size_t len = 0;  len < data.size();  ++len) {
+            std::vector<uint8_t> truncated(data.begin(), data.begin() + len);
+            if (copy.deserialize(truncated)) {
+                return "deserialize() accepted data truncated to " + std::to_string(len) + " bytes";
+            }
+        }
+        bad = data;
+        bad.push_back(0);
+        if (copy.deserialize(bad)) {
+            return "deserialize() accepted trailing data";
+        }
+        return compare(trace, copy);
+    }
+
+private:
+    std::string compare(const InputTrace& expected, const InputTrace& got)
+    {
+        if (got.windows.size() != expected.windows.size()) {
+            return makeError("number of windows", got.windows.size(), expected.windows.size());
+        }
+        for (size_t i = 0;  i < got.windows.size();  ++i) {
+            auto &w = got.windows[i];
+            auto &x = expected.windows[i];
+            if (w.title != x.title) {
+                return makeError("window title", w.title, x.title);
+            }
+            if (w.contentSize.width != x.contentSize.width
+                || w.contentSize.height != x.contentSize.height || w.dpi != x.dpi) {
+                return "window " + std::to_string(i) + " size or dpi differs";
+            }
+        }
+
+        if (got.events.size() != expected.events.size()) {
+            return makeError("number of events", got.events.size(), expected.events.size());
+        }
+        for (size_t i = 0;  i < got.events.size();  ++i) {
+            auto &e = got.events[i];
+            auto &x = expected.events[i];
+            auto prefix = "event " + std::to_string(i) + ": ";
+            if (e.type != x.type || e.window != x.window) {
+                return prefix + "type or window differs";
+            }
+            if (e.time != x.time) {
+                return prefix + "time: got " + std::to_string(e.time) + ", expected "
+                       + std::to_string(x.time);
+            }
+            switch (x.type) {
+                case InputTrace::Event::Type::kMouse:
+                    if (!isSameMouse(e.mouse, x.mouse)) {
+                        return prefix + "mouse event differs";
+                    }
+                    break;
+                case InputTrace::Event::Type::kKey:
+                    if (e.key.type != x.key.type || e.key.key != x.key.key
+                        || e.key.nativeKey != x.key.nativeKey || e.key.keymods != x.key.keymods
+                        || e.key.isRepeat != x.key.isRepeat) {
+                        return prefix + "key event differs";
+                    }
+                    break;
+                case InputTrace::Event::Type::kText:
+                    if (e.text.utf8 != x.text.utf8) {
+                        return makeError(prefix + "text", e.text.utf8, x.text.utf8);
+                    }
+                    break;
+                case InputTrace::Event::Type::kResize:
+                    if (e.contentSize.width != x.contentSize.width
+                        || e.contentSize.height != x.contentSize.height || e.dpi != x.dpi) {
+                        return prefix + "resize differs";
+                    }
+                    break;
+            }
+        }
+        return "";
+    }
+
+    bool isSameMouse(const MouseEvent& e, const MouseEvent& x)
+    {
+        if (e.type != x.type || e.pos.x != x.pos.x || e.pos.y != x.pos.y
+            || e.keymods != x.keymods) {
+            return false;
+        }
+        switch (x.type) {
+            case MouseEvent::Type::kMove:
+                return true;
+            case MouseEvent::Type::kButtonDown:
+            case MouseEvent::Type::kButtonUp:
+                return (e.button.button == x.button.button && e.button.nClicks == x.button.nClicks);
+            case MouseEvent::Type::kDrag:
+                return (e.drag.buttons == x.drag.buttons);
+            case MouseEvent::Type::kScroll:
+                return (e.scroll.dx == x.scroll.dx && e.scroll.dy == x.scroll.dy);
+        }
+        return false;
+    }
+};
+
 //-----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
@@ -1018,6 +1517,10 @@ int main(int argc, char* argv[])
         std::make_shared<LeftTopGridTest>(),
         std::make_shared<CenterGridTest>(),
         std::make_shared<BottomRightGridTest>(),
+        std::make_shared<IndexRangeSetTest>(),
+        std::make_shared<RowHeightIndexTest>(),
+        std::make_shared<HitTestGridTest>(),
+        std::make_shared<InputTraceTest>(),
     };
 
     int nPass = 0, nFail = 0;
@@ -22,6 +22,8 @@
 
 #include "Application.h"
 
+#include "InputTrace.h"
+#include "Instrumentation.h"
 #include "MenubarUITK.h"
 #include "OSApplication.h"
 #include "Printing.h"
@@ -30,6 +32,7 @@
 #include "Window.h"
 #include "themes/EmpireTheme.h"
 #include "themes/StandardIconPainter.h"
+#include "private/ThreadPool.h"
 
 #if defined(__APPLE__)
 #include "macos/MacOSApplication.h"
@@ -42,6 +45,9 @@
 #else
 #include "x11/X11Application.h"
 #endif
+#if !defined(__EMSCRIPTEN__)
+#include "headless/HeadlessApplication.h"
+#endif
 
 // getcwd
 #if defined(_WIN32) || defined(_WIN64)
@@ -59,6 +65,8 @@
 
 namespace uitk {
 
+class HeadlessApplication;  // not available on Emscripten
+
 struct Application::Impl
 {
     static Application* instance;
@@ -71,7 +79,12 @@ struct Application::Impl
     std::vector<Window*> windows;  // we do not own these
     Window* activeWindow = nullptr;  // we do not own this
     std::chrono::time_point<std::chrono::steady_clock> t0 = std::chrono::steady_clock::now();
+    HeadlessApplication *headless = nullptr;  // same object as osApp, if headless
     bool supportsNativeDialogs;
+    std::unique_ptr<ThreadPool> backgroundTasks;  // created when first needed
+    std::unique_ptr<Instrumentation> instrumentation;
+    std::string frameTracePath;  // from UITK_FRAME_TRACE
+    std::string inputTracePath;  // from UITK_INPUT_TRACE
 };
 Application* Application::Impl::instance = nullptr;
 
@@ -99,15 +112,25 @@ Application& Application::instance()
 Application::Application()
     : mImpl(new Application::Impl())
 {
+#if !defined(__EMSCRIPTEN__)
+    if (HeadlessApplication::isRequested()) {
+        auto headless = std::make_unique<HeadlessApplication>();
+        mImpl->headless = headless.get();
+        mImpl->t0 = headless->now();
+        mImpl->osApp = std::move(headless);
+    }
+#endif
+    if (!mImpl->osApp) {
 #if defined(__APPLE__)
-    mImpl->osApp = std::make_unique<MacOSApplication>();
+        mImpl->osApp = std::make_unique<MacOSApplication>();
 #elif defined(_WIN32) || defined(_WIN64)
-    mImpl->osApp = std::make_unique<Win32Application>();
+        mImpl->osApp = std::make_unique<Win32Application>();
 #elif defined(__EMSCRIPTEN__)
-    mImpl->osApp = std::make_unique<WASMApplication>();
+        mImpl->osApp = std::make_unique<WASMApplication>();
 #else
-    mImpl->osApp = std::make_unique<X11Application>();
+        mImpl->osApp = std::make_unique<X11Application>();
 #endif
+    }
 
     setSupportsNativeDialogs(true);
 
@@ -117,12 +140,38 @@ Application::Application()
 
     mImpl->shortcuts = std::make_unique<Shortcuts>();
 
+    mImpl->instrumentation = std::make_unique<Instrumentation>();
+    if (auto *tracePath = getenv("UITK_FRAME_TRACE")) {
+        mImpl->frameTracePath = tracePath;
+        mImpl->instrumentation->setEnabled(!mImpl->frameTracePath.empty());
+    }
+
     assert(!Application::Impl::instance);
     Application::Impl::instance = this;
+
+    // Recording uses microTime(), so needs the instance
+    if (auto *tracePath = getenv("UITK_INPUT_TRACE")) {
+        mImpl->inputTracePath = tracePath;
+        if (!mImpl->inputTracePath.empty()) {
+            mImpl->instrumentation->startRecordingInput();
+        }
+    }
 }
 
 Application::~Application()
 {
+    mImpl->backgroundTasks.reset();  // waits for running tasks
+    if (!mImpl->frameTracePath.empty()) {
+        if (!mImpl->instrumentation->writeChromeTrace(mImpl->frameTracePath)) {
+            debugPrint("Could not write frame trace to '" + mImpl->frameTracePath + "'");
+        }
+    }
+    if (!mImpl->inputTracePath.empty() && mImpl->instrumentation->isRecordingInput()) {
+        auto trace = mImpl->instrumentation->stopRecordingInput();
+        if (!trace.write(mImpl->inputTracePath)) {
+            debugPrint("Could not write input trace to '" + mImpl->inputTracePath + "'");
+        }
+    }
     Application::Impl::instance = nullptr;
 }
 
@@ -192,6 +241,77 @@ void Application::cancelScheduled(ScheduledId id)
     mImpl->osApp->cancelScheduled(id);
 }
 
+Application::TaskId Application::runInBackground(Window *w,
+                                                 std::function<void(const CancelToken&)> task,
+                                                 std::function<void()> onDone /*= nullptr*/,
+                                                 TaskPriority priority /*= kNormal*/)
+{
+    CancelToken token;
+    token.mCancelled = std::make_shared<std::atomic<bool>>(false);
+#if defined(__EMSCRIPTEN__)
+    // Browsers do not give us threads without special headers, so run the
+    // task on the main thread, after the current event.
+    scheduleLater(nullptr, [token, task, onDone]() {
+        task(token);
+        if (onDone && !token.isCancelled()) {
+            onDone();
+        }
+    });
+    return 0;
+#else
+    if (!mImpl->backgroundTasks) {
+        mImpl->backgroundTasks = std::make_unique<ThreadPool>();
+    }
+
+    return mImpl->backgroundTasks->add(w, int(priority), token.mCancelled,
+                                       [this, token, task, onDone]() {
+        task(token);
+        if (onDone && !token.isCancelled()) {
+            // Check again on the main thread: the window may have been
+            // destroyed (or the task cancelled) while the completion was
+            // waiting to run. Both of those happen on the main thread, so
+            // there is no race. (The window cannot be passed to
+            // scheduleLater() for the same reason.)
+            scheduleLater(nullptr, [token, onDone]() {
+                if (!token.isCancelled()) {
+                    onDone();
+                }
+            });
+        }
+    });
+#endif // __EMSCRIPTEN__
+}
+
+void Application::cancelBackgroundTask(TaskId id)
+{
+    if (mImpl->backgroundTasks) {
+        mImpl->backgroundTasks->cancel(id);
+    }
+}
+
+int Application::maxConcurrentBackgroundTasks() const
+{
+    if (!mImpl->backgroundTasks) {
+        mImpl->backgroundTasks = std::make_unique<ThreadPool>();
+    }
+    return mImpl->backgroundTasks->maxConcurrent();
+}
+
+void Application::setMaxConcurrentBackgroundTasks(int n)
+{
+    if (!mImpl->backgroundTasks) {
+        mImpl->backgroundTasks = std::make_unique<ThreadPool>();
+    }
+    mImpl->backgroundTasks->setMaxConcurrent(n);
+}
+
+void Application::waitForBackgroundTasks()
+{
+    if (mImpl->backgroundTasks) {
+        mImpl->backgroundTasks->waitUntilIdle();
+    }
+}
+
 std::string Application::applicationName() const
 {
     return mImpl->osApp->applicationName();
@@ -229,7 +349,11 @@ std::vector<std::string> Application::availableFontFamilies() const
 
 double Application::microTime() const
 {
+#if !defined(__EMSCRIPTEN__)
+    auto t1 = (mImpl->headless ? mImpl->headless->now() : std::chrono::steady_clock::now());
+#else
     auto t1 = std::chrono::steady_clock::now();
+#endif
     auto dt_usec = std::chrono::duration_cast<std::chrono::microseconds>(t1 - mImpl->t0).count() / 1e6;
     return dt_usec;
 }
@@ -244,6 +368,11 @@ Sound& Application::sound() const
     return mImpl->osApp->sound();
 }
 
+Instrumentation& Application::instrumentation() const
+{
+    return *mImpl->instrumentation;
+}
+
 const PaperSize& Application::defaultPaperSize() const
 {
     std::string lc_paper;
@@ -320,6 +449,11 @@ bool Application::windowsMightUseSameDrawContext() const
     return mImpl->osApp->windowsMightUseSameDrawContext();
 }
 
+bool Application::windowContentsPersistBetweenDraws() const
+{
+    return mImpl->osApp->windowContentsPersistBetweenDraws();
+}
+
 bool Application::shouldHideScrollbars() const
 {
     return mImpl->osApp->shouldHideScrollbars();
@@ -343,6 +477,9 @@ bool Application::platformHasMenubar() const
 
 bool Application::supportsNativeMenus() const
 {
+    if (isHeadless()) {
+        return false;
+    }
 #if defined(__APPLE__)
     return true;
 #elif defined(_WIN32) || defined(_WIN64)
@@ -354,6 +491,11 @@ bool Application::supportsNativeMenus() const
 #endif
 }
 
+bool Application::isHeadless() const
+{
+    return (mImpl->headless != nullptr);
+}
+
 bool Application::supportsNativeDialogs() const
 {
     return mImpl->supportsNativeDialogs;
@@ -361,6 +503,10 @@ bool Application::supportsNativeDialogs() const
 
 void Application::setSupportsNativeDialogs(bool supports)
 {
+    if (isHeadless()) {
+        mImpl->supportsNativeDialogs = false;
+        return;
+    }
 #if defined(__APPLE__)
     mImpl->supportsNativeDialogs = supports;
 #elif defined(_WIN32) || defined(_WIN64)
@@ -449,6 +595,10 @@ void Application::addWindow(Window *w)
 
 void Application::removeWindow(Window *w)
 {
+    if (mImpl->backgroundTasks) {
+        mImpl->backgroundTasks->cancelForOwner(w);
+    }
+
     auto it = std::find(mImpl->windows.begin(), mImpl->windows.end(), w);
     if (it != mImpl->windows.end()) {
         mImpl->windows.erase(it);
@@ -23,6 +23,7 @@
 #ifndef UITK_APPLICATION_H
 #define UITK_APPLICATION_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <set>
@@ -32,6 +33,7 @@ namespace uitk {
 
 class Clipboard;
 class IconPainter;
+class Instrumentation;
 class OSApplication;
 class OSMenubar;
 struct PaperSize;
@@ -94,13 +96,51 @@ public:
     /// its own timer. (But, a huge do-everything timer is also a bad idea; normal
     /// code is hardly likely to have more than a handful of callbacks active at
     /// a time, anyway.) Due to the timing inaccuracy, this is not well-suited
-    /// for animations.
+    /// for animations. The window may be nullptr.
     ScheduledId scheduleLater(Window* w, float delay, ScheduleMode mode,
                               std::function<void(ScheduledId)> f);
 
     /// Cancels a scheduled callback.
     void cancelScheduled(ScheduledId id);
 
+    using TaskId = unsigned long;
+    enum class TaskPriority { kLow = 0, kNormal = 1, kHigh = 2 };
+
+    /// Passed to background tasks. Tasks that take a long time should check
+    /// isCancelled() periodically and return early if it is true.
+    class CancelToken
+    {
+    public:
+        bool isCancelled() const { return mCancelled->load(); }
+    private:
+        friend class Application;
+        std::shared_ptr<std::atomic<bool>> mCancelled;
+    };
+
+    /// Runs task on a background thread, and then calls onDone (if not null)
+    /// on the main thread, via scheduleLater(). Tasks run highest priority
+    /// first, and at most maxConcurrentBackgroundTasks() run at once.
+    /// If w is not null, the task is cancelled when w is destroyed; this
+    /// makes it safe for onDone to refer to w and its widgets. A cancelled
+    /// task is not started if it has not started, and onDone is not called.
+    /// The task must not call any functions on widgets or windows; use onDone
+    /// or scheduleLater() for that.
+    TaskId runInBackground(Window *w, std::function<void(const CancelToken&)> task,
+                           std::function<void()> onDone = nullptr,
+                           TaskPriority priority = TaskPriority::kNormal);
+    /// Cancels the background task. Must be called from the main thread.
+    void cancelBackgroundTask(TaskId id);
+
+    /// Returns the maximum number of background tasks that run at once.
+    /// The default is one less than the number of cores (minimum 1).
+    int maxConcurrentBackgroundTasks() const;
+    void setMaxConcurrentBackgroundTasks(int n);
+
+    /// Blocks until no background tasks are queued or running. The onDone
+    /// functions of the finished tasks have been scheduled by then, but
+    /// have not run. This is mostly useful for headless runs and tests.
+    void waitForBackgroundTasks();
+
     /// Returns the name of the application (used by some MacOS menus, the
     /// the About dialog, and can be useful for window titles).
     std::string applicationName() const;
@@ -131,6 +171,7 @@ public:
     /// animations or manual profiling.
     /// Note that the *accuracy* of may not be microseconds: this is
     /// currently a wrapper around std::chrono::steady_clock().
+    /// When headless (see isHeadless()) this is the virtual clock instead.
     /// Design note:  the name of the function comes from Java's nanoTime)(
     /// function. However, the 52 bits of the fraction allows durations of
     /// over 142 years before we lose microsecond precision due to lack of
@@ -150,6 +191,10 @@ public:
     /// For more complete control, use a third-party library such as OpenAL.
     Sound& sound() const;
 
+    /// Returns the frame instrumentation, which is disabled by default.
+    /// See Instrumentation.
+    Instrumentation& instrumentation() const;
+
     /// Returns the default paper size for the current locale.
     const PaperSize& defaultPaperSize() const;
 
@@ -190,6 +235,12 @@ public:
     /// already configured.
     bool windowsMightUseSameDrawContext() const;
 
+    /// Returns true if the contents of a window are kept between draws, so
+    /// that only the areas that changed need to be redrawn. Returns false if
+    /// the entire window must be drawn each time. This is used by Window to
+    /// limit drawing to the areas passed to setNeedsDraw().
+    bool windowContentsPersistBetweenDraws() const;
+
     /// Returns true if the operating system hides scrollbars when not
     /// scrolling (e.g. macOS), false otherwise.
     bool shouldHideScrollbars() const;
@@ -213,6 +264,11 @@ public:
     /// Returns true if the platform supports using native menus.
     bool supportsNativeMenus() const;
 
+    /// Returns true if the application is using the offscreen headless
+    /// backend instead of the window system. This is selected by setting
+    /// the UITK_HEADLESS environment variable; see HeadlessApplication.h.
+    bool isHeadless() const;
+
     /// Returns true if the platform supports native alert and file dialogs.
     bool supportsNativeDialogs() const;
     
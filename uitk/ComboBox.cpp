@@ -31,6 +31,8 @@
 #include "Window.h"
 #include "themes/Theme.h"
 
+#include <assert.h>
+
 namespace uitk {
 
 struct ComboBox::Impl
@@ -47,6 +49,8 @@ struct ComboBox::Impl
     PicaPt popupOffsetY;
 
     int nextId = 1;
+    int updateDepth = 0;
+    bool itemsChanged = false;
 };
 
 ComboBox::ComboBox()
@@ -71,6 +75,7 @@ void ComboBox::clear()
     mImpl->menu->clear();
     mImpl->items.clear();
     mImpl->selectedIndex = -1;
+    itemsChanged();
 }
 
 ComboBox* ComboBox::addItem(const std::string& text, int value /*= 0*/)
@@ -88,6 +93,7 @@ ComboBox* ComboBox::addItem(const std::string& text, int value /*= 0*/)
     if (idx == 0) {
         setSelectedIndex(0);
     }
+    itemsChanged();
     return this;
 }
 
@@ -105,6 +111,7 @@ ComboBox* ComboBox::addItem(CellWidget *item, int value /*= 0*/)
     if (idx == 0) {
         setSelectedIndex(0);
     }
+    itemsChanged();
     return this;
 
 }
@@ -112,9 +119,35 @@ ComboBox* ComboBox::addItem(CellWidget *item, int value /*= 0*/)
 ComboBox* ComboBox::addSeparator()
 {
     mImpl->menu->addSeparator();
+    itemsChanged();
     return this;
 }
 
+void ComboBox::beginUpdates()
+{
+    mImpl->updateDepth += 1;
+}
+
+void ComboBox::endUpdates()
+{
+    assert(mImpl->updateDepth > 0);
+    mImpl->updateDepth -= 1;
+    if (mImpl->updateDepth == 0 && mImpl->itemsChanged) {
+        mImpl->itemsChanged = false;
+        setNeedsLayout();
+    }
+}
+
+void ComboBox::itemsChanged()
+{
+    // Our preferred width depends on the widest item.
+    if (mImpl->updateDepth > 0) {
+        mImpl->itemsChanged = true;
+    } else {
+        setNeedsLayout();
+    }
+}
+
 std::string ComboBox::textAtIndex(int index) const
 {
     static const std::string kBadIndexText = "";
@@ -129,6 +162,7 @@ ComboBox* ComboBox::setTextAtIndex(int index, const std::string& text)
 {
     if (index >= 0 || index < int(mImpl->items.size())) {
         mImpl->menu->setItemText(mImpl->items[index].value, text);
+        itemsChanged();
     }
     return this;
 }
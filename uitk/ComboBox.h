@@ -45,6 +45,12 @@ public:
     ComboBox* addItem(CellWidget *item, int value = 0);
     ComboBox* addSeparator();
 
+    /// Defers the layout caused by adding or removing items until the
+    /// matching endUpdates(), so that adding many items only measures them
+    /// once. Calls may be nested.
+    void beginUpdates();
+    void endUpdates();
+
     /// Returns the text of the item at the requested index, or "" if the
     /// index is invalid.
     std::string textAtIndex(int index) const;
@@ -94,6 +100,8 @@ protected:
     virtual void didHideMenu();  /// no need to super, default is no-op
 
 private:
+    void itemsChanged();
+
     struct Impl;
     std::unique_ptr<Impl> mImpl;
 };
@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_COROUTINES_H
+#define UITK_COROUTINES_H
+
+// This header is optional and requires C++20; the rest of the library only
+// needs C++17, and uitk.h does not include this.
+#if !defined(__cpp_impl_coroutine)
+#error "uitk/Coroutines.h requires C++20 coroutines (e.g. -std=c++20)"
+#endif
+
+#include "Application.h"
+#include "Dialog.h"
+
+#include <coroutine>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace uitk {
+
+/// The return type of a coroutine started from ordinary code, such as a
+/// button's onClicked callback. The coroutine starts running immediately and
+/// runs until its first co_await; the caller does not wait for it.
+///   Task loadImage(Window *w, ImageView *view, std::string path) {
+///       co_await background();
+///       auto image = Image::fromFile(path);  // not on the UI thread
+///       co_await mainThread();
+///       view->setImage(image);
+///       co_await showModal(someDialog, w);
+///   }
+/// Exceptions escaping the coroutine terminate the program, the same as an
+/// exception escaping a callback would.
+class Task
+{
+public:
+    struct promise_type
+    {
+        Task get_return_object() { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/// co_await background() continues the coroutine on a background thread
+/// (see Application::runInBackground()). Do not touch widgets or windows
+/// until after co_await mainThread().
+class BackgroundAwaiter
+{
+public:
+    explicit BackgroundAwaiter(Application::TaskPriority priority) : mPriority(priority) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        // Not tied to a window: a cancelled task would never resume the
+        // coroutine, which would leak its frame.
+        Application::instance().runInBackground(nullptr,
+                                                [h](const Application::CancelToken&) { h.resume(); },
+                                                nullptr, mPriority);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    Application::TaskPriority mPriority;
+};
+
+inline BackgroundAwaiter background(Application::TaskPriority priority = Application::TaskPriority::kNormal)
+{
+    return BackgroundAwaiter(priority);
+}
+
+/// co_await mainThread() continues the coroutine on the main thread, after
+/// the events that are already queued.
+class MainThreadAwaiter
+{
+public:
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        Application::instance().scheduleLater(nullptr, [h]() { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+inline MainThreadAwaiter mainThread() { return MainThreadAwaiter(); }
+
+/// co_await delay(secs) continues the coroutine on the main thread after
+/// secs seconds, without blocking the event loop. This has the same
+/// precision as Application::scheduleLater().
+class DelayAwaiter
+{
+public:
+    explicit DelayAwaiter(float secs) : mSecs(secs) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        Application::instance().scheduleLater(nullptr, mSecs, Application::ScheduleMode::kOnce,
+                                              [h](Application::ScheduledId) { h.resume(); });
+    }
+    void await_resume() const noexcept {}
+
+private:
+    float mSecs;
+};
+
+inline DelayAwaiter delay(float secs) { return DelayAwaiter(secs); }
+
+/// The result of co_await showModal() or co_await showAlert().
+struct DialogResult
+{
+    Dialog::Result result;
+    int value;  /// the value passed to Dialog::finish(), or the button index
+};
+
+/// co_await showModal(dlg, w) shows the dialog and continues the coroutine
+/// when the dialog finishes or is cancelled. The caller still owns dlg.
+class DialogAwaiter
+{
+public:
+    DialogAwaiter(Dialog *dlg, Window *w) : mDialog(dlg), mWindow(w) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        // The awaiter lives in the coroutine frame until we resume it, so
+        // the callback can refer to this.
+        mDialog->showModal(mWindow, [this, h](Dialog::Result r, int value) {
+            mResult = { r, value };
+            h.resume();
+        });
+    }
+    DialogResult await_resume() const noexcept { return mResult; }
+
+private:
+    Dialog *mDialog;
+    Window *mWindow;
+    DialogResult mResult = { Dialog::Result::kCancelled, 0 };
+};
+
+inline DialogAwaiter showModal(Dialog *dlg, Window *w) { return DialogAwaiter(dlg, w); }
+
+/// co_await showAlert(...) is Dialog::showAlert() with buttons, continuing
+/// the coroutine with the index of the button that was pressed.
+class AlertAwaiter
+{
+public:
+    AlertAwaiter(Window *w, const std::string& title, const std::string& message,
+                 const std::string& info, const std::vector<std::string>& buttons)
+        : mWindow(w), mTitle(title), mMessage(message), mInfo(info), mButtons(buttons)
+    {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        Dialog::showAlert(mWindow, mTitle, mMessage, mInfo, mButtons,
+                          [this, h](Dialog::Result r, int value) {
+            mResult = { r, value };
+            h.resume();
+        });
+    }
+    DialogResult await_resume() const noexcept { return mResult; }
+
+private:
+    Window *mWindow;
+    std::string mTitle;
+    std::string mMessage;
+    std::string mInfo;
+    std::vector<std::string> mButtons;
+    DialogResult mResult = { Dialog::Result::kCancelled, 0 };
+};
+
+inline AlertAwaiter showAlert(Window *w, const std::string& title, const std::string& message,
+                              const std::string& info, const std::vector<std::string>& buttons)
+{
+    return AlertAwaiter(w, title, message, info, buttons);
+}
+
+}  // namespace uitk
+#endif // UITK_COROUTINES_H
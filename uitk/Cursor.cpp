@@ -33,6 +33,10 @@
 #else
 #include "x11/X11Cursor.h"
 #endif
+#if !defined(__EMSCRIPTEN__)
+#include "Application.h"
+#include "headless/HeadlessCursor.h"
+#endif
 
 #include <memory>
 #include <vector>
@@ -66,15 +70,22 @@ public:
         if (idx >= 0 && idx < mSystemCursors.size()) {
             if (!mSystemCursors[idx]) {
                 OSCursor *newCursor = nullptr;
+#if !defined(__EMSCRIPTEN__)
+                if (Application::instance().isHeadless()) {
+                    newCursor = new HeadlessCursor(id);
+                }
+#endif
+                if (!newCursor) {
 #if defined(__APPLE__)
-                newCursor = new MacOSCursor(id);
+                    newCursor = new MacOSCursor(id);
 #elif defined(_WIN32) || defined(_WIN64)
-                newCursor = new Win32Cursor(id);
+                    newCursor = new Win32Cursor(id);
 #elif defined(__EMSCRIPTEN__)
-                newCursor = new WASMCursor(id);
+                    newCursor = new WASMCursor(id);
 #else
-                newCursor = new X11Cursor(id);
+                    newCursor = new X11Cursor(id);
 #endif
+                }
                 mOSSystemCursors[idx].reset(newCursor);  // takes ownership of newCursor
                 newCursor = nullptr;  // for clarity
                 mSystemCursors[idx].reset(new Cursor(mOSSystemCursors[idx].get()));
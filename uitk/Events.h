@@ -27,6 +27,7 @@
 #include <nativedraw.h>
 
 #include <string>
+#include <vector>
 
 namespace uitk {
 
@@ -60,6 +61,12 @@ struct MouseEvent
     Type type;
     Point pos;
     int keymods;
+    /// The time the event happened, in seconds, on the clock of
+    /// Instrumentation::now() (only differences are meaningful). This is the
+    /// platform's timestamp where it provides one, so it does not include the
+    /// time the event spent waiting in the queue. Zero if unknown, such as for
+    /// events created by the program.
+    double time = 0.0;
     union {
         struct {
             MouseButton button;
@@ -74,6 +81,20 @@ struct MouseEvent
         } scroll;
     };
 
+    /// An earlier position of the mouse, relative to pos.
+    struct PastMotion
+    {
+        Point offset;
+        double time;
+    };
+    /// For kMove and kDrag, the motion events that the platform coalesced
+    /// into this one, oldest first, or nullptr if there were none. Since the
+    /// offsets are relative to pos, pos + offset is the earlier position in
+    /// the same coordinates as pos. Widgets that draw with the mouse can use
+    /// these so that they do not miss any points; the others can ignore them.
+    /// This is only valid during the call.
+    const std::vector<PastMotion> *history = nullptr;
+
     // scroll has non-trivial member, so need a constructor.
     // But PicaPt has no invariants, so we do not need to initialize
     // anything.
@@ -145,11 +166,13 @@ struct KeyEvent
     int nativeKey;  /// this is passed through from native events
     int keymods;
     bool isRepeat;
+    double time = 0.0;  /// see MouseEvent::time
 };
 
 struct TextEvent
 {
     std::string utf8;
+    double time = 0.0;  /// see MouseEvent::time
 };
 
 }  // namespace uitk
@@ -217,6 +217,7 @@ struct FileDialog::Impl
         }
 
         this->panel.files->clearCells();
+        this->panel.files->beginUpdates();
         for (auto &e : model.entries) {
             if (e.isDir) {
                 this->panel.files->addStringCell(e.name + "/");
@@ -224,6 +225,7 @@ struct FileDialog::Impl
                 this->panel.files->addStringCell(e.name);
             }
         }
+        this->panel.files->endUpdates();
 
         this->panel.ok->setEnabled(false);
         updateFilenameFromSelection();
@@ -103,9 +103,11 @@ FontListComboBox::FontListComboBox()
 FontListComboBox::FontListComboBox(const std::vector<std::string>& fontNames)
     : mImpl(new Impl())
 {
+    beginUpdates();
     for (auto &fontName : fontNames) {
         addFont(fontName);
     }
+    endUpdates();
     didHideMenu();  // make sure selected item is normal font
 }
 
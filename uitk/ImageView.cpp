@@ -54,6 +54,7 @@ ImageView* ImageView::setImage(const Image& image)
 {
     mImpl->image = image;
     mImpl->drawableImage.reset();
+    setNeedsLayout();
     setNeedsDraw();
     return this;
 }
@@ -0,0 +1,533 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "InputTrace.h"
+
+#include "Application.h"
+#include "IPopupWindow.h"
+#include "Window.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#include <string.h>
+
+namespace uitk {
+
+namespace {
+// The format is little-endian: the magic, a varint version, the windows,
+// then the events. Event times are varint microseconds since the previous
+// event, and most integers are varints, so a typical mouse move is about
+// 15 bytes.
+static const char kMagic[8] = { 'U', 'I', 'T', 'K', 'I', 'N', 'P', 'T' };
+static const uint64_t kVersion = 1;
+
+// Frames are filtered from the instrumentation's ring buffer, so it needs to
+// be large enough to hold the whole replay.
+static const size_t kReplayMaxFrames = 1000000;
+
+class Writer
+{
+public:
+    explicit Writer(std::vector<uint8_t> *data) : mData(data) {}
+
+    void u8(uint8_t x) { mData->push_back(x); }
+
+    void varint(uint64_t x)
+    {
+        while (x >= 0x80) {
+            mData->push_back(uint8_t(x & 0x7f) | 0x80);
+            x >>= 7;
+        }
+        mData->push_back(uint8_t(x));
+    }
+
+    void zigzag(int64_t x) { varint((uint64_t(x) << 1) ^ uint64_t(x >> 63)); }
+
+    void f32(float x)
+    {
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        for (int i = 0;  i < 4;  ++i) {
+            mData->push_back(uint8_t(bits >> (8 * i)));
+        }
+    }
+
+    void str(const std::string& s)
+    {
+        varint(s.size());
+        mData->insert(mData->end(), s.begin(), s.end());
+    }
+
+private:
+    std::vector<uint8_t> *mData;
+};
+
+// Reading past the end (or any malformed value) sets isOk() to false and
+// returns zeros, so callers only need to check once at the end.
+class Reader
+{
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : mData(data) {}
+
+    bool isOk() const { return mOk; }
+    bool atEnd() const { return mPos >= mData.size(); }
+
+    uint8_t u8()
+    {
+        if (mPos >= mData.size()) {
+            mOk = false;
+            return 0;
+        }
+        return mData[mPos++];
+    }
+
+    uint64_t varint()
+    {
+        uint64_t x = 0;
+        for (int shift = 0;  shift < 64;  shift += 7) {
+            auto b = u8();
+            x |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return x;
+            }
+        }
+        mOk = false;
+        return 0;
+    }
+
+    int64_t zigzag()
+    {
+        auto x = varint();
+        return int64_t(x >> 1) ^ -int64_t(x & 1);
+    }
+
+    float f32()
+    {
+        uint32_t bits = 0;
+        for (int i = 0;  i < 4;  ++i) {
+            bits |= uint32_t(u8()) << (8 * i);
+        }
+        float x;
+        memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    std::string str()
+    {
+        auto len = varint();
+        if (len > mData.size() - std::min(mPos, mData.size())) {
+            mOk = false;
+            return "";
+        }
+        std::string s((const char*)mData.data() + mPos, size_t(len));
+        mPos += size_t(len);
+        return s;
+    }
+
+private:
+    const std::vector<uint8_t>& mData;
+    size_t mPos = 0;
+    bool mOk = true;
+};
+
+void writeMouse(Writer& out, const MouseEvent& e)
+{
+    out.u8(uint8_t(e.type));
+    out.f32(e.pos.x.asFloat());
+    out.f32(e.pos.y.asFloat());
+    out.varint(uint64_t(e.keymods));
+    switch (e.type) {
+        case MouseEvent::Type::kMove:
+            break;
+        case MouseEvent::Type::kButtonDown:
+        case MouseEvent::Type::kButtonUp:
+            out.varint(uint64_t(e.button.button));
+            out.varint(uint64_t(e.button.nClicks));
+            break;
+        case MouseEvent::Type::kDrag:
+            out.varint(uint64_t(e.drag.buttons));
+            break;
+        case MouseEvent::Type::kScroll:
+            out.f32(e.scroll.dx.asFloat());
+            out.f32(e.scroll.dy.asFloat());
+            break;
+    }
+}
+
+bool readMouse(Reader& in, MouseEvent *e)
+{
+    auto type = in.u8();
+    if (type > uint8_t(MouseEvent::Type::kScroll)) {
+        return false;
+    }
+    e->type = MouseEvent::Type(type);
+    e->pos.x = PicaPt(in.f32());
+    e->pos.y = PicaPt(in.f32());
+    e->keymods = int(in.varint());
+    switch (e->type) {
+        case MouseEvent::Type::kMove:
+            break;
+        case MouseEvent::Type::kButtonDown:
+        case MouseEvent::Type::kButtonUp:
+            e->button.button = MouseButton(in.varint());
+            e->button.nClicks = int(in.varint());
+            break;
+        case MouseEvent::Type::kDrag:
+            e->drag.buttons = int(in.varint());
+            break;
+        case MouseEvent::Type::kScroll:
+            e->scroll.dx = PicaPt(in.f32());
+            e->scroll.dy = PicaPt(in.f32());
+            break;
+    }
+    return true;
+}
+
+void writeKey(Writer& out, const KeyEvent& e)
+{
+    out.u8(uint8_t(e.type));
+    out.varint(uint64_t(e.key));
+    out.zigzag(e.nativeKey);
+    out.varint(uint64_t(e.keymods));
+    out.u8(e.isRepeat ? 1 : 0);
+}
+
+bool readKey(Reader& in, KeyEvent *e)
+{
+    auto type = in.u8();
+    if (type > uint8_t(KeyEvent::Type::kKeyUp)) {
+        return false;
+    }
+    e->type = KeyEvent::Type(type);
+    e->key = Key(in.varint());
+    e->nativeKey = int(in.zigzag());
+    e->keymods = int(in.varint());
+    e->isRepeat = (in.u8() != 0);
+    return true;
+}
+
+int64_t toUsec(double secs)
+{
+    return int64_t(std::llround(secs * 1e6));
+}
+
+// Popups and dialogs are not in Application::windows(), but popups can be
+// found through the windows that opened them.
+Window* findWindow(const std::string& title)
+{
+    auto &windows = Application::instance().windows();
+    for (auto it = windows.rbegin();  it != windows.rend();  ++it) {
+        std::vector<Window*> chain;
+        for (Window *w = *it;  w;  w = (w->popupWindow() ? w->popupWindow()->window() : nullptr)) {
+            chain.push_back(w);
+        }
+        // Innermost popup first, since it was opened most recently
+        for (auto cit = chain.rbegin();  cit != chain.rend();  ++cit) {
+            if ((*cit)->title() == title) {
+                return *cit;
+            }
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+double InputTrace::duration() const
+{
+    return (events.empty() ? 0.0 : events.back().time);
+}
+
+std::vector<uint8_t> InputTrace::serialized() const
+{
+    std::vector<uint8_t> data;
+    data.reserve(sizeof(kMagic) + 64 * windows.size() + 16 * events.size());
+    data.insert(data.end(), std::begin(kMagic), std::end(kMagic));
+    Writer out(&data);
+    out.varint(kVersion);
+
+    out.varint(windows.size());
+    for (auto &w : windows) {
+        out.str(w.title);
+        out.f32(w.contentSize.width.asFloat());
+        out.f32(w.contentSize.height.asFloat());
+        out.f32(w.dpi);
+    }
+
+    out.varint(events.size());
+    int64_t lastUsec = 0;
+    for (auto &e : events) {
+        auto usec = std::max(lastUsec, toUsec(e.time));
+        out.u8(uint8_t(e.type));
+        out.varint(uint64_t(e.window));
+        out.varint(uint64_t(usec - lastUsec));
+        lastUsec = usec;
+        switch (e.type) {
+            case Event::Type::kMouse:
+                writeMouse(out, e.mouse);
+                break;
+            case Event::Type::kKey:
+                writeKey(out, e.key);
+                break;
+            case Event::Type::kText:
+                out.str(e.text.utf8);
+                break;
+            case Event::Type::kResize:
+                out.f32(e.contentSize.width.asFloat());
+                out.f32(e.contentSize.height.asFloat());
+                out.f32(e.dpi);
+                break;
+        }
+    }
+    return data;
+}
+
+bool InputTrace::deserialize(const std::vector<uint8_t>& data)
+{
+    if (data.size() < sizeof(kMagic) || memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    std::vector<uint8_t> body(data.begin() + sizeof(kMagic), data.end());
+    Reader in(body);
+    if (in.varint() != kVersion) {
+        return false;
+    }
+
+    InputTrace trace;
+    auto nWindows = in.varint();
+    for (uint64_t i = 0;  i < nWindows && in.isOk();  ++i) {
+        WindowInfo w;
+        w.title = in.str();
+        w.contentSize.width = PicaPt(in.f32());
+        w.contentSize.height = PicaPt(in.f32());
+        w.dpi = in.f32();
+        trace.windows.push_back(w);
+    }
+
+    auto nEvents = in.varint();
+    int64_t usec = 0;
+    for (uint64_t i = 0;  i < nEvents && in.isOk();  ++i) {
+        trace.events.emplace_back();
+        auto &e = trace.events.back();
+        auto type = in.u8();
+        e.window = int(in.varint());
+        usec += int64_t(in.varint());
+        e.time = double(usec) / 1e6;
+        if (e.window < 0 || e.window >= int(trace.windows.size())) {
+            return false;
+        }
+        switch (Event::Type(type)) {
+            case Event::Type::kMouse:
+                e.type = Event::Type::kMouse;
+                if (!readMouse(in, &e.mouse)) {
+                    return false;
+                }
+                break;
+            case Event::Type::kKey:
+                e.type = Event::Type::kKey;
+                if (!readKey(in, &e.key)) {
+                    return false;
+                }
+                break;
+            case Event::Type::kText:
+                e.type = Event::Type::kText;
+                e.text.utf8 = in.str();
+                break;
+            case Event::Type::kResize:
+                e.type = Event::Type::kResize;
+                e.contentSize.width = PicaPt(in.f32());
+                e.contentSize.height = PicaPt(in.f32());
+                e.dpi = in.f32();
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (!in.isOk() || !in.atEnd()) {
+        return false;
+    }
+    *this = std::move(trace);
+    return true;
+}
+
+bool InputTrace::write(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    auto data = serialized();
+    out.write((const char*)data.data(), std::streamsize(data.size()));
+    return bool(out);
+}
+
+bool InputTrace::read(const std::string& path)
+{
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    return deserialize(data);
+}
+
+//-----------------------------------------------------------------------------
+struct InputReplayer::Impl
+{
+    InputTrace trace;
+    Speed speed = Speed::kRecorded;
+    std::function<void(const Result&)> onDone;
+    Result result;
+    size_t nextEvent = 0;
+    bool replaying = false;
+    Application::ScheduledId scheduled = Application::kInvalidScheduledId;
+    double appStartTime = 0.0;  // Application::microTime(), for the recorded times
+    double realStartTime = 0.0;  // Instrumentation::now(), for the frames
+    bool wasInstrumenting = false;
+    size_t oldMaxFrames = 0;
+
+    void scheduleNext()
+    {
+        auto &app = Application::instance();
+        float delay = 0.0f;
+        if (this->speed == Speed::kRecorded && this->nextEvent < this->trace.events.size()) {
+            auto due = this->appStartTime + this->trace.events[this->nextEvent].time;
+            delay = float(std::max(0.0, due - app.microTime()));
+        }
+        // Scheduling each event separately (instead of delivering them all
+        // in one callback) lets the event loop draw in between, like it would
+        // for real input. After the last event this is one more trip through
+        // the event loop, so that its draw is included.
+        this->scheduled = app.scheduleLater(nullptr, delay, Application::ScheduleMode::kOnce,
+                                            [this](Application::ScheduledId) {
+            this->scheduled = Application::kInvalidScheduledId;
+            if (this->nextEvent < this->trace.events.size()) {
+                deliver(this->trace.events[this->nextEvent++]);
+                scheduleNext();
+            } else {
+                finish();
+            }
+        });
+    }
+
+    void deliver(const InputTrace::Event& e)
+    {
+        auto *w = findWindow(this->trace.windows[e.window].title);
+        if (!w) {
+            this->result.nSkipped += 1;
+            return;
+        }
+
+        this->result.nEvents += 1;
+        switch (e.type) {
+            case InputTrace::Event::Type::kMouse:
+                w->onMouse(e.mouse);
+                break;
+            case InputTrace::Event::Type::kKey:
+                w->onKey(e.key);
+                break;
+            case InputTrace::Event::Type::kText:
+                w->onText(e.text);
+                break;
+            case InputTrace::Event::Type::kResize:
+                w->resize(e.contentSize);
+                break;
+        }
+    }
+
+    void restoreInstrumentation()
+    {
+        auto &instr = Application::instance().instrumentation();
+        instr.setMaxFrames(this->oldMaxFrames);
+        instr.setEnabled(this->wasInstrumenting);
+    }
+
+    void finish()
+    {
+        auto &instr = Application::instance().instrumentation();
+        this->result.secs = Instrumentation::now() - this->realStartTime;
+        for (auto &f : instr.recentFrames()) {
+            if (f.startTime >= this->realStartTime) {
+                this->result.frames.push_back(f);
+            }
+        }
+        restoreInstrumentation();
+        this->replaying = false;
+
+        auto onDone = this->onDone;  // onDone might destroy us
+        auto result = std::move(this->result);
+        if (onDone) {
+            onDone(result);
+        }
+    }
+};
+
+InputReplayer::InputReplayer(const InputTrace& trace)
+    : mImpl(new Impl())
+{
+    mImpl->trace = trace;
+}
+
+InputReplayer::~InputReplayer()
+{
+    cancel();
+}
+
+void InputReplayer::start(Speed speed, std::function<void(const Result&)> onDone)
+{
+    cancel();
+
+    auto &app = Application::instance();
+    auto &instr = app.instrumentation();
+    mImpl->speed = speed;
+    mImpl->onDone = onDone;
+    mImpl->result = Result();
+    mImpl->nextEvent = 0;
+    mImpl->replaying = true;
+    mImpl->wasInstrumenting = instr.isEnabled();
+    mImpl->oldMaxFrames = instr.maxFrames();
+    instr.setMaxFrames(std::max(mImpl->oldMaxFrames, kReplayMaxFrames));
+    instr.setEnabled(true);
+    mImpl->appStartTime = app.microTime();
+    mImpl->realStartTime = Instrumentation::now();
+    mImpl->scheduleNext();
+}
+
+void InputReplayer::cancel()
+{
+    if (mImpl->replaying) {
+        Application::instance().cancelScheduled(mImpl->scheduled);
+        mImpl->scheduled = Application::kInvalidScheduledId;
+        mImpl->restoreInstrumentation();
+        mImpl->replaying = false;
+    }
+}
+
+bool InputReplayer::isReplaying() const { return mImpl->replaying; }
+
+}  // namespace uitk
@@ -0,0 +1,133 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef UITK_INPUT_TRACE_H
+#define UITK_INPUT_TRACE_H
+
+#include "Events.h"
+#include "Instrumentation.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uitk {
+
+class Window;
+
+/// A recording of the input that an application's windows received, for
+/// reproducing a session (for instance, one that a user reported as janky)
+/// as an automated performance test. Record with
+/// Instrumentation::startRecordingInput(), or by setting the environment
+/// variable UITK_INPUT_TRACE to a path, which records from startup and
+/// writes the trace to the path when the Application is destroyed. Play it
+/// back with InputReplayer, preferably in a headless run (see
+/// Application::isHeadless()) so that the results do not depend on the
+/// machine's display.
+struct InputTrace
+{
+    struct WindowInfo
+    {
+        std::string title;
+        Size contentSize;  /// when the window was first seen
+        float dpi;
+    };
+
+    struct Event
+    {
+        enum class Type { kMouse = 1, kKey, kText, kResize };
+
+        Type type;
+        double time;  /// seconds since recording started
+        int window;  /// index into windows
+        MouseEvent mouse;  /// if kMouse
+        KeyEvent key;  /// if kKey
+        TextEvent text;  /// if kText
+        Size contentSize;  /// if kResize
+        float dpi;  /// if kResize
+    };
+
+    std::vector<WindowInfo> windows;
+    std::vector<Event> events;
+
+    /// Returns the time of the last event.
+    double duration() const;
+
+    /// Writes the trace in a compact binary format. Returns false on failure.
+    bool write(const std::string& path) const;
+    /// Replaces the contents with the trace in the file. Returns false if
+    /// the file could not be read or is not a trace (or is from a newer
+    /// version of the format).
+    bool read(const std::string& path);
+
+    /// The binary format, for writing to something other than a file.
+    std::vector<uint8_t> serialized() const;
+    bool deserialize(const std::vector<uint8_t>& data);
+};
+
+/// Feeds an InputTrace back to the application's windows using the event
+/// loop, and reports the frames that were drawn as a result. Events go to
+/// the open window with the same title as the window they were recorded
+/// from (the most recently opened one, if several have the same title, as
+/// is the case for popup menus), so the application needs to open the
+/// same windows that it had when the trace was recorded. Events for
+/// windows that are not open are skipped. Resizes are replayed with
+/// Window::resize().
+class InputReplayer
+{
+public:
+    enum class Speed {
+        kRecorded,  /// the events are delivered at their recorded times
+        kMaximum    /// each event is delivered as soon as the previous one is handled
+    };
+
+    struct Result
+    {
+        int nEvents = 0;  /// events delivered
+        int nSkipped = 0;  /// events whose window was not open
+        double secs = 0.0;  /// real time taken to replay, see Instrumentation::now()
+        /// The frames drawn during the replay. Frame instrumentation is
+        /// enabled for the duration of the replay.
+        std::vector<FrameRecord> frames;
+    };
+
+    explicit InputReplayer(const InputTrace& trace);
+    ~InputReplayer();
+
+    /// Starts replaying; onDone is called from the event loop after the last
+    /// event has been delivered and the event loop has had a chance to draw
+    /// it. The replayer must not be destroyed before then, unless it is
+    /// cancelled.
+    void start(Speed speed, std::function<void(const Result&)> onDone);
+    /// Stops replaying; onDone is not called.
+    void cancel();
+    bool isReplaying() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+}  // namespace uitk
+#endif // UITK_INPUT_TRACE_H
@@ -0,0 +1,718 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 - 2024 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "Instrumentation.h"
+
+#include "Application.h"
+#include "Events.h"
+#include "InputTrace.h"
+#include "Widget.h"
+#include "Window.h"
+
+#define ND_NAMESPACE uitk
+#include <nativedraw.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace uitk {
+
+namespace {
+
+static const size_t kDefaultMaxFrames = 600;  // 10 secs at 60 fps
+static const int kNInputTypes = 3;
+
+Instrumentation *gEnabledInstrumentation = nullptr;  // this is a ref
+Instrumentation *gWidgetProfiler = nullptr;  // this is a ref
+
+// Finer around the 60 Hz and 120 Hz frame times, where latency budgets are.
+static const std::vector<double> kLatencyBucketsMs = {
+    1.0, 2.0, 4.0, 6.0, 8.0, 10.0, 12.0, 14.0, 16.0, 20.0, 25.0, 33.0, 50.0,
+    67.0, 100.0, 150.0, 250.0, 500.0, 1000.0 };
+
+// Forwards everything to the real context, counting the calls we are
+// interested in along the way.
+class CountingDrawContext : public DrawContext
+{
+public:
+    DrawContext& mRealDC;
+    Instrumentation& mInstr;
+
+public:
+    CountingDrawContext(DrawContext& realDC, Instrumentation& instr)
+        : DrawContext(nullptr, realDC.width(), realDC.height(), realDC.dpi(), realDC.dpi())
+        , mRealDC(realDC), mInstr(instr)
+    {
+    }
+
+    std::shared_ptr<DrawContext> createBitmap(BitmapType type, int width, int height,
+                                              float dpi = 72.0f) override
+        { return mRealDC.createBitmap(type, width, height, dpi); }
+
+    std::shared_ptr<DrawableImage> createDrawableImage(const Image& image) const override
+        { return mRealDC.createDrawableImage(image); }
+
+    std::shared_ptr<BezierPath> createBezierPath() const override
+        { return mRealDC.createBezierPath(); }
+
+    std::shared_ptr<TextLayout> createTextLayout(
+                const char *utf8, const Font& font, const Color& color,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override
+    {
+        mInstr.countTextLayout();
+        return mRealDC.createTextLayout(utf8, font, color, size, alignment, wrap);
+    }
+    std::shared_ptr<TextLayout> createTextLayout(
+                const Text& t,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override
+    {
+        mInstr.countTextLayout();
+        return mRealDC.createTextLayout(t, size, alignment, wrap);
+    }
+    std::shared_ptr<TextLayout> createTextLayout(
+                const Text& t,
+                const Font& defaultReplacementFont,
+                const Color& defaultReplacementColor,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override
+    {
+        mInstr.countTextLayout();
+        return mRealDC.createTextLayout(t, defaultReplacementFont, defaultReplacementColor,
+                                        size, alignment, wrap);
+    }
+    Gradient& getGradient(const std::vector<Gradient::Stop>& stops) override { return mRealDC.getGradient(stops); }
+    Gradient& getGradient(size_t id) const override { return mRealDC.getGradient(id); }
+
+    void beginDraw() override { mRealDC.beginDraw(); }
+    void endDraw() override { mRealDC.endDraw(); }
+
+    void save() override { mRealDC.save(); }
+    void restore() override { mRealDC.restore(); }
+    void translate(const PicaPt& dx, const PicaPt& dy) override { mRealDC.translate(dx, dy); }
+    void rotate(float degrees) override { mRealDC.rotate(degrees); }
+    void scale(float sx, float sy) override { mRealDC.scale(sx, sy); }
+
+    void setFillColor(const Color& color) override { mRealDC.setFillColor(color); }
+    void setStrokeColor(const Color& color) override { mRealDC.setStrokeColor(color); }
+    void setStrokeWidth(const PicaPt& w) override { mRealDC.setStrokeWidth(w); }
+    void setStrokeEndCap(EndCapStyle cap) override { mRealDC.setStrokeEndCap(cap); }
+    void setStrokeJoinStyle(JoinStyle join) override { mRealDC.setStrokeJoinStyle(join); }
+    void setStrokeDashes(const std::vector<PicaPt> lengths, const PicaPt& offset) override
+        { mRealDC.setStrokeDashes(lengths, offset); }
+
+    Color fillColor() const override { return mRealDC.fillColor(); }
+    Color strokeColor() const override { return mRealDC.strokeColor(); }
+    PicaPt strokeWidth() const override { return mRealDC.strokeWidth(); }
+    EndCapStyle strokeEndCap() const override { return mRealDC.strokeEndCap(); }
+    JoinStyle strokeJoinStyle() const override { return mRealDC.strokeJoinStyle(); }
+
+    void fill(const Color& color) override
+        { mInstr.countDrawCall();  mRealDC.fill(color); }
+    void clearRect(const Rect& rect) override
+        { mInstr.countDrawCall();  mRealDC.clearRect(rect); }
+
+    void drawLines(const std::vector<Point>& lines) override
+        { mInstr.countDrawCall();  mRealDC.drawLines(lines); }
+    void drawRect(const Rect& rect, PaintMode mode) override
+        { mInstr.countDrawCall();  mRealDC.drawRect(rect, mode); }
+    void drawRoundedRect(const Rect& rect, const PicaPt& radius, PaintMode mode) override
+        { mInstr.countDrawCall();  mRealDC.drawRoundedRect(rect, radius, mode); }
+    void drawEllipse(const Rect& rect, PaintMode mode) override
+        { mInstr.countDrawCall();  mRealDC.drawEllipse(rect, mode); }
+    void drawPath(std::shared_ptr<BezierPath> path, PaintMode mode) override
+        { mInstr.countDrawCall();  mRealDC.drawPath(path, mode); }
+    void drawLinearGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                const Point& start, const Point& end) override
+        { mInstr.countDrawCall();  mRealDC.drawLinearGradientPath(path, gradient, start, end); }
+    void drawRadialGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                const Point& center, const PicaPt& startRadius,
+                                const PicaPt& endRadius) override
+    {
+        mInstr.countDrawCall();
+        mRealDC.drawRadialGradientPath(path, gradient, center, startRadius, endRadius);
+    }
+    void drawText(const char *textUTF8, const Point& topLeft, const Font& font, PaintMode mode) override
+        { mInstr.countDrawCall();  mRealDC.drawText(textUTF8, topLeft, font, mode); }
+    void drawText(const TextLayout& layout, const Point& topLeft) override
+        { mInstr.countDrawCall();  mRealDC.drawText(layout, topLeft); }
+    void drawImage(std::shared_ptr<DrawableImage> image, const Rect& destRect) override
+        { mInstr.countDrawCall();  mRealDC.drawImage(image, destRect); }
+
+    void clipToRect(const Rect& rect) override { mRealDC.clipToRect(rect); }
+    void clipToPath(std::shared_ptr<BezierPath> path) override { mRealDC.clipToPath(path); }
+
+    Color pixelAt(int x, int y) override { return mRealDC.pixelAt(x, y); }
+    std::shared_ptr<DrawableImage> copyToImage() override { return mRealDC.copyToImage(); }
+    Font::Metrics fontMetrics(const Font& font) const override { return mRealDC.fontMetrics(font); }
+    TextMetrics textMetrics(const char *textUTF8, const Font& font,
+                                PaintMode mode = kPaintFill) const override
+        { return mRealDC.textMetrics(textUTF8, font, mode); }
+    void calcContextPixel(const Point& point, float *x, float *y) override
+        { mRealDC.calcContextPixel(point, x, y); }
+};
+
+std::string jsonEscaped(const std::string& s)
+{
+    std::string escaped;
+    escaped.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+            case '"':  escaped += "\\\"";  break;
+            case '\\': escaped += "\\\\";  break;
+            case '\n': escaped += "\\n";  break;
+            case '\r': escaped += "\\r";  break;
+            case '\t': escaped += "\\t";  break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", int(c));
+                    escaped += buf;
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+}  // namespace
+
+struct Instrumentation::Impl
+{
+    std::deque<FrameRecord> frames;
+    size_t maxFrames = kDefaultMaxFrames;
+
+    // Widget calls in progress, innermost last. The time spent in children
+    // is accumulated so that it can be subtracted to get the exclusive time.
+    struct ActiveCall {
+        const Widget *widget;
+        double startTime;
+        double childSecs;
+    };
+    std::vector<ActiveCall> drawCalls;
+    std::vector<ActiveCall> layoutCalls;
+    std::unordered_map<const Widget*, WidgetProfile> widgetProfiles;
+
+    // Input that caused a window to be redrawn. It waits for the window's
+    // next frame, and then for that frame to be presented.
+    struct PendingInput {
+        InputType type;
+        double time;
+    };
+    struct PendingWindowInput {
+        std::vector<PendingInput> awaitingFrame;
+        std::vector<PendingInput> awaitingPresent;
+        double frameEndTime = 0.0;
+    };
+    std::unordered_map<const Window*, PendingWindowInput> pendingInput;
+    LatencyHistogram latencies[kNInputTypes];
+
+    void addLatency(InputType type, double secs)
+    {
+        auto &h = this->latencies[int(type)];
+        if (h.counts.empty()) {
+            for (auto ms : kLatencyBucketsMs) {
+                h.bucketUpperSecs.push_back(ms / 1000.0);
+            }
+            h.bucketUpperSecs.push_back(std::numeric_limits<double>::infinity());
+            h.counts.resize(h.bucketUpperSecs.size(), 0);
+        }
+
+        secs = std::max(0.0, secs);
+        auto it = std::lower_bound(h.bucketUpperSecs.begin(), h.bucketUpperSecs.end(), secs);
+        h.counts[it - h.bucketUpperSecs.begin()] += 1;
+        h.minSecs = (h.n == 0 ? secs : std::min(h.minSecs, secs));
+        h.maxSecs = std::max(h.maxSecs, secs);
+        h.totalSecs += secs;
+        h.n += 1;
+    }
+
+    void commitPresented(PendingWindowInput& pending, double presentTime)
+    {
+        for (auto &input : pending.awaitingPresent) {
+            addLatency(input.type, presentTime - input.time);
+        }
+        pending.awaitingPresent.clear();
+    }
+
+    // Platforms that present separately call addPresentTime(); on the others
+    // the frame is presented when it finishes drawing.
+    void commitAllPresented()
+    {
+        for (auto &wp : this->pendingInput) {
+            commitPresented(wp.second, wp.second.frameEndTime);
+        }
+    }
+
+    std::unique_ptr<InputTrace> inputTrace;  // while recording input
+    std::unordered_map<const Window*, int> inputWindows;  // index in inputTrace->windows
+    double inputStartTime = 0.0;
+
+    InputTrace::Event& addInputEvent(const Window& w, InputTrace::Event::Type type)
+    {
+        auto it = this->inputWindows.find(&w);
+        if (it == this->inputWindows.end()) {
+            auto dpi = w.screen().osScreen().dpi;
+            this->inputTrace->windows.push_back({ w.title(), w.contentRect().size(), dpi });
+            int idx = int(this->inputTrace->windows.size()) - 1;
+            it = this->inputWindows.insert({ &w, idx }).first;
+        }
+
+        this->inputTrace->events.emplace_back();
+        auto &e = this->inputTrace->events.back();
+        e.type = type;
+        e.time = Application::instance().microTime() - this->inputStartTime;
+        e.window = it->second;
+        return e;
+    }
+
+    WidgetProfile& profileFor(const Widget *w)
+    {
+        auto it = this->widgetProfiles.find(w);
+        if (it == this->widgetProfiles.end()) {
+            WidgetProfile p = { w, typeid(*w).name(), 0.0, 0.0, 0.0, 0.0, 0, 0 };
+            it = this->widgetProfiles.insert({ w, p }).first;
+        }
+        return it->second;
+    }
+
+    void trim()
+    {
+        while (this->frames.size() > this->maxFrames) {
+            this->frames.pop_front();
+        }
+    }
+};
+
+Instrumentation::Instrumentation()
+    : mImpl(new Impl())
+{
+}
+
+Instrumentation::~Instrumentation()
+{
+    if (gEnabledInstrumentation == this) {
+        gEnabledInstrumentation = nullptr;
+    }
+    if (gWidgetProfiler == this) {
+        gWidgetProfiler = nullptr;
+    }
+}
+
+void Instrumentation::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+    if (enabled) {
+        gEnabledInstrumentation = this;
+    } else if (gEnabledInstrumentation == this) {
+        gEnabledInstrumentation = nullptr;
+    }
+}
+
+Instrumentation* Instrumentation::enabledInstance() { return gEnabledInstrumentation; }
+
+size_t Instrumentation::maxFrames() const { return mImpl->maxFrames; }
+
+void Instrumentation::setMaxFrames(size_t n)
+{
+    mImpl->maxFrames = n;
+    mImpl->trim();
+}
+
+std::vector<FrameRecord> Instrumentation::recentFrames() const
+{
+    return std::vector<FrameRecord>(mImpl->frames.begin(), mImpl->frames.end());
+}
+
+void Instrumentation::clear()
+{
+    mImpl->frames.clear();
+    mImpl->pendingInput.clear();
+    for (auto &h : mImpl->latencies) {
+        h = LatencyHistogram();
+    }
+}
+
+LatencyHistogram Instrumentation::inputLatency(InputType type) const
+{
+    mImpl->commitAllPresented();
+    return mImpl->latencies[int(type)];
+}
+
+std::unique_ptr<DrawContext> Instrumentation::countingDrawContext(DrawContext& dc)
+{
+    return std::make_unique<CountingDrawContext>(dc, *this);
+}
+
+void Instrumentation::addFrame(const FrameRecord& frame)
+{
+    mImpl->frames.push_back(frame);
+    mImpl->trim();
+
+    auto it = mImpl->pendingInput.find(frame.window);
+    if (it != mImpl->pendingInput.end()) {
+        auto &pending = it->second;
+        mImpl->commitPresented(pending, pending.frameEndTime);
+        std::swap(pending.awaitingPresent, pending.awaitingFrame);
+        pending.frameEndTime = frame.startTime + frame.layoutSecs + frame.focusRingSecs + frame.drawSecs;
+    }
+}
+
+void Instrumentation::addPresentTime(const Window *window, double secs)
+{
+    for (auto it = mImpl->frames.rbegin();  it != mImpl->frames.rend();  ++it) {
+        if (it->window == window) {
+            it->presentSecs += secs;
+            break;
+        }
+    }
+
+    auto it = mImpl->pendingInput.find(window);
+    if (it != mImpl->pendingInput.end()) {
+        it->second.frameEndTime += secs;
+        mImpl->commitPresented(it->second, it->second.frameEndTime);
+    }
+}
+
+void Instrumentation::addInputAwaitingFrame(const Window *window, InputType type, double eventTime)
+{
+    mImpl->pendingInput[window].awaitingFrame.push_back({ type, eventTime });
+}
+
+Instrumentation* Instrumentation::widgetProfiler() { return gWidgetProfiler; }
+
+void Instrumentation::setProfilingWidgets(bool profile)
+{
+    mProfilingWidgets = profile;
+    if (profile) {
+        gWidgetProfiler = this;
+    } else {
+        if (gWidgetProfiler == this) {
+            gWidgetProfiler = nullptr;
+        }
+        clearWidgetProfiles();
+    }
+    if (mShowsHeatmap) {
+        for (auto *w : Application::instance().windows()) {
+            w->setNeedsDraw();
+        }
+    }
+}
+
+std::vector<WidgetProfile> Instrumentation::widgetProfiles() const
+{
+    std::vector<WidgetProfile> profiles;
+    profiles.reserve(mImpl->widgetProfiles.size());
+    for (auto &wp : mImpl->widgetProfiles) {
+        profiles.push_back(wp.second);
+    }
+    std::sort(profiles.begin(), profiles.end(),
+              [](const WidgetProfile& a, const WidgetProfile& b) {
+        return a.exclusiveSecs() > b.exclusiveSecs();
+    });
+    return profiles;
+}
+
+const WidgetProfile* Instrumentation::widgetProfile(const Widget *w) const
+{
+    auto it = mImpl->widgetProfiles.find(w);
+    if (it != mImpl->widgetProfiles.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+void Instrumentation::clearWidgetProfiles()
+{
+    mImpl->widgetProfiles.clear();
+    // Do not clear the active calls, we might be inside them.
+}
+
+void Instrumentation::setShowsHeatmap(bool show)
+{
+    if (show != mShowsHeatmap) {
+        mShowsHeatmap = show;
+        for (auto *w : Application::instance().windows()) {
+            w->setNeedsDraw();
+        }
+    }
+}
+
+void Instrumentation::beginWidgetCall(const Widget *w, WidgetCall call)
+{
+    auto &calls = (call == WidgetCall::kDraw ? mImpl->drawCalls : mImpl->layoutCalls);
+    calls.push_back({ w, now(), 0.0 });
+}
+
+void Instrumentation::endWidgetCall(WidgetCall call)
+{
+    auto &calls = (call == WidgetCall::kDraw ? mImpl->drawCalls : mImpl->layoutCalls);
+    if (calls.empty()) {  // profiling was turned on during the call
+        return;
+    }
+
+    auto active = calls.back();
+    calls.pop_back();
+    auto inclusive = now() - active.startTime;
+    if (!calls.empty()) {
+        calls.back().childSecs += inclusive;
+    }
+
+    if (!active.widget) {  // deleted during the call
+        return;
+    }
+    auto &profile = mImpl->profileFor(active.widget);
+    if (call == WidgetCall::kDraw) {
+        profile.drawInclusiveSecs += inclusive;
+        profile.drawExclusiveSecs += inclusive - active.childSecs;
+        profile.nDraws += 1;
+    } else {
+        profile.layoutInclusiveSecs += inclusive;
+        profile.layoutExclusiveSecs += inclusive - active.childSecs;
+        profile.nLayouts += 1;
+    }
+}
+
+void Instrumentation::removeWidget(const Widget *w)
+{
+    mImpl->widgetProfiles.erase(w);
+    for (auto *calls : { &mImpl->drawCalls, &mImpl->layoutCalls }) {
+        for (auto &c : *calls) {
+            if (c.widget == w) {
+                c.widget = nullptr;
+            }
+        }
+    }
+}
+
+void Instrumentation::drawWidgetHeatmap(const Window& w, DrawContext& dc, const Rect& drawRect,
+                                        const Font& font)
+{
+    double maxSecs = 0.0;
+    for (auto &wp : mImpl->widgetProfiles) {
+        if (wp.first->window() == &w) {
+            maxSecs = std::max(maxSecs, wp.second.exclusiveSecs());
+        }
+    }
+    if (maxSecs <= 0.0) {
+        return;
+    }
+
+    auto margin = dc.ceilToNearestPixel(PicaPt(1.0f));
+    for (auto &wp : mImpl->widgetProfiles) {
+        auto *widget = wp.first;
+        if (widget->window() != &w || !widget->visible()) {
+            continue;
+        }
+        auto ul = widget->convertToWindowFromLocal(Point::kZero);
+        Rect r(ul.x, ul.y, widget->frame().width, widget->frame().height);
+        if (!r.intersects(drawRect)) {
+            continue;
+        }
+
+        auto heat = float(wp.second.exclusiveSecs() / maxSecs);
+        dc.setFillColor(Color(heat, 1.0f - heat, 0.0f, 0.15f + 0.35f * heat));
+        dc.drawRect(r, kPaintFill);
+        dc.setFillColor(Color(0.0f, 0.0f, 0.0f, 0.85f));
+        dc.drawText(std::to_string(wp.second.nDraws).c_str(), Point(r.x + margin, r.y + margin),
+                    font, kPaintFill);
+    }
+}
+
+void Instrumentation::startRecordingInput()
+{
+    mImpl->inputTrace = std::make_unique<InputTrace>();
+    mImpl->inputWindows.clear();
+    // Use the application's clock, so that a trace recorded headless has
+    // the virtual times, and replays identically.
+    mImpl->inputStartTime = Application::instance().microTime();
+    mRecordingInput = true;
+}
+
+InputTrace Instrumentation::stopRecordingInput()
+{
+    InputTrace trace;
+    if (mImpl->inputTrace) {
+        trace = std::move(*mImpl->inputTrace);
+        mImpl->inputTrace.reset();
+    }
+    mImpl->inputWindows.clear();
+    mRecordingInput = false;
+    return trace;
+}
+
+void Instrumentation::recordMouse(const Window& w, const MouseEvent& e)
+{
+    auto &mouse = mImpl->addInputEvent(w, InputTrace::Event::Type::kMouse).mouse;
+    mouse = e;
+    mouse.history = nullptr;  // only valid during the call
+}
+
+void Instrumentation::recordKey(const Window& w, const KeyEvent& e)
+{
+    mImpl->addInputEvent(w, InputTrace::Event::Type::kKey).key = e;
+}
+
+void Instrumentation::recordText(const Window& w, const TextEvent& e)
+{
+    mImpl->addInputEvent(w, InputTrace::Event::Type::kText).text = e;
+}
+
+void Instrumentation::recordResize(const Window& w, const Size& contentSize, float dpi)
+{
+    auto &e = mImpl->addInputEvent(w, InputTrace::Event::Type::kResize);
+    e.contentSize = contentSize;
+    e.dpi = dpi;
+}
+
+void Instrumentation::removeWindow(const Window *w)
+{
+    // A new window could be allocated at the same address, and it needs to
+    // be a different window in the trace.
+    mImpl->inputWindows.erase(w);
+
+    auto it = mImpl->pendingInput.find(w);
+    if (it != mImpl->pendingInput.end()) {
+        mImpl->commitPresented(it->second, it->second.frameEndTime);
+        mImpl->pendingInput.erase(it);
+    }
+}
+
+std::string Instrumentation::chromeTraceJSON() const
+{
+    // Each window is a "thread", and each phase of the frame is a complete
+    // ("X") event. Timestamps are in microseconds.
+    std::vector<const Window*> windows;
+    auto tidFor = [&windows](const Window *w) {
+        for (size_t i = 0;  i < windows.size();  ++i) {
+            if (windows[i] == w) {
+                return int(i) + 1;
+            }
+        }
+        windows.push_back(w);
+        return int(windows.size());
+    };
+
+    std::stringstream json;
+    bool isFirst = true;
+    auto addEvent = [&json, &isFirst](const std::string& event) {
+        json << (isFirst ? "\n  " : ",\n  ") << event;
+        isFirst = false;
+    };
+    auto completeEvent = [](const char *name, int tid, double start, double secs) {
+        std::stringstream e;
+        e.precision(15);
+        e << "{\"name\": \"" << name << "\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+          << ", \"ts\": " << (start * 1e6) << ", \"dur\": " << (secs * 1e6) << "}";
+        return e.str();
+    };
+
+    json.precision(15);
+    json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (auto &f : mImpl->frames) {
+        auto nWindowsBefore = windows.size();
+        int tid = tidFor(f.window);
+        if (windows.size() != nWindowsBefore) {
+            std::stringstream e;
+            e << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+              << ", \"args\": {\"name\": \"" << jsonEscaped(f.windowTitle) << "\"}}";
+            addEvent(e.str());
+        }
+
+        if (f.eventSecs > 0.0) {
+            addEvent(completeEvent("events", tid, f.startTime - f.eventSecs, f.eventSecs));
+        }
+        auto total = f.layoutSecs + f.focusRingSecs + f.drawSecs + f.presentSecs;
+        std::stringstream frame;
+        frame.precision(15);
+        frame << "{\"name\": \"frame " << f.frameNumber << "\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+              << ", \"ts\": " << (f.startTime * 1e6) << ", \"dur\": " << (total * 1e6)
+              << ", \"args\": {\"preferredSize\": " << f.nPreferredSizeCalls
+              << ", \"textLayouts\": " << f.nTextLayouts
+              << ", \"drawCalls\": " << f.nDrawCalls << "}}";
+        addEvent(frame.str());
+        auto t = f.startTime;
+        addEvent(completeEvent("layout", tid, t, f.layoutSecs));
+        t += f.layoutSecs;
+        addEvent(completeEvent("focus ring", tid, t, f.focusRingSecs));
+        t += f.focusRingSecs;
+        addEvent(completeEvent("draw", tid, t, f.drawSecs));
+        t += f.drawSecs;
+        if (f.presentSecs > 0.0) {
+            addEvent(completeEvent("present", tid, t, f.presentSecs));
+        }
+    }
+    json << "\n]}\n";
+    return json.str();
+}
+
+bool Instrumentation::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out << chromeTraceJSON();
+    return bool(out);
+}
+
+double LatencyHistogram::percentileSecs(double p) const
+{
+    if (n == 0) {
+        return 0.0;
+    }
+
+    // The pth percentile is the value that p% of the latencies are <=.
+    auto rank = int(std::ceil(std::min(100.0, std::max(0.0, p)) / 100.0 * double(n)));
+    rank = std::max(1, rank);
+    int sum = 0;
+    for (size_t i = 0;  i < counts.size();  ++i) {
+        sum += counts[i];
+        if (sum >= rank) {
+            return std::min(bucketUpperSecs[i], maxSecs);
+        }
+    }
+    return maxSecs;
+}
+
+double Instrumentation::now()  // static
+{
+    auto t = std::chrono::steady_clock::now().time_since_epoch();
+    return double(std::chrono::duration_cast<std::chrono::microseconds>(t).count()) / 1e6;
+}
+
+}  // namespace uitk
@@ -0,0 +1,256 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 - 2024 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_INSTRUMENTATION_H
+#define UITK_INSTRUMENTATION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uitk {
+
+class DrawContext;
+class Font;
+struct InputTrace;
+struct KeyEvent;
+struct MouseEvent;
+struct Rect;
+struct Size;
+struct TextEvent;
+class Widget;
+class Window;
+
+/// Where the time of one frame of a window went. Times are in seconds, and
+/// startTime is on the same clock as Instrumentation::now().
+struct FrameRecord
+{
+    const Window *window;  /// this is a ref, and may no longer exist
+    std::string windowTitle;
+    unsigned long frameNumber;  /// counts the window's frames
+    double startTime;
+    double eventSecs;  /// handling mouse/key/text events since the window's previous frame
+    double layoutSecs;
+    double focusRingSecs;  /// finding the focused widget's frame for the focus ring
+    double drawSecs;  /// drawing the widgets, excluding layout and focus ring
+    double presentSecs;  /// copying to the screen, if the platform does it separately
+    int nPreferredSizeCalls;  /// preferredSize() calls made through cachedPreferredSize()
+    int nTextLayouts;  /// text layouts created during the frame
+    int nDrawCalls;  /// drawing operations (shapes, paths, text, images)
+};
+
+/// The time spent in one widget's draw() and layout(), in seconds, since
+/// profiling started. Inclusive times include the widget's children;
+/// exclusive times do not.
+struct WidgetProfile
+{
+    const Widget *widget;  /// this is a ref
+    std::string typeName;
+    double drawInclusiveSecs;
+    double drawExclusiveSecs;
+    double layoutInclusiveSecs;
+    double layoutExclusiveSecs;
+    int nDraws;
+    int nLayouts;
+
+    double exclusiveSecs() const { return drawExclusiveSecs + layoutExclusiveSecs; }
+};
+
+/// Histogram of the latency from input events until the frame showing their
+/// effect is presented, in seconds.
+struct LatencyHistogram
+{
+    /// counts[i] is the number of latencies <= bucketUpperSecs[i] (and larger
+    /// than the previous bucket's). The last bucket has no upper bound, and
+    /// its bucketUpperSecs is infinity.
+    std::vector<double> bucketUpperSecs;
+    std::vector<int> counts;
+    int n = 0;
+    double minSecs = 0.0;
+    double maxSecs = 0.0;
+    double totalSecs = 0.0;
+
+    double meanSecs() const { return (n > 0 ? totalSecs / double(n) : 0.0); }
+
+    /// Returns the upper bound of the bucket that the pth percentile (0 - 100)
+    /// is in, so the actual value is never larger (maxSecs is returned for
+    /// the last bucket). Returns 0 if there are no latencies.
+    double percentileSecs(double p) const;
+};
+
+/// Opt-in per-frame instrumentation, to find out where the time goes in a
+/// frame without needing a profiler. When enabled, each window's frames are
+/// recorded into a ring buffer of the most recent frames, which can be read
+/// with recentFrames() or saved with writeChromeTrace() and viewed in
+/// chrome://tracing or https://ui.perfetto.dev. Counting the text layouts and
+/// draw calls adds a small cost to each drawing call, so this is off by
+/// default. Setting the environment variable UITK_FRAME_TRACE to a path
+/// enables instrumentation on startup and writes the trace to the path when
+/// the Application is destroyed.
+class Instrumentation
+{
+public:
+    Instrumentation();
+    ~Instrumentation();
+
+    bool isEnabled() const { return mEnabled; }
+    void setEnabled(bool enabled);
+    /// Returns the instrumentation that is enabled, or nullptr if none is.
+    /// Like widgetProfiler(), this is for code that counts things on every
+    /// call and may run without an Application (such as measuring layouts).
+    static Instrumentation* enabledInstance();
+
+    /// The number of frames kept (across all windows). Default is 600.
+    size_t maxFrames() const;
+    void setMaxFrames(size_t n);
+
+    /// Returns the recorded frames, oldest first.
+    std::vector<FrameRecord> recentFrames() const;
+    /// Clears the recorded frames and the input latencies.
+    void clear();
+
+    enum class InputType { kMouse = 0, kKey, kText };
+
+    /// Returns the histogram of the latencies of the input type, while
+    /// enabled. The latency of an event is from its timestamp (see
+    /// MouseEvent::time) until the frame that it caused to be drawn was
+    /// presented; events that did not need anything redrawn are not included.
+    /// On platforms where the OS presents the window after drawing, the time
+    /// that drawing finished is used, so the OS's compositing is not included.
+    LatencyHistogram inputLatency(InputType type) const;
+
+    /// Returns the recorded frames in the Chrome trace event JSON format.
+    std::string chromeTraceJSON() const;
+    /// Writes chromeTraceJSON() to the file, returning false on failure.
+    bool writeChromeTrace(const std::string& path) const;
+
+    /// Returns the time in seconds that measurements are made with. Only
+    /// differences are meaningful. Unlike Application::microTime() this is
+    /// always real time, even when the application is headless and
+    /// microTime() is a virtual clock.
+    static double now();
+
+    /// Times each widget's draw() and layout(). This is for debugging, and
+    /// is independent of isEnabled(). Widget::debugDescription() includes
+    /// the times while this is on. Turning it off clears the profiles.
+    bool isProfilingWidgets() const { return mProfilingWidgets; }
+    void setProfilingWidgets(bool profile);
+    /// Returns the instrumentation that is profiling widgets, or nullptr if
+    /// none is. Widgets check this rather than the Application, since it is
+    /// cheaper on every draw and layout, and a widget may be destroyed after
+    /// the Application is.
+    static Instrumentation* widgetProfiler();
+
+    /// Returns the widget profiles, most exclusive time first.
+    std::vector<WidgetProfile> widgetProfiles() const;
+    /// Returns the profile of the widget, or nullptr if it has none.
+    const WidgetProfile* widgetProfile(const Widget *w) const;
+    void clearWidgetProfiles();
+
+    /// Draws a heatmap over each window while profiling widgets: each widget
+    /// is tinted from green to red by its exclusive time relative to the
+    /// most expensive widget in the window, and labeled with the number of
+    /// times it has been drawn. (The overlay is only drawn in the areas
+    /// being redrawn.)
+    bool showsHeatmap() const { return mShowsHeatmap; }
+    void setShowsHeatmap(bool show);
+
+    /// Records the input that the windows receive, to be replayed later with
+    /// InputReplayer (see InputTrace.h). This is independent of isEnabled().
+    bool isRecordingInput() const { return mRecordingInput; }
+    void startRecordingInput();
+    /// Stops recording and returns what was recorded.
+    InputTrace stopRecordingInput();
+
+public:
+    // These are for the library, they are not useful to call directly.
+    void countPreferredSize() { mCounts.preferredSize += 1; }
+    void countTextLayout() { mCounts.textLayouts += 1; }
+    void countDrawCall() { mCounts.drawCalls += 1; }
+
+    struct Counts {
+        int preferredSize = 0;
+        int textLayouts = 0;
+        int drawCalls = 0;
+    };
+    const Counts& counts() const { return mCounts; }
+
+    /// Returns a DrawContext that draws into dc and counts the text layouts
+    /// and draw calls.
+    std::unique_ptr<DrawContext> countingDrawContext(DrawContext& dc);
+    void addFrame(const FrameRecord& frame);
+    /// Adds the present time to the most recent frame of the window.
+    void addPresentTime(const Window *window, double secs);
+    /// The event caused the window to need drawing; its latency is measured
+    /// when the window's next frame is presented.
+    void addInputAwaitingFrame(const Window *window, InputType type, double eventTime);
+
+    enum class WidgetCall { kDraw, kLayout };
+    void beginWidgetCall(const Widget *w, WidgetCall call);
+    void endWidgetCall(WidgetCall call);
+    void removeWidget(const Widget *w);
+    /// Draws the heatmap of the window's widgets that intersect drawRect.
+    /// The context should be in window coordinates.
+    void drawWidgetHeatmap(const Window& w, DrawContext& dc, const Rect& drawRect, const Font& font);
+
+    void recordMouse(const Window& w, const MouseEvent& e);
+    void recordKey(const Window& w, const KeyEvent& e);
+    void recordText(const Window& w, const TextEvent& e);
+    void recordResize(const Window& w, const Size& contentSize, float dpi);
+    void removeWindow(const Window *w);
+
+    /// Times the call for the widget profile, if profiling widgets.
+    class ScopedWidgetCall
+    {
+    public:
+        ScopedWidgetCall(const Widget *w, WidgetCall call)
+            : mInstr(widgetProfiler()), mCall(call)
+        {
+            if (mInstr) {
+                mInstr->beginWidgetCall(w, call);
+            }
+        }
+        ~ScopedWidgetCall()
+        {
+            if (mInstr) {
+                mInstr->endWidgetCall(mCall);
+            }
+        }
+
+    private:
+        Instrumentation *mInstr;
+        WidgetCall mCall;
+    };
+
+private:
+    bool mEnabled = false;
+    bool mProfilingWidgets = false;
+    bool mShowsHeatmap = false;
+    bool mRecordingInput = false;
+    Counts mCounts;
+
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace uitk
+#endif // UITK_INSTRUMENTATION_H
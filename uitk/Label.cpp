@@ -163,6 +163,7 @@ Label* Label::setWordWrapEnabled(bool enabled)
     mImpl->wordWrap = enabled;
     mImpl->clearPreferredSize();
     mImpl->clearLayout();
+    setNeedsLayout();
     setNeedsDraw();
     return this;
 }
@@ -199,6 +200,7 @@ Label* Label::setFont(const Font& font)
     mImpl->text.setFont(font);
     mImpl->clearPreferredSize();
     mImpl->clearLayout();
+    setNeedsLayout();
     setNeedsDraw();
     return this;
 }
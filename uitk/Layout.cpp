@@ -34,7 +34,7 @@ namespace {
 
 Size getRequestedSize(Widget *w, const LayoutContext& context)
 {
-    auto pref = w->preferredSize(context);
+    auto pref = w->cachedPreferredSize(context);
     float fixedWidthEm = w->fixedWidthEm();
     float fixedHeightEm = w->fixedHeightEm();
     if (fixedWidthEm > 0.0f) {
@@ -634,7 +634,7 @@ struct GridLayout::Impl
             auto h = PicaPt::kZero;
             for (size_t c = 0;  c < row.size();  ++c) {
                 if (row[c]) {
-                    auto pref = row[c]->preferredSize(context.withWidth(colSizes[c]));
+                    auto pref = row[c]->cachedPreferredSize(context.withWidth(colSizes[c]));
                     h = std::max(h, context.dc.ceilToNearestPixel(pref.height));
                     prefsConstrained[r].push_back(pref);
                 }
@@ -27,9 +27,14 @@
 #include "UIContext.h"
 #include "Window.h"
 #include "themes/Theme.h"
+#include "private/IndexRangeSet.h"
+#include "private/RowHeightIndex.h"
 
 #include <nativedraw.h>
 
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
 #include <unordered_set>
 
 namespace uitk {
@@ -37,6 +42,9 @@ namespace uitk {
 namespace {
 
 static const PicaPt kUnsetPadding(-10000.0f);
+// Number of rows above and below the visible rows to keep cells for when
+// using a data source, so that scrolling a little does not need new cells.
+static const int kOverscanRows = 8;
 
 uitk::Size calcPadding(const uitk::LayoutContext& context, const Size& userPadding)
 {
@@ -73,7 +81,7 @@ PicaPt layoutItems(const uitk::LayoutContext& context, LayoutMode mode,
     auto x = padding.width; // inset a little left and right in case cell draw bg and obscures the selection
     auto y = padding.height;
     for (auto *child : children) {
-        auto pref = child->preferredSize(contextWithWidth);
+        auto pref = child->cachedPreferredSize(contextWithWidth);
         if (mode == LayoutMode::kLayout) {
             if (pref.height < Widget::kDimGrow) {
                 child->setFrame(Rect(x, y, width, pref.height));
@@ -87,6 +95,71 @@ PicaPt layoutItems(const uitk::LayoutContext& context, LayoutMode mode,
     return y + padding.height;
 }
 
+// The rows of a ListView with a DataSource. Only the rows near the visible area
+// have cells: visibleCells[i] displays row firstRow + i.
+struct DataSourceRows
+{
+    ListView::DataSource source;
+    int nRows = 0;
+    PicaPt fixedHeight;  // if source.rowHeight is not set
+    RowHeightIndex heights;  // if source.rowHeight is set
+    float loadedDPI = 0.0f;
+    bool needsReload = true;
+
+    int firstRow = 0;
+    std::vector<ListViewCell*> visibleCells;  // content owns these
+    std::vector<ListViewCell*> spareCells;  // hidden, content owns these
+
+    bool hasFixedHeight() const { return !this->source.rowHeight; }
+
+    // Returns the y coordinate of the row relative to the top of the first row.
+    // Passing nRows returns the total height.
+    PicaPt rowY(int row) const
+    {
+        if (hasFixedHeight()) {
+            return float(row) * this->fixedHeight;
+        }
+        return this->heights.offset(row);
+    }
+
+    PicaPt rowHeight(int row) const
+    {
+        if (hasFixedHeight()) {
+            return this->fixedHeight;
+        }
+        return this->heights.height(row);
+    }
+
+    PicaPt totalHeight() const { return rowY(this->nRows); }
+
+    // Returns the row at y (relative to the top of the first row), clamped to
+    // the existing rows, or -1 if there are no rows.
+    int rowAtY(const PicaPt& y) const
+    {
+        if (this->nRows <= 0) {
+            return -1;
+        }
+        int row = 0;
+        if (hasFixedHeight()) {
+            if (this->fixedHeight > PicaPt::kZero) {
+                row = int(std::floor(y.asFloat() / this->fixedHeight.asFloat()));
+            }
+        } else {
+            row = this->heights.rowAt(y);
+        }
+        return std::max(0, std::min(this->nRows - 1, row));
+    }
+
+    ListViewCell* cellForRow(int row) const
+    {
+        int idx = row - this->firstRow;
+        if (idx >= 0 && idx < int(this->visibleCells.size())) {
+            return this->visibleCells[idx];
+        }
+        return nullptr;
+    }
+};
+
 } // namespace
 
 //-----------------------------------------------------------------------------
@@ -96,15 +169,140 @@ struct ListView::Impl
     Size contentPadding = Size(kUnsetPadding, kUnsetPadding);
     SelectionMode selectionMode = SelectionMode::kSingleItem;
     bool keyNavigationWraps = false;
-    std::unordered_set<int> selectedIndices;
+    IndexRangeSet selection;
     std::function<void(ListView*)> onChanged;
     std::function<void(ListView*, int)> onDblClicked;
     int mouseOverIndex = -1;
     int lastClickedRow = 0;
+    std::unique_ptr<DataSourceRows> rows;  // only if using a data source
+    Size layoutPadding;
+    bool inLayout = false;
+    int updateDepth = 0;
+    int firstChangedRow = -1;  // rows >= this changed since beginUpdates(); -1 if none
+    std::vector<Widget*> pendingCells;  // added during beginUpdates()
+
+    // In cell mode the cells are the content's children followed by the
+    // pendingCells. Cells added during an update are buffered so that they
+    // can all be added with one layout by addPendingCells(); until then they
+    // count as rows but have not been laid out.
+    int nCells() const
+    {
+        return int(this->content->children().size() + this->pendingCells.size());
+    }
+
+    Widget* cellAt(int idx) const
+    {
+        auto &childs = this->content->children();
+        if (idx < int(childs.size())) {
+            return childs[idx];
+        }
+        return this->pendingCells[idx - int(childs.size())];
+    }
+
+    void addPendingCells()
+    {
+        if (!this->pendingCells.empty()) {
+            auto &childs = this->content->children();
+            this->content->insertChildren(int(childs.size()), this->pendingCells);
+            this->pendingCells.clear();
+        }
+    }
+
+    int nRows() const
+    {
+        return (this->rows ? this->rows->nRows : nCells());
+    }
+
+    void noteRowsChanged(int firstRow)
+    {
+        if (this->firstChangedRow < 0 || firstRow < this->firstChangedRow) {
+            this->firstChangedRow = firstRow;
+        }
+    }
+
+    // Returns nullptr if the row does not exist or does not have a cell
+    Widget* cellForRow(int row) const
+    {
+        if (this->rows) {
+            return this->rows->cellForRow(row);
+        }
+        if (row >= 0 && row < nCells()) {
+            return cellAt(row);
+        }
+        return nullptr;
+    }
+
+    // Returns the rectangle of the row in content coordinates; row must exist.
+    Rect rowRect(int row) const
+    {
+        if (this->rows) {
+            return Rect(this->layoutPadding.width,
+                        this->layoutPadding.height + this->rows->rowY(row),
+                        this->content->frame().width - 2.0f * this->layoutPadding.width,
+                        this->rows->rowHeight(row));
+        }
+        return cellAt(row)->frame();
+    }
+
+    // Returns the row containing y (in content coordinates), clamped to the
+    // existing rows, or -1 if there are no rows.
+    int rowAtY(const PicaPt& y) const
+    {
+        if (this->rows) {
+            return this->rows->rowAtY(y - this->layoutPadding.height);
+        }
+        // layout() places the cells top to bottom, so we can binary search.
+        // (Pending cells have not been placed yet.)
+        auto &childs = this->content->children();
+        if (childs.empty()) {
+            return -1;
+        }
+        auto it = std::upper_bound(childs.begin(), childs.end(), y,
+                                   [](const PicaPt& y, const Widget *w) { return y < w->frame().y; });
+        return std::max(0, int(it - childs.begin()) - 1);
+    }
+
+    bool isSelected(int row) const
+    {
+        return this->selection.contains(row);
+    }
+
+    void updateCellState(Widget *cell, int row)
+    {
+        if (isSelected(row)) {
+            cell->setThemeState(Theme::WidgetState::kSelected);
+        } else if (row == this->mouseOverIndex) {
+            cell->setThemeState(Theme::WidgetState::kMouseOver);
+        } else {
+            cell->resetThemeState();
+        }
+    }
+
+    // Updates the theme state of the cells in [first, end) that exist, so
+    // that this only costs the number of rows that have cells.
+    void updateCellStates(int first, int end)
+    {
+        if (this->rows) {
+            first = std::max(first, this->rows->firstRow);
+            end = std::min(end, this->rows->firstRow + int(this->rows->visibleCells.size()));
+        } else {
+            first = std::max(first, 0);
+            end = std::min(end, nCells());
+        }
+        for (int row = first;  row < end;  ++row) {
+            updateCellState(cellForRow(row), row);
+        }
+    }
+
+    void updateCellStates(const std::vector<IndexRangeSet::Range>& ranges)
+    {
+        for (auto &r : ranges) {
+            updateCellStates(r.first, r.end);
+        }
+    }
 
     void setMouseOverIndex(int idx)
     {
-        auto items = this->content->children();
         if (this->selectionMode == SelectionMode::kNoItems) {
             this->mouseOverIndex = -1;
             return;
@@ -112,21 +310,23 @@ struct ListView::Impl
 
         bool idxChanged = (idx != this->mouseOverIndex);
         bool stateChanged = false;
-        if (idxChanged && this->mouseOverIndex >= 0 && this->mouseOverIndex < int(items.size())) {
-            if (this->selectedIndices.find(this->mouseOverIndex) != this->selectedIndices.end()) {
-                items[this->mouseOverIndex]->setThemeState(Theme::WidgetState::kSelected);
-            } else {
-                items[this->mouseOverIndex]->setThemeState(Theme::WidgetState::kNormal);
+        if (idxChanged) {
+            if (auto *cell = cellForRow(this->mouseOverIndex)) {
+                if (isSelected(this->mouseOverIndex)) {
+                    cell->setThemeState(Theme::WidgetState::kSelected);
+                } else {
+                    cell->setThemeState(Theme::WidgetState::kNormal);
+                }
             }
         }
         this->mouseOverIndex = idx;
-        if (idx >= 0 && idx < int(items.size())) {
-            if (this->selectedIndices.find(idx) != this->selectedIndices.end()) {
-                stateChanged |= (items[idx]->themeState() == Theme::WidgetState::kSelected);
-                items[idx]->setThemeState(Theme::WidgetState::kSelected);
+        if (auto *cell = cellForRow(idx)) {
+            if (isSelected(idx)) {
+                stateChanged |= (cell->themeState() == Theme::WidgetState::kSelected);
+                cell->setThemeState(Theme::WidgetState::kSelected);
             } else {
-                stateChanged |= (items[idx]->themeState() == Theme::WidgetState::kMouseOver);
-                items[idx]->setThemeState(Theme::WidgetState::kMouseOver);
+                stateChanged |= (cell->themeState() == Theme::WidgetState::kMouseOver);
+                cell->setThemeState(Theme::WidgetState::kMouseOver);
             }
         }
         // We really want the ListView to redraw, but Impl does not know to do that.
@@ -135,6 +335,141 @@ struct ListView::Impl
             this->content->setNeedsDraw();
         }
     }
+
+    // --- data source ---
+    ListViewCell* obtainCell()
+    {
+        auto &rows = *this->rows;
+        if (!rows.spareCells.empty()) {
+            auto *cell = rows.spareCells.back();
+            rows.spareCells.pop_back();
+            cell->setVisible(true);
+            return cell;
+        }
+        auto *cell = rows.source.makeCell();
+        this->content->addChild(cell);
+        return cell;
+    }
+
+    void recycleCell(ListViewCell *cell)
+    {
+        cell->setVisible(false);
+        cell->resetThemeState();
+        this->rows->spareCells.push_back(cell);
+    }
+
+    void bindCell(ListViewCell *cell, int row)
+    {
+        this->rows->source.bindCell(cell, row);
+        updateCellState(cell, row);
+    }
+
+    void loadRows(const LayoutContext& context, const PicaPt& rowWidth)
+    {
+        auto &rows = *this->rows;
+        for (auto *cell : rows.visibleCells) {
+            recycleCell(cell);
+        }
+        rows.visibleCells.clear();
+
+        int oldNRows = rows.nRows;
+        rows.nRows = std::max(0, rows.source.nRows());
+        // Rows past the end no longer exist, so they cannot stay selected.
+        if (rows.nRows < oldNRows) {
+            this->selection.removeGap(rows.nRows, oldNRows);
+        }
+        if (this->lastClickedRow >= rows.nRows) {
+            this->lastClickedRow = 0;
+        }
+        if (rows.hasFixedHeight()) {
+            rows.heights.clear();
+            rows.fixedHeight = rows.source.fixedRowHeight;
+            if (rows.fixedHeight <= PicaPt::kZero) {
+                rows.fixedHeight = measureFirstRow(context, rowWidth);
+            }
+        } else {
+            rows.heights.reset(rows.nRows, rows.source.rowHeight);
+        }
+        rows.loadedDPI = context.dc.dpi();
+        rows.needsReload = false;
+    }
+
+    PicaPt measureFirstRow(const LayoutContext& context, const PicaPt& rowWidth)
+    {
+        auto fm = context.theme.params().labelFont.metrics(context.dc);
+        auto em = context.dc.ceilToNearestPixel(fm.ascent + fm.descent);
+        if (this->rows->nRows == 0) {
+            return em;
+        }
+
+        auto *cell = obtainCell();
+        bindCell(cell, 0);
+        auto pref = cell->preferredSize(context.withWidth(rowWidth));
+        recycleCell(cell);
+        if (pref.height > PicaPt::kZero && pref.height < Widget::kDimGrow) {
+            return context.dc.ceilToNearestPixel(pref.height);
+        }
+        return em;
+    }
+
+    // Returns the rows [first, end) that should have cells if the visible
+    // area starts at y (relative to the first row).
+    void calcRowsNeedingCells(const PicaPt& y, const PicaPt& height, int *first, int *end) const
+    {
+        auto &rows = *this->rows;
+        if (rows.nRows <= 0) {
+            *first = 0;
+            *end = 0;
+            return;
+        }
+        *first = std::max(0, rows.rowAtY(y) - kOverscanRows);
+        *end = std::min(rows.nRows, rows.rowAtY(y + height) + 1 + kOverscanRows);
+    }
+
+    bool cellsCoverArea(const PicaPt& y, const PicaPt& height) const
+    {
+        auto &rows = *this->rows;
+        if (rows.needsReload) {
+            return false;
+        }
+        if (rows.nRows <= 0) {
+            return true;
+        }
+        int first = rows.rowAtY(y);
+        int last = rows.rowAtY(y + height);
+        return (first >= rows.firstRow && last < rows.firstRow + int(rows.visibleCells.size()));
+    }
+
+    void updateVisibleCells(const PicaPt& y, const PicaPt& height)
+    {
+        auto &rows = *this->rows;
+        int newFirst, newEnd;
+        calcRowsNeedingCells(y, height, &newFirst, &newEnd);
+
+        // Keep the cells whose rows are still visible, recycle the rest, then
+        // bind the recycled cells to the newly visible rows.
+        std::vector<ListViewCell*> cells(size_t(std::max(0, newEnd - newFirst)), nullptr);
+        for (size_t i = 0;  i < rows.visibleCells.size();  ++i) {
+            int row = rows.firstRow + int(i);
+            if (row >= newFirst && row < newEnd) {
+                cells[row - newFirst] = rows.visibleCells[i];
+            } else {
+                recycleCell(rows.visibleCells[i]);
+            }
+        }
+        for (size_t i = 0;  i < cells.size();  ++i) {
+            if (!cells[i]) {
+                cells[i] = obtainCell();
+                bindCell(cells[i], newFirst + int(i));
+            }
+        }
+        rows.firstRow = newFirst;
+        rows.visibleCells.swap(cells);
+
+        for (size_t i = 0;  i < rows.visibleCells.size();  ++i) {
+            rows.visibleCells[i]->setFrame(rowRect(newFirst + int(i)));
+        }
+    }
 };
 
 ListView::ListView()
@@ -145,6 +480,9 @@ ListView::ListView()
 
 ListView::~ListView()
 {
+    for (auto *cell : mImpl->pendingCells) {
+        delete cell;
+    }
 }
 
 ListView* ListView::setOnSelectionChanged(std::function<void(ListView*)> onChanged)
@@ -170,90 +508,239 @@ ListView* ListView::setSelectionModel(SelectionMode mode)
     if (mode == SelectionMode::kNoItems) {
         clearSelection();
         mImpl->setMouseOverIndex(-1);
-        for (auto *child : mImpl->content->children()) {
+        for (int i = 0;  i < mImpl->nCells();  ++i) {
+            auto *child = mImpl->cellAt(i);
             if (child->state() != MouseState::kNormal && child->state() != MouseState::kDisabled) {
                 child->mouseExited();  // set state to normal
             }
         }
-    } else if (mode == SelectionMode::kSingleItem && mImpl->selectedIndices.size() > 1) {
-        setSelectedIndex(*mImpl->selectedIndices.begin());
+    } else if (mode == SelectionMode::kSingleItem && mImpl->selection.count() > 1) {
+        setSelectedIndex(mImpl->selection.first());
     }
     return this;
 }
 
+ListView* ListView::setDataSource(const DataSource& source)
+{
+    clearCells();
+    mImpl->rows = std::make_unique<DataSourceRows>();
+    mImpl->rows->source = source;
+    // Our preferred size does not depend on the rows, so changes to the rows
+    // (including scrolling to new rows) only need to lay us out.
+    setIsLayoutBoundary(true);
+    setNeedsLayout();
+    return this;
+}
+
+void ListView::reloadData()
+{
+    if (mImpl->rows) {
+        mImpl->setMouseOverIndex(-1);
+        mImpl->rows->needsReload = true;
+        setNeedsLayout();
+        setNeedsDraw();
+    }
+}
+
+void ListView::reloadRow(int row)
+{
+    auto *rows = mImpl->rows.get();
+    if (!rows || row < 0 || row >= rows->nRows) {
+        return;
+    }
+
+    if (!rows->hasFixedHeight() && !rows->needsReload) {
+        auto height = rows->source.rowHeight(row);
+        if (height != rows->heights.height(row)) {
+            // Only the offsets of the rows below change, which the index
+            // updates in O(log n); layout() repositions the visible cells.
+            rows->heights.setHeight(row, height);
+            setNeedsLayout();
+        }
+    }
+    if (auto *cell = rows->cellForRow(row)) {
+        mImpl->bindCell(cell, row);
+        cell->setNeedsDraw();
+    }
+}
+
 int ListView::size() const
 {
-    return int(mImpl->content->children().size());
+    return mImpl->nRows();
 }
 
 void ListView::clearCells()
 {
     clearSelection();
-    mImpl->content->clearAllChildren();
     mImpl->setMouseOverIndex(-1);
+    if (mImpl->rows) {
+        mImpl->rows.reset();
+        setIsLayoutBoundary(false);
+    }
+    for (auto *cell : mImpl->pendingCells) {
+        delete cell;
+    }
+    mImpl->pendingCells.clear();
+    mImpl->content->clearAllChildren();
     setContentOffset(Point::kZero);
 }
 
 ListView* ListView::addCell(ListViewCell *cell)
 {
-    mImpl->content->addChild(cell);
+    assert(!mImpl->rows);  // cannot add cells when using a data source
+    if (mImpl->updateDepth > 0) {
+        mImpl->noteRowsChanged(mImpl->nCells());
+        mImpl->pendingCells.push_back(cell);
+    } else {
+        mImpl->content->addChild(cell);
+    }
     return this;
 }
 
-ListView* ListView::addStringCell(const std::string& text)
+ListView* ListView::insertCells(int index, const std::vector<ListViewCell*>& cells)
 {
-    mImpl->content->addChild(new Label(text));
+    assert(!mImpl->rows);  // cannot add cells when using a data source
+    if (cells.empty()) {
+        return this;
+    }
+
+    beginUpdates();
+    mImpl->addPendingCells();
+    index = std::max(0, std::min(index, mImpl->nCells()));
+    mImpl->setMouseOverIndex(-1);
+    mImpl->selection.insertGap(index, int(cells.size()));
+    if (mImpl->lastClickedRow >= index) {
+        mImpl->lastClickedRow += int(cells.size());
+    }
+    mImpl->content->insertChildren(index, std::vector<Widget*>(cells.begin(), cells.end()));
+    mImpl->noteRowsChanged(index);
+    endUpdates();
     return this;
 }
 
-ListViewCell* ListView::cellAtIndex(int index) const
+std::vector<ListViewCell*> ListView::removeCells(int first, int end)
 {
-    auto &childs = mImpl->content->children();
-    if (index < 0 || index >= int(childs.size())) {
-        return nullptr;
+    if (mImpl->rows) {
+        assert(false);  // cannot remove cells when using a data source
+        return {};
     }
-    return static_cast<ListViewCell*>(childs[index]);
+
+    first = std::max(0, first);
+    end = std::min(end, mImpl->nCells());
+    if (first >= end) {
+        return {};
+    }
+
+    beginUpdates();
+    mImpl->addPendingCells();
+    mImpl->setMouseOverIndex(-1);
+    mImpl->selection.removeGap(first, end);
+    if (mImpl->lastClickedRow >= end) {
+        mImpl->lastClickedRow -= end - first;
+    } else if (mImpl->lastClickedRow >= first) {
+        mImpl->lastClickedRow = first;
+    }
+    auto removed = mImpl->content->removeChildren(first, end);
+    for (auto *w : removed) {
+        w->resetThemeState();
+    }
+    mImpl->noteRowsChanged(first);
+    endUpdates();
+
+    std::vector<ListViewCell*> cells;
+    cells.reserve(removed.size());
+    for (auto *w : removed) {
+        cells.push_back(static_cast<ListViewCell*>(w));
+    }
+    return cells;
 }
 
-ListViewCell* ListView::removeCellAtIndex(int index)
+void ListView::removeAllCells()
 {
-    auto& childs = mImpl->content->children();
-    if (index < 0 || index >= int(childs.size())) {
-        return nullptr;
+    removeCells(0, size());
+}
+
+void ListView::beginUpdates()
+{
+    mImpl->updateDepth += 1;
+}
+
+void ListView::endUpdates()
+{
+    assert(mImpl->updateDepth > 0);
+    mImpl->updateDepth -= 1;
+    if (mImpl->updateDepth > 0) {
+        return;
     }
 
-    clearSelection(); // changes all the indices of cells below it, so easiest to just clear
-    mImpl->setMouseOverIndex(-1);
-    auto *w = childs[index];
-    mImpl->content->removeChild(w);
-    return static_cast<ListViewCell*>(w);
+    mImpl->addPendingCells();
+    if (mImpl->firstChangedRow >= 0) {
+        // Rows after the first change may have moved, so their selection
+        // state needs to be updated.
+        mImpl->updateCellStates(mImpl->firstChangedRow, mImpl->nRows());
+        mImpl->firstChangedRow = -1;
+        setNeedsLayout();
+        setNeedsDraw();
+    }
+}
+
+ListView* ListView::addStringCell(const std::string& text)
+{
+    return addCell(new Label(text));
+}
+
+ListViewCell* ListView::cellAtIndex(int index) const
+{
+    return static_cast<ListViewCell*>(mImpl->cellForRow(index));
+}
+
+ListViewCell* ListView::removeCellAtIndex(int index)
+{
+    auto removed = removeCells(index, index + 1);
+    return (removed.empty() ? nullptr : removed[0]);
 }
 
 int ListView::selectedIndex() const
 {
-    if (mImpl->selectedIndices.empty()) {
-        return -1;
-    }
-    return *mImpl->selectedIndices.begin();
+    return mImpl->selection.first();
 }
 
 std::vector<int> ListView::selectedIndices() const
 {
     std::vector<int> selection;
-    selection.reserve(mImpl->selectedIndices.size());
-    selection.insert(selection.end(), mImpl->selectedIndices.begin(), mImpl->selectedIndices.end());
+    selection.reserve(mImpl->selection.count());
+    for (auto &r : mImpl->selection.ranges()) {
+        for (int i = r.first;  i < r.end;  ++i) {
+            selection.push_back(i);
+        }
+    }
     return selection;
 }
 
-void ListView::clearSelection()
+std::vector<ListView::RowRange> ListView::selectedRanges() const
 {
-    auto items = mImpl->content->children();
-    for (int idx : mImpl->selectedIndices) {
-        if (idx >= 0 && idx < int(items.size())) {
-            items[idx]->resetThemeState();
-        }
+    std::vector<RowRange> ranges;
+    for (auto &r : mImpl->selection.ranges()) {
+        ranges.push_back({ r.first, r.end });
     }
-    mImpl->selectedIndices.clear();
+    return ranges;
+}
+
+int ListView::nSelectedRows() const
+{
+    return mImpl->selection.count();
+}
+
+bool ListView::isRowSelected(int row) const
+{
+    return mImpl->isSelected(row);
+}
+
+void ListView::clearSelection()
+{
+    auto oldRanges = mImpl->selection.ranges();
+    mImpl->selection.clear();
+    mImpl->updateCellStates(oldRanges);
     setNeedsDraw();
 }
 
@@ -268,20 +755,51 @@ void ListView::setSelectedIndex(int index)
 
 void ListView::setSelectedIndices(const std::unordered_set<int> indices)
 {
-    auto &items = mImpl->content->children();
-    for (int idx : mImpl->selectedIndices) {
-        if (idx >= 0 && idx < int(items.size())) {
-            items[idx]->setThemeState(Theme::WidgetState::kNormal);
-        }
+    auto oldRanges = mImpl->selection.ranges();
+    mImpl->selection.clear();
+    for (int idx : indices) {
+        mImpl->selection.insert(idx);
     }
+    mImpl->updateCellStates(oldRanges);
+    mImpl->updateCellStates(mImpl->selection.ranges());
+    setNeedsDraw();
+}
+
+void ListView::selectRange(int first, int end)
+{
+    first = std::max(0, first);
+    end = std::min(end, size());
+    if (mImpl->selectionMode == SelectionMode::kNoItems || first >= end) {
+        return;
+    }
+    if (mImpl->selectionMode == SelectionMode::kSingleItem) {
+        setSelectedIndices({ first });
+        return;
+    }
+    mImpl->selection.insert(first, end);
+    mImpl->updateCellStates(first, end);
+    setNeedsDraw();
+}
+
+void ListView::deselectRange(int first, int end)
+{
+    mImpl->selection.erase(first, end);
+    mImpl->updateCellStates(first, end);
+    setNeedsDraw();
+}
 
-    mImpl->selectedIndices = indices;
+void ListView::selectAll()
+{
+    selectRange(0, size());
+}
 
-    for (int idx : mImpl->selectedIndices) {
-        if (idx >= 0 && idx < int(items.size())) {
-            items[idx]->setThemeState(Theme::WidgetState::kSelected);
-        }
+void ListView::invertSelection()
+{
+    if (mImpl->selectionMode != SelectionMode::kMultipleItems) {
+        return;
     }
+    mImpl->selection.invert(0, size());
+    mImpl->updateCellStates(0, size());
     setNeedsDraw();
 }
 
@@ -305,26 +823,24 @@ void ListView::triggerOnSelectionChanged()
 
 bool ListView::isRowVisible(int index) const
 {
-    auto &items = mImpl->content->children();
-    if (index < 0 || index >= int(items.size())) {
+    if (index < 0 || index >= mImpl->nRows()) {
         return false;
     }
     auto r = Rect(PicaPt::kZero, PicaPt::kZero, frame().width, frame().height);
     auto scrollOffset = bounds().upperLeft();
-    auto rowRect = items[index]->frame().translated(scrollOffset.x, scrollOffset.y);
+    auto rowRect = mImpl->rowRect(index).translated(scrollOffset.x, scrollOffset.y);
     return (rowRect.y >= r.y && rowRect.maxY() <= r.maxY());
 }
 
 void ListView::scrollRowVisible(int index)
 {
-    auto &items = mImpl->content->children();
-    if (index < 0 || index >= int(items.size())) {
+    if (index < 0 || index >= mImpl->nRows()) {
         return;
     }
-    auto r = items[index]->frame();
-    auto scrollOffset = items[index]->bounds().upperLeft();
+    auto r = mImpl->rowRect(index);
+    auto scrollOffset = bounds().upperLeft();
     auto minYVisible = -scrollOffset.y;
-    auto maxYVisible = r.height - scrollOffset.y;
+    auto maxYVisible = frame().height - scrollOffset.y;
     if (r.y < minYVisible || r.maxY() > maxYVisible) {
         auto newYOffset = r.midY() - 0.5f * frame().height;
         newYOffset = std::max(PicaPt::kZero, newYOffset);
@@ -335,11 +851,10 @@ void ListView::scrollRowVisible(int index)
 
 void ListView::scrollRowVisibleAtTop(int index)
 {
-    auto &items = mImpl->content->children();
-    if (index < 0 || index >= int(items.size())) {
+    if (index < 0 || index >= mImpl->nRows()) {
         return;
     }
-    auto newYOffset = items[index]->frame().minY();
+    auto newYOffset = mImpl->rowRect(index).minY();
     newYOffset = std::max(PicaPt::kZero, newYOffset);
     newYOffset = std::min(bounds().height - frame().height, newYOffset);
     setContentOffset(Point(bounds().x, -newYOffset));
@@ -347,11 +862,10 @@ void ListView::scrollRowVisibleAtTop(int index)
 
 void ListView::scrollRowVisibleAtBottom(int index)
 {
-    auto &items = mImpl->content->children();
-    if (index < 0 || index >= int(items.size())) {
+    if (index < 0 || index >= mImpl->nRows()) {
         return;
     }
-    auto newYOffset = items[index]->frame().maxY() - frame().height;
+    auto newYOffset = mImpl->rowRect(index).maxY() - frame().height;
     newYOffset = std::max(PicaPt::kZero, newYOffset);
     newYOffset = std::min(bounds().height - frame().height, newYOffset);
     setContentOffset(Point(bounds().x, -newYOffset));
@@ -371,6 +885,10 @@ ListView* ListView::setContentPadding(const PicaPt& xPadding, const PicaPt& yPad
 Size ListView::preferredContentSize(const LayoutContext& context) const
 {
     auto width = preferredSize(context).width;
+    if (mImpl->rows) {
+        auto padding = calcPadding(context, mImpl->contentPadding);
+        return Size(width, mImpl->rows->totalHeight() + 2.0f * padding.height);
+    }
     auto height = layoutItems(context, LayoutMode::kCalcHeight, frame(), mImpl->contentPadding,
                               mImpl->content->children());
     return Size(width, height);
@@ -378,13 +896,17 @@ Size ListView::preferredContentSize(const LayoutContext& context) const
 
 Size ListView::preferredSize(const LayoutContext& context) const
 {
+    if (mImpl->rows) {
+        return Size(kDimGrow, kDimGrow);  // measuring every row would defeat the purpose
+    }
+
     auto fm = context.theme.params().labelFont.metrics(context.dc);
     auto em = fm.ascent + fm.descent;
 
     auto padding = calcPadding(context, mImpl->contentPadding);
     auto width = PicaPt::kZero;
     for (auto *child : mImpl->content->children()) {
-        width = std::max(width, child->preferredSize(context).width);
+        width = std::max(width, child->cachedPreferredSize(context).width);
     }
     return Size(width + 2 * padding.width, kDimGrow);
 }
@@ -392,15 +914,42 @@ Size ListView::preferredSize(const LayoutContext& context) const
 void ListView::layout(const LayoutContext& context)
 {
     auto &f = frame();
-    auto height = layoutItems(context, LayoutMode::kLayout, f, mImpl->contentPadding,
-                              mImpl->content->children());
-    Rect contentRect(mImpl->content->frame().x, mImpl->content->frame().y, f.width, height);
-    mImpl->content->setFrame(contentRect);
-    setContentSize(Size(f.width, height));
+    if (mImpl->rows) {
+        mImpl->inLayout = true;
+        auto padding = calcPadding(context, mImpl->contentPadding);
+        mImpl->layoutPadding = padding;
+        if (mImpl->rows->needsReload || mImpl->rows->loadedDPI != context.dc.dpi()) {
+            mImpl->loadRows(context, f.width - 2.0f * padding.width);
+        }
+        auto height = mImpl->rows->totalHeight() + 2.0f * padding.height;
+        Rect contentRect(mImpl->content->frame().x, mImpl->content->frame().y, f.width, height);
+        mImpl->content->setFrame(contentRect);
+        setContentSize(Size(f.width, height));
+        mImpl->updateVisibleCells(-bounds().y - padding.height, f.height);
+        mImpl->inLayout = false;
+    } else {
+        auto height = layoutItems(context, LayoutMode::kLayout, f, mImpl->contentPadding,
+                                  mImpl->content->children());
+        Rect contentRect(mImpl->content->frame().x, mImpl->content->frame().y, f.width, height);
+        mImpl->content->setFrame(contentRect);
+        setContentSize(Size(f.width, height));
+    }
 
     Super::layout(context);
 }
 
+ListView* ListView::setBounds(const Rect& bounds)
+{
+    Super::setBounds(bounds);
+    // If scrolling brought rows without cells into view, they need to be
+    // bound, which layout() does. (layout() calls this, too.)
+    if (mImpl->rows && !mImpl->inLayout &&
+        !mImpl->cellsCoverArea(-bounds.y - mImpl->layoutPadding.height, frame().height)) {
+        setNeedsLayout();
+    }
+    return this;
+}
+
 Widget::EventResult ListView::mouse(const MouseEvent& e)
 {
     if (mImpl->selectionMode == SelectionMode::kNoItems) {
@@ -410,8 +959,8 @@ Widget::EventResult ListView::mouse(const MouseEvent& e)
     if (!isMouseInScrollbar()) {
         if (e.type == MouseEvent::Type::kButtonUp && e.button.button == MouseButton::kLeft) {
             int idx = calcRowIndex(e.pos);
-            bool isEnabled = (mImpl->content && size_t(idx) < mImpl->content->children().size() &&
-                              mImpl->content->children()[idx]->enabled());
+            auto *cell = mImpl->cellForRow(idx);
+            bool isEnabled = (cell && cell->enabled());
             if (idx >= 0 && isEnabled) {
                 bool selectionChanged = false;
                 if (mImpl->selectionMode == SelectionMode::kSingleItem) {
@@ -422,21 +971,16 @@ Widget::EventResult ListView::mouse(const MouseEvent& e)
                         setSelectedIndex(idx);
                         selectionChanged = true;
                     } else if (e.keymods == KeyModifier::kCtrl) {
-                        auto it = mImpl->selectedIndices.find(idx);
-                        if (it != mImpl->selectedIndices.end()) {
-                            mImpl->selectedIndices.erase(it);
+                        if (mImpl->isSelected(idx)) {
+                            deselectRange(idx, idx + 1);
                         } else {
-                            mImpl->selectedIndices.insert(idx);
+                            selectRange(idx, idx + 1);
                         }
-                        setSelectedIndices(mImpl->selectedIndices);
                         selectionChanged = true;
                     } else if (e.keymods == KeyModifier::kShift) {
                         int startIdx = std::min(idx, mImpl->lastClickedRow);
                         int endIdx = std::max(idx, mImpl->lastClickedRow);
-                        for (int i = startIdx;  i <= endIdx;  ++i) {
-                            mImpl->selectedIndices.insert(i);
-                        }
-                        setSelectedIndices(mImpl->selectedIndices);
+                        selectRange(startIdx, endIdx + 1);
                         selectionChanged = true;
                     }
                 }
@@ -484,12 +1028,9 @@ void ListView::mouseExited()
 int ListView::calcRowIndex(const Point& p) const
 {
     Point scrollP = p - bounds().upperLeft();
-    auto &childs = mImpl->content->children();
-    for (size_t i = 0;  i < childs.size();  ++i) {
-        if (childs[i]->frame().contains(scrollP)) {
-            auto debug = childs[i]->frame();
-            return int(i);
-        }
+    int row = mImpl->rowAtY(scrollP.y);
+    if (row >= 0 && mImpl->rowRect(row).contains(scrollP)) {
+        return row;
     }
     return -1;
 }
@@ -539,18 +1080,11 @@ Widget::EventResult ListView::key(const KeyEvent& e)
         if (e.keymods == 0) {
             setSelectedIndex(idx);
         } else if (mImpl->selectionMode == SelectionMode::kMultipleItems && e.keymods & KeyModifier::kShift) {
-            std::unordered_set<int> newSelection;
-            auto selection = selectedIndices();
-            for (int sel : selection) {
-                newSelection.insert(sel);
-            }
-            auto it = newSelection.find(idx);
-            if (it == newSelection.end()) {
-                newSelection.insert(idx);  // expanding selection: add this index
+            if (!mImpl->isSelected(idx)) {
+                selectRange(idx, idx + 1);  // expanding selection: add this index
             } else {
-                newSelection.erase(origIdx);  // shrinking selection: remove orig index
+                deselectRange(origIdx, origIdx + 1);  // shrinking selection: remove orig index
             }
-            setSelectedIndices(newSelection);
         }
         if (mImpl->onChanged) {
             mImpl->onChanged(this);
@@ -563,8 +1097,6 @@ Widget::EventResult ListView::key(const KeyEvent& e)
 
 void ListView::draw(UIContext& context)
 {
-    auto items = mImpl->content->children();
-
     Rect r(PicaPt::kZero, PicaPt::kZero, frame().width, frame().height);
     context.theme.drawListView(context, r, style(themeState()), themeState());
 
@@ -577,10 +1109,9 @@ void ListView::draw(UIContext& context)
     // The mouseOverIndex can also be set by keyboard navigation, so don't
     // require the state to be mouseover in order to display it.
     // (mouseExited() will set it -1, so mousing will still work correctly)
-    if (mImpl->mouseOverIndex >= 0 && mImpl->mouseOverIndex < int(items.size())) {
+    if (auto *item = mImpl->cellForRow(mImpl->mouseOverIndex)) {
         if (mImpl->selectionMode != SelectionMode::kNoItems) {
-            auto *item = items[mImpl->mouseOverIndex];
-            auto r = item->frame();
+            auto r = mImpl->rowRect(mImpl->mouseOverIndex);
             r.x = PicaPt::kZero;
             r.width = width;
             auto rowState = parentState;
@@ -592,12 +1123,17 @@ void ListView::draw(UIContext& context)
     auto stateForSelection = (parentState == Theme::WidgetState::kDisabled
                                 ? parentState
                                 : Theme::WidgetState::kNormal);
-    for (auto idx : mImpl->selectedIndices) {
-        if (idx >= 0 && idx < int(items.size())) {
-            auto r = items[idx]->frame();
-            r.x = PicaPt::kZero;
-            r.width = width;
-            context.theme.drawListViewSpecialRow(context, r, s, stateForSelection);
+    auto visibleRect = Rect(-bounds().x, -bounds().y, frame().width, frame().height);
+    int firstVisible = mImpl->rowAtY(visibleRect.y);
+    int lastVisible = mImpl->rowAtY(visibleRect.maxY());
+    if (firstVisible >= 0) {
+        for (auto &range : mImpl->selection.ranges(firstVisible, lastVisible + 1)) {
+            for (int idx = range.first;  idx < range.end;  ++idx) {
+                auto r = mImpl->rowRect(idx);
+                r.x = PicaPt::kZero;
+                r.width = width;
+                context.theme.drawListViewSpecialRow(context, r, s, stateForSelection);
+            }
         }
     }
     context.dc.translate(-bounds().x, -bounds().y);
@@ -631,9 +1167,12 @@ AccessibilityInfo ListView::accessibilityInfo()
     // we can set the text value to the actual label if it is a group.
     // Note that we do not need to populate the whole tree of children, the top-level
     // caller will do that
-    auto &childs = mImpl->content->children();
-    for (int i = 0;  i < int(childs.size());  ++i) {
-        auto *child = childs[i];
+    // With a data source, only the rows with cells are available.
+    int firstRow = (mImpl->rows ? mImpl->rows->firstRow : 0);
+    int endRow = (mImpl->rows ? firstRow + int(mImpl->rows->visibleCells.size())
+                              : mImpl->nRows());
+    for (int i = firstRow;  i < endRow;  ++i) {
+        auto *child = mImpl->cellForRow(i);
         if (!child->visible()) {
             continue;
         }
@@ -663,13 +1202,11 @@ AccessibilityInfo ListView::accessibilityInfo()
                 break;
             case SelectionMode::kMultipleItems:
                 childInfo.performLeftClick = [this, i]() {
-                    bool isSelected = false;
-                    if (mImpl->selectedIndices.find(i) != mImpl->selectedIndices.end()) {
-                        mImpl->selectedIndices.erase(i);
+                    if (mImpl->isSelected(i)) {
+                        deselectRange(i, i + 1);
                     } else {
-                        mImpl->selectedIndices.insert(i);
+                        selectRange(i, i + 1);
                     }
-                    setNeedsDraw();
                     if (mImpl->onChanged) {
                         mImpl->onChanged(this);
                     }
@@ -55,10 +55,50 @@ public:
     SelectionMode selectionMode() const;
     ListView* setSelectionModel(SelectionMode mode);
 
-    /// Returns the number of cells in the list view
+    /// Supplies rows on demand, for lists that are too large to create a cell
+    /// for each row. Only the visible rows (plus a few on either side) have
+    /// cells, and cells that scroll out of view are reused for the rows
+    /// scrolling into view, so populating and scrolling only cost as much
+    /// as the visible rows.
+    struct DataSource
+    {
+        /// Returns the number of rows. Required.
+        std::function<int()> nRows;
+        /// Returns a new cell, which the ListView will own. Required.
+        /// Cells are reused for different rows, so anything specific to the
+        /// row should be set in bindCell().
+        std::function<ListViewCell*()> makeCell;
+        /// Sets the contents of the cell to display the row. Required.
+        std::function<void(ListViewCell *cell, int row)> bindCell;
+        /// Returns the height of the row. This is called for every row when
+        /// the data is loaded, so it must be fast; an estimate is fine as long
+        /// as the cell can draw in that height. If not set, every row is
+        /// fixedRowHeight high, which is faster.
+        std::function<PicaPt(int row)> rowHeight;
+        /// The height of each row if rowHeight is not set. If zero (the
+        /// default), the preferred height of the first row is used.
+        PicaPt fixedRowHeight = PicaPt::kZero;
+    };
+
+    /// Switches the list to getting its rows from the data source, deleting
+    /// any cells added with addCell(). In this mode, addCell() and
+    /// removeCellAtIndex() may not be used, cellAtIndex() only returns cells
+    /// for rows that are near the visible area, and preferredSize() does not
+    /// measure the rows, so the width will grow unless setFixedWidthEm()
+    /// is used. Call clearCells() to go back to using cells.
+    ListView* setDataSource(const DataSource& source);
+    /// Reloads the number of rows, the row heights, and the contents of the
+    /// cells from the data source.
+    void reloadData();
+    /// Rebinds the row's cell if it is currently instantiated, and re-reads
+    /// the row's height if the data source has rowHeight. This is much
+    /// faster than reloadData() if only a few rows changed.
+    void reloadRow(int row);
+
+    /// Returns the number of rows in the list view
     int size() const;
 
-    /// Deletes all the cells
+    /// Deletes all the cells. If a data source is set, it is removed.
     void clearCells();
     /// Removes all the cells and returns ownership of all cells to the caller.
     /// This is useful if you need to reuse the cells.
@@ -71,26 +111,67 @@ public:
     ListView* addStringCell(const std::string& text);
 
     /// Returns the cell or nullptr if there is no cell at the index.
-    /// ListView retains ownership to the pointer.
+    /// ListView retains ownership to the pointer. With a data source, the
+    /// cell is only valid until the list scrolls or is reloaded.
     ListViewCell* cellAtIndex(int index) const;
 
     /// Removes the cell and transfers ownership to the caller.
-    /// If index is out of range, returns nullptr;
+    /// If index is out of range, returns nullptr; Selected rows after the
+    /// cell stay selected.
     ListViewCell* removeCellAtIndex(int index);
 
+    /// Inserts the cells before index and takes ownership of them. Selected
+    /// rows after index stay selected. This is much faster than adding the
+    /// cells one at a time.
+    ListView* insertCells(int index, const std::vector<ListViewCell*>& cells);
+    /// Removes the cells in [first, end) and transfers ownership to the
+    /// caller. Selected rows after the range stay selected.
+    std::vector<ListViewCell*> removeCells(int first, int end);
+
+    /// Defers the layout, redraw and cell state updates caused by adding and
+    /// removing cells until the matching endUpdates(), so that populating
+    /// a large list costs one layout instead of one per cell. Calls may be
+    /// nested; the work is done when the outermost endUpdates() is called.
+    void beginUpdates();
+    void endUpdates();
+
     /// Returns the selected index or -1 if there is none.
     /// Should only be used in single item mode. Use selectedIndices() for
     /// multiple item mode.
     int selectedIndex() const;
     /// Returns the selected indices, if any. Can be used in all selection modes.
+    /// This creates an entry for every selected row; for large lists prefer
+    /// selectedRanges().
     std::vector<int> selectedIndices() const;
 
+    /// A half-open range of rows, [first, end).
+    struct RowRange
+    {
+        int first;
+        int end;
+    };
+    /// Returns the selection as sorted, non-overlapping ranges. This is
+    /// O(number of ranges), regardless of how many rows are selected.
+    std::vector<RowRange> selectedRanges() const;
+    /// Returns the number of selected rows.
+    int nSelectedRows() const;
+    bool isRowSelected(int row) const;
+
     ListView* setOnSelectionChanged(std::function<void(ListView*)> onChanged);
     ListView* setOnSelectionDoubleClicked(std::function<void(ListView*, int)> onDblClicked);
 
     void clearSelection();
     void setSelectedIndex(int index);
     void setSelectedIndices(const std::unordered_set<int> indices);
+    /// Adds the rows [first, end) to the selection. Like the other selection
+    /// setters, this does not call the selection-changed callback.
+    void selectRange(int first, int end);
+    /// Removes the rows [first, end) from the selection.
+    void deselectRange(int first, int end);
+    /// Selects every row; this is O(1) in the number of rows.
+    void selectAll();
+    /// Selects the unselected rows and deselects the selected rows.
+    void invertSelection();
 
     bool isRowVisible(int index) const;
 
@@ -115,6 +196,8 @@ public:
 
     Size preferredContentSize(const LayoutContext& context) const;
 
+    ListView* setBounds(const Rect& bounds) override;
+
     AccessibilityInfo accessibilityInfo() override;
     Size preferredSize(const LayoutContext& context) const override;
     void layout(const LayoutContext& context) override;
@@ -1270,9 +1270,7 @@ void MenuUITK::show(Window *w, const Point& upperLeftWindowCoord,
     // ... highlight on mouseover, unlike normal ListView
     list->style(Theme::WidgetState::kMouseOver).fgColor = Application::instance().theme()->params().accentColor;
     list->style(Theme::WidgetState::kMouseOver).flags |= Theme::WidgetStyle::kFGColorSet;
-    for (auto *item : mImpl->items) {
-        list->addCell(item);
-    }
+    list->insertCells(0, std::vector<ListViewCell*>(mImpl->items.begin(), mImpl->items.end()));
     mImpl->listView = list;
     auto *root = new MenuRoot();
     root->addChild(list);
@@ -154,6 +154,7 @@ NumberEdit* NumberEdit::setLimits(double minVal, double maxVal, double inc /*= 1
             }
         }
     }
+    setNeedsLayout();  // the preferred width depends on the limits and digits
     return this;
 }
 
@@ -175,6 +176,7 @@ NumberEdit* NumberEdit::setDecimalDigits(int nDigits)
 {
     mImpl->nFormatDigits = nDigits;
     mImpl->userHasSetFormatDigits = true;
+    setNeedsLayout();  // the preferred width depends on the digits
     setNeedsDraw();
     return this;
 }
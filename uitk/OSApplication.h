@@ -66,6 +66,7 @@ public:
     virtual bool isOriginInUpperLeft() const = 0;
     virtual bool isWindowBorderInsideWindowFrame() const = 0;
     virtual bool windowsMightUseSameDrawContext() const = 0;
+    virtual bool windowContentsPersistBetweenDraws() const = 0;
     virtual bool shouldHideScrollbars() const = 0;
     virtual bool canKeyFocusEverything() const = 0;
     virtual bool platformHasMenubar() const = 0;
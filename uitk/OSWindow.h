@@ -48,7 +48,10 @@ public:
 
     virtual void onResize(const DrawContext& dc) = 0;
     virtual void onLayout(const DrawContext& dc) = 0;
-    virtual void onDraw(DrawContext& dc) = 0;
+    /// Draws and returns the areas that were drawn, in window coordinates.
+    /// Platforms that keep the window contents between draws only need to
+    /// present these areas to the screen.
+    virtual std::vector<Rect> onDraw(DrawContext& dc) = 0;
     virtual void onMouse(const MouseEvent& e) = 0;
     virtual void onKey(const KeyEvent& e) = 0;
     virtual void onText(const TextEvent& e) = 0;
@@ -84,6 +87,19 @@ struct OSScreen
     /// This is the actual area of the monitor (what a fullscreen window gets)
     OSRect fullscreenFrame;
     float dpi;
+    /// Refresh rate of the display in Hz, or 0 if the platform does not say
+    float refreshRate = 0.0f;
+};
+
+/// Accumulated times of drawing and presenting a window's frames, in seconds.
+/// This is useful to compare presentation paths. Platforms that do not
+/// record these leave everything zero.
+struct OSFrameStats
+{
+    unsigned long nFrames = 0;
+    double drawSecs = 0.0;  /// total time drawing into the backbuffer
+    double presentSecs = 0.0;  /// total time copying to the window
+    bool usesSharedMemory = false;  /// presenting goes through shared memory
 };
 
 class OSWindow
@@ -144,6 +160,9 @@ public:
 
     virtual void setNeedsAccessibilityUpdate() = 0;
     virtual void setAccessibleElements(const std::vector<AccessibilityInfo>& elements) = 0;
+
+    // Only X11 records these currently, so this is not pure virtual.
+    virtual OSFrameStats frameStats() const { return OSFrameStats(); }
 };
 
 }  // namespace uitk
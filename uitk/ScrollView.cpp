@@ -27,6 +27,7 @@
 #include "ScrollBar.h"
 #include "UIContext.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace uitk {
@@ -112,6 +113,30 @@ struct ScrollView::Impl
         this->vertScroll->setVisible(false);
     }
 
+    // Schedules a single timer for when the scrollbars are due to hide,
+    // instead of checking periodically. Scrolling again before then moves the
+    // hide time, so the timer reschedules itself for the remaining time.
+    void scheduleHideTimer(Window *w)
+    {
+        auto &app = Application::instance();
+        auto delay = app.autoHideScrollbarDelaySecs();
+        if (!this->mouseIsInScrollbar) {
+            delay = std::max(0.0, this->lastShowScrollActionTime + delay - app.microTime());
+        }
+        this->hideScrollbarsTimer = app.scheduleLater(w, float(delay), Application::ScheduleMode::kOnce,
+                                                      [this, w](Application::ScheduledId id) {
+            assert(this->hideScrollbarsTimer == id);
+            this->hideScrollbarsTimer = Application::kInvalidScheduledId;
+            auto &app = Application::instance();
+            auto timeToHide = this->lastShowScrollActionTime + app.autoHideScrollbarDelaySecs();
+            if (!this->mouseIsInScrollbar && app.microTime() >= timeToHide) {
+                hideScrollbars();
+            } else {
+                scheduleHideTimer(w);
+            }
+        });
+    }
+
     void cancelHideTimer()
     {
         if (this->hideScrollbarsTimer != Application::kInvalidScheduledId) {
@@ -301,17 +326,7 @@ Widget::EventResult ScrollView::mouse(const MouseEvent& e)
             mImpl->vertScroll->setVisible(mImpl->usesVertScrollbar);
             if (mImpl->hideScrollbarsTimer == Application::kInvalidScheduledId) {
                 if (auto *w = window()) {
-                    mImpl->hideScrollbarsTimer = Application::instance()
-                                                       .scheduleLater(w, 0.1f,
-                                                                      Application::ScheduleMode::kRepeating,
-                                                                      [this](Application::ScheduledId id) {
-                        assert(mImpl->hideScrollbarsTimer == id);
-                        auto &app = Application::instance();
-                        auto timeToHide = mImpl->lastShowScrollActionTime + app.autoHideScrollbarDelaySecs();
-                        if (!mImpl->mouseIsInScrollbar && app.microTime() >= timeToHide) {
-                            mImpl->hideScrollbars();
-                        }
-                    });
+                    mImpl->scheduleHideTimer(w);
                 }
             }
         }
@@ -67,7 +67,9 @@ public:
 
     /// bounds().size() is the content size and bounds().upperLeft() is contentOffset
     const Rect& bounds() const override;
-    ScrollView* setBounds(const Rect& bounds);
+    /// Sets the content size and offset. All scrolling goes through this
+    /// function, so derived classes can override it to track scrolling.
+    virtual ScrollView* setBounds(const Rect& bounds);
 
     /// Sets the content size. This is required.
     ScrollView* setContentSize(const Size& size);
@@ -328,13 +328,13 @@ Size Splitter::preferredSize(const LayoutContext& context) const
     PicaPt border = (borderColor().alpha() > 0.001f ? borderWidth() : PicaPt::kZero);
     if (mImpl->dir == Dir::kHoriz) {
         for (auto child : children()) {
-            auto pref = child->preferredSize(context);
+            auto pref = child->cachedPreferredSize(context);
             size.width += pref.width;
             size.height = std::max(size.height, pref.height);
         }
     } else {
         for (auto child : children()) {
-            auto pref = child->preferredSize(context);
+            auto pref = child->cachedPreferredSize(context);
             size.width = std::max(size.height, pref.height);
             size.height += pref.width;
         }
@@ -67,6 +67,9 @@ void StackedWidget::setIndexShowing(int index)
     auto &panels = children();
     index = std::min(index, int(panels.size()));
     mImpl->index = index;
+    if (mImpl->preferredSizeAlgo == PreferredSize::kCurrentPanel) {
+        setNeedsLayout();  // our preferred size is the new panel's
+    }
 
     for (size_t i = 0;  i < panels.size();  ++i) {
         auto *p = panels[i];
@@ -104,14 +107,14 @@ Size StackedWidget::preferredSize(const LayoutContext& context) const
     Size size;
     if (mImpl->preferredSizeAlgo == PreferredSize::kMaxPanelSize) {
         for (auto *p : children()) {
-            auto pref = p->preferredSize(context);
+            auto pref = p->cachedPreferredSize(context);
             size.width = std::max(size.width, pref.width);
             size.height = std::max(size.height, pref.height);
         }
     } else {
         auto &panels = children();
         if (mImpl->index >= 0 && mImpl->index < panels.size()) {
-            return panels[mImpl->index]->preferredSize(context);
+            return panels[mImpl->index]->cachedPreferredSize(context);
         }
     }
     return size;
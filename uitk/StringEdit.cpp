@@ -333,6 +333,7 @@ bool StringEdit::isMultiline() const { return !mImpl->isSingleLine; }
 StringEdit* StringEdit::setMultiline(bool multiline)
 {
     mImpl->isSingleLine = !multiline;
+    setNeedsLayout();  // changes the preferred size
     setNeedsDraw();
     return this;
 }
@@ -28,6 +28,7 @@
 
 #include <assert.h>
 
+#include <set>
 #include <unordered_map>
 
 namespace uitk {
@@ -72,6 +73,8 @@ public:
 
         auto sIt = mStates.find(window);
         if (sIt == mStates.end()) {
+            // The timer only runs once per tick (rather than every frame), and
+            // only redraws the indicators, not the whole window.
             auto timer = Application::instance().scheduleLater(window, kTickSecs,
                                                                Application::ScheduleMode::kRepeating,
                                                                [this, window](Application::ScheduledId tid) {
@@ -81,7 +84,9 @@ public:
                     if (sIt->second.tick < 0) { // overflowed (very unlikely, will take years, but make it work)
                         sIt->second.tick = 0;
                     }
-                    window->setNeedsDraw();
+                    for (auto *waiting : sIt->second.animatingWidgets) {
+                        waiting->setNeedsDraw();
+                    }
                 } else {
                     Application::instance().cancelScheduled(tid);
                 }
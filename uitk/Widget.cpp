@@ -24,13 +24,17 @@
 
 #include "Application.h"
 #include "Events.h"
+#include "Instrumentation.h"
 #include "Label.h"
 #include "UIContext.h"
 #include "Window.h"
+#include "private/DisplayList.h"
+#include "private/HitTestGrid.h"
 #include <nativedraw.h>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
-#include <list>
 #include <optional>
 #include <typeinfo>
 
@@ -40,6 +44,10 @@ static const int kNStyles = 5;
 
 static const std::optional<Theme::WidgetState> kUnsetThemeState = std::nullopt;
 
+// Layouts generally ask for at most two sizes: unconstrained and constrained
+// to the width they are going to use.
+static const size_t kMaxCachedPreferredSizes = 4;
+
 struct Widget::Impl {
     Window* window = nullptr;  // we do not own this
     Widget* parent = nullptr;  // we do not own this
@@ -55,13 +63,63 @@ struct Widget::Impl {
         float fixedWidthEm = kNotFixed;
         float fixedHeightEm = kNotFixed;
     } layout;
+    struct PreferredSizeCache {
+        struct Entry {
+            PicaPt constraintWidth;
+            PicaPt constraintHeight;
+            Size size;
+        };
+        uint64_t themeGeneration = 0;  // the theme's address may be reused by a new theme
+        float dpi = 0.0f;
+        std::vector<Entry> entries;  // most recently added last
+    };
+    mutable PreferredSizeCache preferredSizeCache;
     double lastTooltipPreventingActivityTime = std::numeric_limits<double>::max();
     Application::ScheduledId tooltipTimer = Application::kInvalidScheduledId;
     bool drawsFrame = false;
+    bool needsLayout = true;
+    bool descendantNeedsLayout = false;
+    bool isLayoutBoundary = false;
     bool visible = true;
     bool enabled = true;
     bool showFocusRingOnParent = false;
 
+    // For setUsesHitTestIndex(). The grid is rebuilt lazily when the
+    // children or their frames change. `hot` has the children that might
+    // not be in the normal state, which need the mouse event even if it is
+    // not over them, so that they can return to normal.
+    struct HitTestIndex {
+        HitTestGrid grid;
+        bool isValid = false;
+        unsigned int childrenVersion = 0;  // changes when children are added or removed
+        std::vector<int> hot;
+        std::vector<int> candidates;
+    };
+    std::unique_ptr<HitTestIndex> hitTestIndex;
+
+    // For setCachesDrawing() and setRecordsDrawing(). The image (or display
+    // list) is valid for the keys it was drawn with until setNeedsDraw() or
+    // setNeedsLayout() is called on us or a descendant, or a descendant is
+    // moved, resized, added, or removed. The last ones also invalidate it if
+    // they happen while drawing, since a display list only borrows the text
+    // layouts that existed before recording, and widgets like Label release
+    // theirs when resized.
+    struct DrawingCache {
+        std::shared_ptr<DrawableImage> image;
+        std::unique_ptr<DisplayList> displayList;  // if recording instead of caching an image
+        bool isValid = false;
+        bool isDrawing = false;  // setNeedsDraw() while drawing is for this drawing
+        bool changedWhileDrawing = false;  // see invalidateDrawingCaches()
+        Window *window = nullptr;  // the window whose budget this is in
+        const Theme *theme = nullptr;
+        float dpi = 0.0f;
+        int widthPx = 0;
+        int heightPx = 0;
+        Theme::WidgetState themeState = Theme::WidgetState::kNormal;
+        bool isWindowActive = false;
+    };
+    std::unique_ptr<DrawingCache> drawingCache;
+
     void updateDrawsFrame(const Widget *w)
     {
         int userSetBorderMask = (int(Theme::WidgetStyle::kBorderWidthSet) |
@@ -80,6 +138,119 @@ struct Widget::Impl {
         }
     }
 
+    void clearPreferredSizeCache()
+    {
+        this->preferredSizeCache.entries.clear();
+    }
+
+    void invalidateDrawingCache()
+    {
+        if (auto *cache = this->drawingCache.get()) {
+            if (!cache->isDrawing) {  // then the change is part of this drawing
+                cache->isValid = false;
+            }
+        }
+    }
+
+    // For changes that affect how w and its ancestors draw but that do not
+    // go through setNeedsDraw(), such as a child being added or removed.
+    // Unlike setNeedsDraw(), these can free something already recorded, so
+    // a drawing in progress is not valid either once it finishes.
+    static void invalidateDrawingCaches(Widget *w)
+    {
+        for (;  w;  w = w->mImpl->parent) {
+            if (auto *cache = w->mImpl->drawingCache.get()) {
+                if (cache->isDrawing) {
+                    cache->changedWhileDrawing = true;
+                } else {
+                    cache->isValid = false;
+                }
+            }
+        }
+    }
+
+    void invalidateHitTestIndex(bool childrenChanged)
+    {
+        if (this->hitTestIndex) {
+            this->hitTestIndex->isValid = false;
+            if (childrenChanged) {
+                this->hitTestIndex->childrenVersion += 1;
+            }
+        }
+    }
+
+    // Returns the indices of the children that a mouse event at p could
+    // affect, topmost first: the ones whose frames contain p, and the ones
+    // that are not in the normal state.
+    const std::vector<int>& hitTestCandidates(const Point& p)
+    {
+        auto &index = *this->hitTestIndex;
+        if (!index.isValid) {
+            std::vector<Rect> frames;
+            frames.reserve(this->children.size());
+            for (auto *child : this->children) {
+                frames.push_back(child->frame());
+            }
+            index.grid.reset(frames);
+            updateHot(nullptr);
+            index.isValid = true;
+        }
+
+        index.grid.indicesAt(p, &index.candidates);
+        index.candidates.insert(index.candidates.end(), index.hot.begin(), index.hot.end());
+        std::sort(index.candidates.begin(), index.candidates.end(), std::greater<int>());
+        index.candidates.erase(std::unique(index.candidates.begin(), index.candidates.end()),
+                               index.candidates.end());
+        return index.candidates;
+    }
+
+    // Updates the hot children from the candidates, which include all the
+    // children that could have changed state, or from all the children if
+    // candidates is nullptr.
+    void updateHot(const std::vector<int> *candidates)
+    {
+        auto isHot = [this](int i) {
+            auto state = this->children[i]->state();
+            return (state == MouseState::kMouseOver || state == MouseState::kMouseDown);
+        };
+
+        auto &hot = this->hitTestIndex->hot;
+        hot.clear();
+        if (candidates) {
+            for (int i : *candidates) {
+                if (isHot(i)) {
+                    hot.push_back(i);
+                }
+            }
+        } else {
+            for (int i = 0;  i < int(this->children.size());  ++i) {
+                if (isHot(i)) {
+                    hot.push_back(i);
+                }
+            }
+        }
+    }
+
+    // Damages a child's frame, which is in self's coordinates.
+    void damageFrame(Widget *self, const Rect& childFrame)
+    {
+        if (childFrame.width > PicaPt::kZero && childFrame.height > PicaPt::kZero) {
+            self->setNeedsDraw(childFrame);
+        }
+    }
+
+    // The widget and its descendants are leaving the window, so their
+    // cached drawings should no longer count against its budget.
+    static void discardDrawingCaches(Widget *w)
+    {
+        if (w->mImpl->drawingCache) {
+            w->discardDrawingCache();
+        }
+        for (auto *child : w->mImpl->children) {
+            discardDrawingCaches(child);
+        }
+    }
+
     void clearTooltip()
     {
         if (this->tooltipTimer != Application::kInvalidScheduledId) {
@@ -98,9 +269,15 @@ Widget::Widget()
 
 Widget::~Widget()
 {
+    if (auto *profiler = Instrumentation::widgetProfiler()) {
+        profiler->removeWidget(this);
+    }
     if (mImpl->parent) {
         mImpl->parent->removeChild(this);
     }
+    if (mImpl->drawingCache) {
+        discardDrawingCache();
+    }
     mImpl->clearTooltip();
     clearAllChildren();
 }
@@ -122,6 +299,14 @@ std::string Widget::debugDescription(const Point& offset /*= Point(PicaPt::kZero
     s += std::to_string((f.x + offset.x).asFloat()) + ", ";
     s += std::to_string((f.y + offset.y).asFloat()) + ") ";
     s += std::to_string(f.width.asFloat()) + " x " + std::to_string(f.height.asFloat());
+    auto *profiler = Instrumentation::widgetProfiler();
+    if (auto *profile = (profiler ? profiler->widgetProfile(this) : nullptr)) {
+        // in milliseconds, which are easier to read
+        s += " draw " + std::to_string(1000.0 * profile->drawInclusiveSecs) + " ms (";
+        s += std::to_string(1000.0 * profile->drawExclusiveSecs) + " excl) x" + std::to_string(profile->nDraws);
+        s += ", layout " + std::to_string(1000.0 * profile->layoutInclusiveSecs) + " ms (";
+        s += std::to_string(1000.0 * profile->layoutExclusiveSecs) + " excl) x" + std::to_string(profile->nLayouts);
+    }
     s += "\n";
 
     for (auto child : mImpl->children) {
@@ -135,8 +320,39 @@ const Rect& Widget::frame() const { return mImpl->frame; }
 
 Widget* Widget::setFrame(const Rect& frame)
 {
+    // Moving a widget does not change its layout, but resizing does. Mark the
+    // ancestors too, since whoever sets our frame is not necessarily our
+    // parent (e.g. ListView sets the frames of its content's children).
+    bool resized = (frame.width != mImpl->frame.width || frame.height != mImpl->frame.height);
+    if (resized) {
+        mImpl->needsLayout = true;
+        for (auto *p = mImpl->parent;  p && !p->mImpl->descendantNeedsLayout;  p = p->mImpl->parent) {
+            p->mImpl->descendantNeedsLayout = true;
+        }
+    }
+    bool changed = (resized || frame.x != mImpl->frame.x || frame.y != mImpl->frame.y);
+    // Even if we are not visible, or have no area, so that nothing gets
+    // damaged below. Our own drawing too if we are resized, even if not by
+    // a whole pixel, since a derived class may have released a TextLayout
+    // that we recorded.
+    if (changed) {
+        Impl::invalidateDrawingCaches(resized ? this : mImpl->parent);
+    }
+    auto *parent = mImpl->parent;
+    if (parent && changed) {
+        parent->mImpl->invalidateHitTestIndex(false);
+        // setNeedsDraw() only damages our current frame, so the area we are
+        // leaving needs to be damaged here, otherwise on platforms where the
+        // window contents persist between draws we would leave a copy behind.
+        if (mImpl->visible) {
+            parent->mImpl->damageFrame(parent, mImpl->frame);
+        }
+    }
     mImpl->frame = frame;
     mImpl->bounds = Rect(PicaPt::kZero, PicaPt::kZero, frame.width, frame.height);
+    if (parent && changed && mImpl->visible) {
+        parent->mImpl->damageFrame(parent, frame);
+    }
     return this;
 }
 
@@ -286,6 +502,7 @@ Widget* Widget::addChild(Widget *w)
 {
     mImpl->children.push_back(w);
     w->mImpl->parent = this;
+    mImpl->invalidateHitTestIndex(true);
     setNeedsLayout();
     return this;
 }
@@ -298,9 +515,13 @@ Widget* Widget::removeChild(Widget *w)
                 if (win->mouseoverWidget() == w) {
                     win->setMouseoverWidget(nullptr);
                 }
+                if (win->hasCachedDrawings()) {
+                    Impl::discardDrawingCaches(w);
+                }
             }
             mImpl->children.erase(it);
             w->mImpl->parent = nullptr;
+            mImpl->invalidateHitTestIndex(true);
             setNeedsLayout();
             return w;
         }
@@ -308,6 +529,44 @@ Widget* Widget::removeChild(Widget *w)
     return nullptr;
 }
 
+Widget* Widget::insertChildren(int index, const std::vector<Widget*>& widgets)
+{
+    index = std::max(0, std::min(index, int(mImpl->children.size())));
+    mImpl->children.insert(mImpl->children.begin() + index, widgets.begin(), widgets.end());
+    for (auto *w : widgets) {
+        w->mImpl->parent = this;
+    }
+    mImpl->invalidateHitTestIndex(true);
+    setNeedsLayout();
+    return this;
+}
+
+std::vector<Widget*> Widget::removeChildren(int first, int end)
+{
+    first = std::max(0, first);
+    end = std::min(end, int(mImpl->children.size()));
+    if (first >= end) {
+        return {};
+    }
+
+    auto *win = window();
+    auto *mw = (win ? win->mouseoverWidget() : nullptr);
+    std::vector<Widget*> removed(mImpl->children.begin() + first, mImpl->children.begin() + end);
+    for (auto *w : removed) {
+        if (win && mw == w) {
+            win->setMouseoverWidget(nullptr);
+        }
+        if (win && win->hasCachedDrawings()) {
+            Impl::discardDrawingCaches(w);
+        }
+        w->mImpl->parent = nullptr;
+    }
+    mImpl->children.erase(mImpl->children.begin() + first, mImpl->children.begin() + end);
+    mImpl->invalidateHitTestIndex(true);
+    setNeedsLayout();
+    return removed;
+}
+
 void Widget::removeAllChildren()
 {
     // Since we are returning these widgets to ownership of the caller,
@@ -319,11 +578,16 @@ void Widget::removeAllChildren()
         if (win && mw == child) {
             win->setMouseoverWidget(nullptr);
         }
+        if (win && win->hasCachedDrawings()) {
+            Impl::discardDrawingCaches(child);
+        }
         child->setState(MouseState::kNormal);
         child->resetThemeState();
         child->mImpl->parent = nullptr;
     }
     mImpl->children.clear();
+    mImpl->invalidateHitTestIndex(true);
+    Impl::invalidateDrawingCaches(this);
     // Do not need a layout, technically: there's nothing left to layout
     if (win) {
         win->setNeedsAccessibilityUpdate();
@@ -407,15 +671,102 @@ Point Widget::convertToParentFromLocal(const Point& localPt) const
 
 void Widget::setNeedsDraw()
 {
-    if (Window *win = window()) {
-        win->setNeedsDraw();
+    setNeedsDraw(Rect(PicaPt::kZero, PicaPt::kZero, frame().width, frame().height));
+}
+
+void Widget::setNeedsDraw(const Rect& localRect)
+{
+    // This is the same as convertToWindowFromLocal(), except that it uses the
+    // frame of the top-level widget instead of the window's contentRect(), so
+    // that it is also correct for the menubar widget (which is not a child of
+    // the root widget).
+    Rect r = localRect;
+    const Widget *w = this;
+    while (true) {
+        w->mImpl->invalidateDrawingCache();
+        r.translate(w->frame().x, w->frame().y);
+        if (!w->mImpl->parent) {
+            break;
+        }
+        w = w->mImpl->parent;
+    }
+    if (Window *win = w->mImpl->window) {
+        win->setNeedsDraw(r);
     }
 }
 
 void Widget::setNeedsLayout()
 {
+    // Our preferred size may have changed, which changes our parent's layout,
+    // which may change its preferred size, and so on up to a widget whose
+    // frame does not depend on its contents. That boundary gets laid out,
+    // and its ancestors are marked so that layout can find it.
+    // Any ancestor's preferred size might depend on ours, so clear all the
+    // cached preferred sizes, even past the boundary. Likewise any cached
+    // drawings, since they include ours.
+    Widget *w = this;
+    w->mImpl->needsLayout = true;
+    w->mImpl->clearPreferredSizeCache();
+    w->mImpl->invalidateDrawingCache();
+    while (w->mImpl->parent && !w->isLayoutBoundary()) {
+        w = w->mImpl->parent;
+        w->mImpl->needsLayout = true;
+        w->mImpl->clearPreferredSizeCache();
+        w->mImpl->invalidateDrawingCache();
+    }
+    Widget *boundary = w;
+    while (w->mImpl->parent) {
+        w = w->mImpl->parent;
+        w->mImpl->descendantNeedsLayout = true;
+        w->mImpl->clearPreferredSizeCache();
+        w->mImpl->invalidateDrawingCache();
+    }
+
     if (Window *win = window()) {
-        win->setNeedsLayout();
+        if (!boundary->mImpl->parent) {
+            // Root widget (or menubar); the window lays these out.
+            win->setNeedsLayout();
+        } else {
+            boundary->setNeedsDraw();
+        }
+    }
+}
+
+bool Widget::isLayoutBoundary() const
+{
+    return (mImpl->isLayoutBoundary ||
+            (mImpl->layout.fixedWidthEm > 0.0f && mImpl->layout.fixedHeightEm > 0.0f));
+}
+
+Widget* Widget::setIsLayoutBoundary(bool is)
+{
+    mImpl->isLayoutBoundary = is;
+    return this;
+}
+
+bool Widget::layoutIfNeeded(const LayoutContext& context)
+{
+    if (mImpl->needsLayout) {
+        Instrumentation::ScopedWidgetCall profile(this, Instrumentation::WidgetCall::kLayout);
+        layout(context);
+        return true;
+    } else if (mImpl->descendantNeedsLayout) {
+        bool didLayout = false;
+        for (auto *child : mImpl->children) {
+            didLayout |= child->layoutIfNeeded(context);
+        }
+        // Clear afterwards, since laying out the children may set it again
+        mImpl->descendantNeedsLayout = false;
+        return didLayout;
+    }
+    return false;
+}
+
+void Widget::setSubtreeNeedsLayout()
+{
+    mImpl->needsLayout = true;
+    for (auto *child : mImpl->children) {
+        child->setSubtreeNeedsLayout();
     }
 }
 
@@ -577,7 +928,7 @@ Size Widget::preferredSize(const LayoutContext& context) const
         } else {
             Size size;
             for (auto *child : mImpl->children) {
-                auto pref = child->preferredSize(context);
+                auto pref = child->cachedPreferredSize(context);
                 size.width = std::max(size.width, pref.width);
                 size.height = std::max(size.height, pref.height);
             }
@@ -594,6 +945,34 @@ Size Widget::preferredSize(const LayoutContext& context) const
     }
 }
 
+Size Widget::cachedPreferredSize(const LayoutContext& context) const
+{
+    auto &cache = mImpl->preferredSizeCache;
+    if (context.theme.generation() != cache.themeGeneration || context.dc.dpi() != cache.dpi) {
+        cache.entries.clear();
+        cache.themeGeneration = context.theme.generation();
+        cache.dpi = context.dc.dpi();
+    }
+
+    for (auto &e : cache.entries) {
+        if (e.constraintWidth == context.constraints.width &&
+            e.constraintHeight == context.constraints.height) {
+            return e.size;
+        }
+    }
+
+    if (auto *instr = Instrumentation::enabledInstance()) {
+        instr->countPreferredSize();
+    }
+
+    auto pref = preferredSize(context);
+    if (cache.entries.size() >= kMaxCachedPreferredSizes) {
+        cache.entries.erase(cache.entries.begin());
+    }
+    cache.entries.push_back({ context.constraints.width, context.constraints.height, pref });
+    return pref;
+}
+
 void Widget::layout(const LayoutContext& context)
 {
     static bool showBaseWarning = true;
@@ -614,10 +993,13 @@ void Widget::layout(const LayoutContext& context)
         }
     }
 
-    // Always layout the children
+    // Layout the children, but only the ones that need it: if nothing inside
+    // a child changed and its size is the same, its layout is still valid.
     for (auto *child : mImpl->children) {
-        child->layout(context);
+        child->layoutIfNeeded(context);
     }
+    mImpl->needsLayout = false;
+    mImpl->descendantNeedsLayout = false;
 }
 
 bool Widget::hitTest(const Point& p)
@@ -625,6 +1007,18 @@ bool Widget::hitTest(const Point& p)
     return frame().contains(p + frame().upperLeft());
 }
 
+bool Widget::usesHitTestIndex() const { return (mImpl->hitTestIndex != nullptr); }
+
+Widget* Widget::setUsesHitTestIndex(bool uses)
+{
+    if (uses && !mImpl->hitTestIndex) {
+        mImpl->hitTestIndex = std::make_unique<Impl::HitTestIndex>();
+    } else if (!uses) {
+        mImpl->hitTestIndex.reset();
+    }
+    return this;
+}
+
 Widget::EventResult Widget::mouse(const MouseEvent& e)
 {
     if (!enabled()) {
@@ -644,10 +1038,26 @@ Widget::EventResult Widget::mouse(const MouseEvent& e)
     auto result = EventResult::kIgnored;
     // Drawing is done in order (first is bottom, last is top), so hit-testing must be
     // done in reverse order.
-    for (auto childIt = mImpl->children.rbegin();  childIt != mImpl->children.rend();  ++childIt) {
-        result = mouseChild(e, *childIt, result);
-        if (result == EventResult::kConsumed) {
-            break;
+    if (mImpl->hitTestIndex) {
+        // Copy, since a child's mouse() might send a mouse event to us.
+        auto candidates = mImpl->hitTestCandidates(e.pos);
+        auto version = mImpl->hitTestIndex->childrenVersion;
+        for (int i : candidates) {
+            result = mouseChild(e, mImpl->children[i], result);
+            if (result == EventResult::kConsumed || !mImpl->hitTestIndex
+                || mImpl->hitTestIndex->childrenVersion != version) {
+                break;
+            }
+        }
+        if (mImpl->hitTestIndex && mImpl->hitTestIndex->childrenVersion == version) {
+            mImpl->updateHot(&candidates);
+        }
+    } else {
+        for (auto childIt = mImpl->children.rbegin();  childIt != mImpl->children.rend();  ++childIt) {
+            result = mouseChild(e, *childIt, result);
+            if (result == EventResult::kConsumed) {
+                break;
+            }
         }
     }
 
@@ -662,26 +1072,36 @@ Widget::EventResult Widget::mouse(const MouseEvent& e)
                        e.type == MouseEvent::Type::kScroll);
         auto *mw = win->mouseoverWidget();
         if (isMove && oldMouseoverWidget != mw && oldMouseoverWidget->state() != MouseState::kNormal) {
-            auto calcParents = [](Widget *w) -> std::list<Widget*> {
-                std::list<Widget*> parents; // list, because will always insert
-                auto *p = w;
-                do {
-                    p = p->parent();
-                    parents.push_front(p);
-                } while (p);
-                return parents;
-             };
-
-            auto oldParents = calcParents(oldMouseoverWidget);
-            auto newParents = calcParents(mw);
-            auto oit = oldParents.begin();
-            auto nit = newParents.begin();
-            while (oit != oldParents.end() && nit != newParents.end() && *nit == *oit) {
-                ++oit;
-                ++nit;
+            // The ancestors of the old widget that are not ancestors of the
+            // new one have been exited, outermost first. Find the common
+            // ancestor by walking up from the same depth, which needs no
+            // allocations and is O(depth).
+            auto depth = [](Widget *w) {
+                int d = 0;
+                for (auto *p = w->parent();  p;  p = p->parent()) {
+                    ++d;
+                }
+                return d;
+            };
+            auto *oldAncestor = oldMouseoverWidget->parent();
+            auto *newAncestor = (mw ? mw->parent() : nullptr);
+            int oldDepth = depth(oldMouseoverWidget);
+            int newDepth = (mw ? depth(mw) : 0);
+            for (;  newDepth > oldDepth;  --newDepth) {
+                newAncestor = newAncestor->parent();
+            }
+            std::vector<Widget*> exited;
+            for (;  oldDepth > newDepth;  --oldDepth) {
+                exited.push_back(oldAncestor);
+                oldAncestor = oldAncestor->parent();
             }
-            for (; oit != oldParents.end();  ++oit) {
-                (*oit)->mouseExited();
+            while (oldAncestor != newAncestor) {
+                exited.push_back(oldAncestor);
+                oldAncestor = oldAncestor->parent();
+                newAncestor = newAncestor->parent();
+            }
+            for (auto it = exited.rbegin();  it != exited.rend();  ++it) {
+                (*it)->mouseExited();
             }
         }
     }
@@ -826,6 +1246,11 @@ void Widget::text(const TextEvent& e)
 
 void Widget::themeChanged(const Theme& theme)
 {
+    mImpl->needsLayout = true;  // sizes may have changed
+    mImpl->clearPreferredSizeCache();
+    if (mImpl->drawingCache) {
+        mImpl->drawingCache->isValid = false;
+    }
     for (auto *child : mImpl->children) {
         child->themeChanged(theme);
     }
@@ -861,6 +1286,159 @@ void Widget::draw(UIContext& context)
     }
 }
 
+bool Widget::cachesDrawing() const
+{
+    return (mImpl->drawingCache && !mImpl->drawingCache->displayList);
+}
+
+Widget* Widget::setCachesDrawing(bool caches)
+{
+    if (caches != cachesDrawing()) {
+        if (mImpl->drawingCache) {
+            discardDrawingCache();
+            mImpl->drawingCache.reset();
+        }
+        if (caches) {
+            mImpl->drawingCache = std::make_unique<Impl::DrawingCache>();
+        }
+    }
+    return this;
+}
+
+bool Widget::recordsDrawing() const
+{
+    return (mImpl->drawingCache && mImpl->drawingCache->displayList);
+}
+
+Widget* Widget::setRecordsDrawing(bool records)
+{
+    if (records != recordsDrawing()) {
+        if (mImpl->drawingCache) {
+            discardDrawingCache();
+            mImpl->drawingCache.reset();
+        }
+        if (records) {
+            mImpl->drawingCache = std::make_unique<Impl::DrawingCache>();
+            mImpl->drawingCache->displayList = std::make_unique<DisplayList>();
+        }
+    }
+    return this;
+}
+
+void Widget::discardDrawingCache()
+{
+    auto &cache = *mImpl->drawingCache;
+    if (cache.window) {
+        cache.window->removeCachedDrawing(this);
+        cache.window = nullptr;
+    }
+    cache.image.reset();
+    if (cache.displayList && !cache.displayList->empty()) {
+        // A recording ancestor that replayed our list into its own only
+        // borrowed our text layouts, which are about to be freed.
+        Impl::invalidateDrawingCaches(mImpl->parent);
+        cache.displayList->clear();
+    }
+    cache.isValid = false;
+}
+
+void Widget::drawCached(UIContext& context)
+{
+    auto &cache = *mImpl->drawingCache;
+    auto *win = window();
+    auto dpi = context.dc.dpi();
+    int widthPx = int(std::ceil(frame().width.toPixels(dpi)));
+    int heightPx = int(std::ceil(frame().height.toPixels(dpi)));
+    size_t bytes = size_t(std::max(0, widthPx)) * size_t(std::max(0, heightPx)) * 4;
+    if (!win || bytes == 0 || bytes > win->drawingCacheBudget()) {
+        if (cache.image) {
+            discardDrawingCache();
+        }
+        draw(context);
+        return;
+    }
+
+    auto themeState = this->themeState();
+    if (!cache.isValid || !cache.image || cache.theme != &context.theme || cache.dpi != dpi
+        || cache.widthPx != widthPx || cache.heightPx != heightPx
+        || cache.themeState != themeState || cache.isWindowActive != context.isWindowActive) {
+        // Draw everything, not just context.drawRect, since the image will
+        // be reused for other areas.
+        auto bitmap = context.dc.createBitmap(kBitmapRGBA, widthPx, heightPx, dpi);
+        UIContext bitmapContext = { context.theme, *bitmap, bounds(), context.isWindowActive };
+        cache.isDrawing = true;
+        bitmap->beginDraw();
+        draw(bitmapContext);
+        bitmap->endDraw();
+        cache.isDrawing = false;
+        bool changedWhileDrawing = cache.changedWhileDrawing;
+        cache.changedWhileDrawing = false;
+
+        cache.image = bitmap->copyToImage();
+        if (!cache.image) {  // context cannot make images
+            discardDrawingCache();
+            draw(context);
+            return;
+        }
+        cache.isValid = !changedWhileDrawing;  // but still good enough for this draw
+        cache.theme = &context.theme;
+        cache.dpi = dpi;
+        cache.widthPx = widthPx;
+        cache.heightPx = heightPx;
+        cache.themeState = themeState;
+        cache.isWindowActive = context.isWindowActive;
+    }
+    if (cache.window && cache.window != win) {  // should not happen, but just in case
+        cache.window->removeCachedDrawing(this);
+    }
+    cache.window = win;
+    win->useCachedDrawing(this, bytes);  // might evict others, but not us
+
+    context.dc.drawImage(cache.image, Rect(PicaPt::kZero, PicaPt::kZero,
+                                           PicaPt::fromPixels(float(widthPx), dpi),
+                                           PicaPt::fromPixels(float(heightPx), dpi)));
+}
+
+void Widget::drawRecorded(UIContext& context)
+{
+    auto &cache = *mImpl->drawingCache;
+    auto &list = *cache.displayList;
+    auto dpi = context.dc.dpi();
+    int widthPx = int(std::ceil(frame().width.toPixels(dpi)));
+    int heightPx = int(std::ceil(frame().height.toPixels(dpi)));
+    auto themeState = this->themeState();
+    if (cache.isValid && cache.theme == &context.theme && cache.dpi == dpi
+        && cache.widthPx == widthPx && cache.heightPx == heightPx
+        && cache.themeState == themeState && cache.isWindowActive == context.isWindowActive) {
+        list.replay(context.dc);
+        return;
+    }
+
+    // Record everything, not just context.drawRect, since the list will be
+    // replayed for other areas.
+    list.clear();
+    RecordingDrawContext recorder(context.dc, &list);
+    UIContext recordingContext = { context.theme, recorder, bounds(), context.isWindowActive };
+    cache.isDrawing = true;
+    draw(recordingContext);
+    cache.isDrawing = false;
+    if (cache.changedWhileDrawing) {
+        // Do not hold on to references that might already be dangling.
+        cache.changedWhileDrawing = false;
+        list.clear();
+        cache.isValid = false;
+        return;
+    }
+
+    cache.isValid = true;
+    cache.theme = &context.theme;
+    cache.dpi = dpi;
+    cache.widthPx = widthPx;
+    cache.heightPx = heightPx;
+    cache.themeState = themeState;
+    cache.isWindowActive = context.isWindowActive;
+}
+
 void Widget::drawChild(UIContext& context, Widget *child)
 {
     if (child->visible()) {
@@ -873,7 +1451,14 @@ void Widget::drawChild(UIContext& context, Widget *child)
         auto newDrawRect = context.drawRect.intersectedWith(child->frame());
         newDrawRect.translate(-ul.x, -ul.y);  // this is faster than .translated(), though less convenient
         UIContext newContext = { context.theme, context.dc, newDrawRect, context.isWindowActive };
-        child->draw(newContext);
+        Instrumentation::ScopedWidgetCall profile(child, Instrumentation::WidgetCall::kDraw);
+        if (child->mImpl->drawingCache && child->mImpl->drawingCache->displayList) {
+            child->drawRecorded(newContext);
+        } else if (child->mImpl->drawingCache) {
+            child->drawCached(newContext);
+        } else {
+            child->draw(newContext);
+        }
 
         context.dc.translate(-ul.x, -ul.y);
     }
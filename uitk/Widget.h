@@ -48,10 +48,29 @@ public:
 
     /// Ensures that the widget is redrawn
     void setNeedsDraw();
-
-    /// Ensures that the widget is re-laidout.
+    /// Ensures that the rectangle (in local coordinates) is redrawn. This is
+    /// useful if only a small part of a large widget changed, such as a caret.
+    void setNeedsDraw(const Rect& localRect);
+
+    /// Ensures that the widget is re-laidout. Since a widget's preferred size
+    /// may depend on its children, the ancestors up to the nearest layout
+    /// boundary (see setIsLayoutBoundary()) are also re-laidout. Other
+    /// widgets are only re-laidout if their size changes. Layout is
+    /// deferred until the next draw, so calling this repeatedly is cheap.
     void setNeedsLayout();
 
+    /// Returns true if the widget is a layout boundary. A widget is a
+    /// boundary if this has been set, or if both fixedWidthEm() and
+    /// fixedHeightEm() are set.
+    bool isLayoutBoundary() const;
+    /// A layout boundary is a widget whose frame does not depend on its
+    /// contents, so changes to the layout of its children do not need to
+    /// re-layout its parent. Only set this if the widget's own layout()
+    /// sets the frames of all its children: if an ancestor sets them (as
+    /// ListView does for its items), that ancestor would not be re-laidout.
+    /// Defaults to false.
+    Widget* setIsLayoutBoundary(bool is);
+
     virtual const Rect& frame() const;
     /// The frame's coordinates are relative to its parent
     virtual Widget* setFrame(const Rect& frame);
@@ -114,6 +133,15 @@ public:
     /// for instance). This function is O(n).
     Widget* removeChild(Widget *w);
 
+    /// Inserts the widgets as children starting at index, taking ownership.
+    /// This only requests one layout, so it is much faster than calling
+    /// addChild() for each widget when adding many widgets.
+    Widget* insertChildren(int index, const std::vector<Widget*>& widgets);
+
+    /// Removes the children in [first, end) and returns ownership of them
+    /// to the caller. Like insertChildren(), this only requests one layout.
+    std::vector<Widget*> removeChildren(int first, int end);
+
     /// Removes all child widgets and returns ownership to the caller.
     /// This more efficient than calling removeChild(), but does require
     /// the call to have stored pointers to all the children.
@@ -213,6 +241,14 @@ public:
     /// nicely to pixel boundaries.
     virtual Size preferredSize(const LayoutContext& context) const;
 
+    /// Returns preferredSize(), caching the result by the constraints, the
+    /// DPI, and the theme. Layouts should use this to size their children,
+    /// since they may ask for the same size many times. The cache is cleared
+    /// by setNeedsLayout() on this widget or any of its descendants, and by
+    /// themeChanged(), so if you override preferredSize(), call
+    /// setNeedsLayout() whenever its result might change.
+    Size cachedPreferredSize(const LayoutContext& context) const;
+
     /// Lays out children according to the frame. Not intended to be called
     /// directly. If this is overridden, call the super-class layout().
     /// When Widget::layout() is called as a super call, it will only layout
@@ -234,6 +270,17 @@ public:
     /// can override this to do more specific testing.
     virtual bool hitTest(const Point& p);
 
+    bool usesHitTestIndex() const;
+    /// Containers with many children, such as a canvas with thousands of
+    /// items, can turn this on so that mouse events only hit-test the
+    /// children under the mouse, instead of every child. The index is
+    /// rebuilt lazily when the children or their frames change, so it is not
+    /// worth using if the children move on most events. Since children are
+    /// only hit-tested if the mouse is in their frame, this should not be
+    /// used if a child's hitTest() accepts points outside its frame.
+    /// Defaults to false.
+    Widget* setUsesHitTestIndex(bool uses);
+
     virtual EventResult mouse(const MouseEvent& e);
     virtual void mouseEntered();
     virtual void mouseExited();
@@ -256,6 +303,33 @@ public:
     /// track, but does not want the track to be the full frame.)
     virtual void draw(UIContext& context);
 
+    bool cachesDrawing() const;
+    /// Caches the drawing of this widget and its children in an image at the
+    /// window's resolution, which is drawn instead of calling draw() until
+    /// this widget or a child calls setNeedsDraw(), or its theme state, size,
+    /// or the DPI changes. This is useful for expensive widgets that seldom
+    /// change, such as charts drawn from many paths, but costs an image's
+    /// worth of memory and a redraw into the image for every change. The
+    /// cached drawings are limited by Window::drawingCacheBudget(). Since the
+    /// image is the size of the frame, this should not be used on widgets
+    /// that draw outside their frame. Defaults to false.
+    Widget* setCachesDrawing(bool caches);
+
+    bool recordsDrawing() const;
+    /// Records the draw calls this widget and its children make the first
+    /// time they are drawn, and replays the recording instead of calling
+    /// draw() until the same changes that would invalidate setCachesDrawing().
+    /// This skips the theme calls, style lookups, and text layout of drawing,
+    /// but still draws every shape at full resolution, so it is for widgets
+    /// whose draw() is expensive compared to what it draws, and uses much less
+    /// memory than setCachesDrawing(). The recording only references text
+    /// layouts that were created before it started, so a widget that keeps a
+    /// TextLayout it draws must call setNeedsDraw() when it releases the
+    /// layout, unless it only does so when its frame changes (like Label).
+    /// Setting this turns off setCachesDrawing(), and vice versa.
+    /// Defaults to false.
+    Widget* setRecordsDrawing(bool records);
+
     std::string debugDescription(); // for use in the debugger
     std::string debugDescription(const Point& offset = Point(PicaPt::kZero, PicaPt::kZero),
                                  int indent = 0) const;
@@ -309,6 +383,17 @@ protected:
     void drawChild(UIContext& context, Widget *child);
 
 private:
+    /// Calls layout() if this widget needs layout, otherwise calls
+    /// layoutIfNeeded() on any children that have descendants needing layout.
+    /// Returns true if anything was laid out.
+    bool layoutIfNeeded(const LayoutContext& context);  // for Window and layout()
+    /// Marks this widget and all its descendants as needing layout, without
+    /// requesting a layout from the window.
+    void setSubtreeNeedsLayout();  // for Window
+    void discardDrawingCache();  // for Window
+    void drawCached(UIContext& context);
+    void drawRecorded(UIContext& context);
+
     struct Impl;
     std::unique_ptr<Impl> mImpl;
 };
@@ -26,6 +26,7 @@
 #include "Cursor.h"
 #include "Dialog.h"
 #include "Events.h"
+#include "Instrumentation.h"
 #include "Label.h"
 #include "ListView.h"
 #include "OSCursor.h"
@@ -51,14 +52,77 @@
 #else
 #include "x11/X11Window.h"
 #endif
+#if !defined(__EMSCRIPTEN__)
+#include "headless/HeadlessWindow.h"
+#endif
 
 #include <nativedraw.h>
 
 #include <algorithm>
+#include <cmath>
+#include <list>
 #include <unordered_map>
 
 namespace uitk {
 
+namespace {
+static const float kDefaultRefreshRate = 60.0f;  // Hz, if the screen does not say
+
+// Adds the time until destruction to *secs, if instrumentation is enabled.
+class ScopedEventTime
+{
+public:
+    explicit ScopedEventTime(double *secs)
+    {
+        auto &app = Application::instance();
+        if (app.instrumentation().isEnabled()) {
+            mSecs = secs;
+            mStart = Instrumentation::now();
+        }
+    }
+
+    ~ScopedEventTime()
+    {
+        if (mSecs) {
+            *mSecs += Instrumentation::now() - mStart;
+        }
+    }
+
+    bool isInstrumenting() const { return (mSecs != nullptr); }
+
+    // Returns the event's time, or when handling started if the platform
+    // did not provide one.
+    double eventTime(double platformTime) const
+    {
+        return (platformTime > 0.0 ? platformTime : mStart);
+    }
+
+private:
+    double *mSecs = nullptr;
+    double mStart = 0.0;
+};
+
+// A window forwards some events to its popup. Only the event that came from
+// the OS is recorded, since replaying it forwards it again.
+static bool gForwardingToPopup = false;
+
+class ScopedForwardToPopup
+{
+public:
+    ScopedForwardToPopup() : mWasForwarding(gForwardingToPopup) { gForwardingToPopup = true; }
+    ~ScopedForwardToPopup() { gForwardingToPopup = mWasForwarding; }
+
+private:
+    bool mWasForwarding;
+};
+
+bool shouldRecordInput()
+{
+    return (Application::instance().instrumentation().isRecordingInput() && !gForwardingToPopup);
+}
+
+}  // namespace
+
 // Standard menu handlers
 namespace {
 
@@ -457,6 +521,22 @@ public:
 }  // namespace
 
 //-----------------------------------------------------------------------------
+namespace {
+
+// If there are more damaged rects than this, we just draw their bounding rect,
+// since each rect requires traversing the widget tree.
+static const size_t kMaxDamageRects = 8;
+static const size_t kDefaultDrawingCacheBudget = 64 * 1024 * 1024;
+
+Rect unionOfRects(const Rect& a, const Rect& b)
+{
+    auto x = std::min(a.x, b.x);
+    auto y = std::min(a.y, b.y);
+    return Rect(x, y, std::max(a.maxX(), b.maxX()) - x, std::max(a.maxY(), b.maxY()) - y);
+}
+
+}  // namespace
+
 enum class PopupState { kNone, kShowing, kCancelling };
 
 struct Window::Impl
@@ -496,6 +576,158 @@ struct Window::Impl
     bool inDraw = false;
     bool needsDraw = false;
     bool needsLayout = false;
+    float layoutDPI = 0.0f;
+
+    // The areas that need to be redrawn, in window coordinates. These do not
+    // overlap. If damagedEverything is true, the whole window will be drawn
+    // and `damage` is ignored.
+    std::vector<Rect> damage;
+    bool damagedEverything = true;
+    bool contentsPersist;  // cache of Application::windowContentsPersistBetweenDraws()
+
+    // Animation frame requests. The callbacks for the current tick are moved
+    // to `frameCallbacksRunning` so that requests made from a callback go to
+    // the next frame; a cancelled callback is set to nullptr.
+    struct FrameCallback {
+        AnimationFrameId id;
+        std::function<void(double)> f;
+    };
+    std::vector<FrameCallback> frameCallbacks;
+    std::vector<FrameCallback> frameCallbacksRunning;
+    AnimationFrameId nextFrameId = 1;
+    Application::ScheduledId frameTimer = Application::kInvalidScheduledId;
+    float frameTimerHz = 0.0f;
+
+    // Widgets' cached drawings (see Widget::setCachesDrawing()), most
+    // recently used first.
+    struct CachedDrawing {
+        Widget *widget;
+        size_t bytes;
+    };
+    std::list<CachedDrawing> cachedDrawings;
+    std::unordered_map<Widget*, std::list<CachedDrawing>::iterator> cachedDrawingsByWidget;
+    size_t cachedDrawingBytes = 0;
+    size_t drawingCacheBudget = kDefaultDrawingCacheBudget;
+
+    // For Instrumentation
+    unsigned long frameNumber = 0;
+    double eventSecsSinceFrame = 0.0;
+
+    void addDamage(const Rect& r)
+    {
+        if (this->damagedEverything || r.isEmpty()) {
+            return;
+        }
+
+        // Merge with anything that overlaps, so that nothing gets drawn twice.
+        // Since the merged rect is larger, it may now overlap a rect that it
+        // did not overlap previously, so we need to keep going until nothing
+        // more gets merged.
+        Rect newRect = r;
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (auto it = this->damage.begin();  it != this->damage.end();  ++it) {
+                if (it->intersects(newRect)) {
+                    newRect = unionOfRects(newRect, *it);
+                    this->damage.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        this->damage.push_back(newRect);
+
+        if (this->damage.size() > kMaxDamageRects) {
+            for (auto &d : this->damage) {
+                newRect = unionOfRects(newRect, d);
+            }
+            this->damage.clear();
+            this->damage.push_back(newRect);
+        }
+    }
+
+    void damageEverything()
+    {
+        this->damagedEverything = true;
+        this->damage.clear();
+    }
+
+    // Returns the rects to draw, snapped outward to pixel boundaries, and
+    // resets the damage.
+    std::vector<Rect> takeDrawRects(const DrawContext& dc, const Size& windowSize)
+    {
+        Rect windowRect(PicaPt::kZero, PicaPt::kZero, windowSize.width, windowSize.height);
+        std::vector<Rect> rects;
+        if (this->damagedEverything || !this->contentsPersist) {
+            rects.push_back(windowRect);
+        } else {
+            // Include an extra pixel, since antialiasing on the edges of a
+            // frame may touch the pixels just outside it.
+            auto onePx = dc.onePixel();
+            rects.reserve(this->damage.size());
+            for (auto &d : this->damage) {
+                auto x0 = dc.floorToNearestPixel(d.x) - onePx;
+                auto y0 = dc.floorToNearestPixel(d.y) - onePx;
+                auto x1 = dc.ceilToNearestPixel(d.maxX()) + onePx;
+                auto y1 = dc.ceilToNearestPixel(d.maxY()) + onePx;
+                auto r = Rect(x0, y0, x1 - x0, y1 - y0).intersectedWith(windowRect);
+                if (!r.isEmpty()) {
+                    rects.push_back(r);
+                }
+            }
+        }
+        this->damage.clear();
+        this->damagedEverything = false;
+        return rects;
+    }
+
+    void startFrameTimer(Window *w)
+    {
+        if (this->frameTimer != Application::kInvalidScheduledId) {
+            return;
+        }
+
+        // The rate is checked each time the clock starts, which is often enough
+        // to notice that the window moved to a different screen.
+        auto hz = this->window->osScreen().refreshRate;
+        this->frameTimerHz = (hz > 0.0f ? hz : kDefaultRefreshRate);
+        this->frameTimer = Application::instance().scheduleLater(w, 1.0f / this->frameTimerHz,
+                                                                 Application::ScheduleMode::kRepeating,
+                                                                 [this](Application::ScheduledId) {
+            tickAnimationFrame();
+        });
+    }
+
+    void stopFrameTimer()
+    {
+        if (this->frameTimer != Application::kInvalidScheduledId) {
+            Application::instance().cancelScheduled(this->frameTimer);
+            this->frameTimer = Application::kInvalidScheduledId;
+        }
+    }
+
+    void tickAnimationFrame()
+    {
+        // Snap the timestamp to the frame period, so that the difference between
+        // frames is a whole number of frames even if the timer is a little late.
+        auto period = 1.0 / double(this->frameTimerHz);
+        auto timestamp = std::floor(Application::instance().microTime() / period) * period;
+
+        this->frameCallbacksRunning.swap(this->frameCallbacks);
+        for (size_t i = 0;  i < this->frameCallbacksRunning.size();  ++i) {
+            // Copy: the callback may cancel itself
+            auto f = this->frameCallbacksRunning[i].f;
+            if (f) {
+                f(timestamp);
+            }
+        }
+        this->frameCallbacksRunning.clear();
+
+        if (this->frameCallbacks.empty()) {
+            stopFrameTimer();
+        }
+    }
 
     void cancelPopup()
     {
@@ -613,17 +845,25 @@ Window::Window(const std::string& title, int x, int y, int width, int height,
         }
     }
 
+#if !defined(__EMSCRIPTEN__)
+    if (Application::instance().isHeadless()) {
+        mImpl->window = std::make_unique<HeadlessWindow>(*this, title, x, y, width, height, flags);
+    }
+#endif
+    if (!mImpl->window) {
 #if defined(__APPLE__)
-    mImpl->window = std::make_unique<MacOSWindow>(*this, title, x, y, width, height, flags);
+        mImpl->window = std::make_unique<MacOSWindow>(*this, title, x, y, width, height, flags);
 #elif defined(_WIN32) || defined(_WIN64)
-    mImpl->window = std::make_unique<Win32Window>(*this, title, x, y, width, height, flags);
+        mImpl->window = std::make_unique<Win32Window>(*this, title, x, y, width, height, flags);
 #elif defined(__EMSCRIPTEN__)
-    mImpl->window = std::make_unique<WASMWindow>(*this, title, x, y, width, height, flags);
+        mImpl->window = std::make_unique<WASMWindow>(*this, title, x, y, width, height, flags);
 #else
-    mImpl->window = std::make_unique<X11Window>(*this, title, x, y, width, height, flags);
+        mImpl->window = std::make_unique<X11Window>(*this, title, x, y, width, height, flags);
 #endif
+    }
 
     mImpl->drawContextMightBeShared = Application::instance().windowsMightUseSameDrawContext();  // cache for faster drawing;
+    mImpl->contentsPersist = Application::instance().windowContentsPersistBetweenDraws();
 
     pushCursor(Cursor::arrow());
     addStandardMenuHandlers(*this);
@@ -643,10 +883,13 @@ Window::~Window()
     mImpl->rootWidget.reset();
 
     Application::instance().removeWindow(this);
+    Application::instance().instrumentation().removeWindow(this);
     if (!(mImpl->flags & Flags::kPopup)) {  // popups are not in the list, and
         updateWindowList();                 // updating the list is problematic
     }                                       // if moving to the window menu (Linux)
     mImpl->cancelPopup();
+    mImpl->stopFrameTimer();
+    mImpl->frameCallbacks.clear();
     // clear out refs that are sometimes referenced, in case deleting code
     // refers to them after they have been deleted.
     mImpl->grabbedWidget = nullptr;
@@ -667,6 +910,8 @@ OSWindow* Window::nativeWindow() { return mImpl->window.get(); }
 
 void* Window::nativeHandle() { return mImpl->window->nativeHandle(); }
 
+OSFrameStats Window::frameStats() const { return mImpl->window->frameStats(); }
+
 bool Window::isShowing() const { return mImpl->window->isShowing(); }
 
 Window* Window::show(bool show)
@@ -774,7 +1019,7 @@ void Window::resizeToFit()
         LayoutContext context{ *mImpl->theme, dc };
         Size size(PicaPt::kZero, PicaPt::kZero);
         for (auto *child : mImpl->rootWidget->children()) {
-            auto pref = child->preferredSize(context);
+            auto pref = child->cachedPreferredSize(context);
             size.width = std::max(size.width, pref.width);
             size.height = std::max(size.height, pref.height);
         }
@@ -835,6 +1080,18 @@ Screen Window::screen() const
 }
 
 void Window::setNeedsDraw()
+{
+    mImpl->damageEverything();
+    postRedrawUnlessHandlingEvent();
+}
+
+void Window::setNeedsDraw(const Rect& windowRect)
+{
+    mImpl->addDamage(windowRect);
+    postRedrawUnlessHandlingEvent();
+}
+
+void Window::postRedrawUnlessHandlingEvent()
 {
     // You'd think that we would never call setNeedsDraw() while drawing.
     // If we do, though, do not create an actual expose event (especially if
@@ -850,8 +1107,10 @@ void Window::setNeedsDraw()
 
 void Window::setNeedsLayout()
 {
+    // Widgets damage their old and new frames if the layout moves them,
+    // so there is no need to redraw everything.
     mImpl->needsLayout = true;
-    setNeedsDraw();
+    postRedrawUnlessHandlingEvent();
 }
 
 void Window::setNeedsAccessibilityUpdate()
@@ -968,6 +1227,8 @@ void Window::setFocusWidget(Widget *w, ShowFocusRing show /*= ShowFocusRing::kYe
     }
 
     if (isDifferent) {
+        // The focus ring is drawn outside the widget, so redraw everything
+        mImpl->damageEverything();
         mImpl->needsDraw = true;
     }
 }
@@ -1092,6 +1353,37 @@ void Window::moveKeyFocus(int dir)
     // Test: window with only widgets that do not accept focus
 }
 
+Window::AnimationFrameId Window::requestAnimationFrame(std::function<void(double)> f)
+{
+    auto id = mImpl->nextFrameId++;
+    mImpl->frameCallbacks.push_back({ id, f });
+    mImpl->startFrameTimer(this);
+    return id;
+}
+
+void Window::cancelAnimationFrame(AnimationFrameId id)
+{
+    auto &pending = mImpl->frameCallbacks;
+    auto it = std::find_if(pending.begin(), pending.end(),
+                           [id](const Impl::FrameCallback& fc) { return fc.id == id; });
+    if (it != pending.end()) {
+        pending.erase(it);
+        if (pending.empty() && mImpl->frameCallbacksRunning.empty()) {
+            mImpl->stopFrameTimer();
+        }
+        return;
+    }
+
+    // If we are in the tick, the callback might not have been called yet.
+    // (Do not erase, the tick is iterating.)
+    for (auto &fc : mImpl->frameCallbacksRunning) {
+        if (fc.id == id) {
+            fc.f = nullptr;
+            return;
+        }
+    }
+}
+
 PicaPt Window::borderWidth() const { return mImpl->window->borderWidth(); }
 
 void Window::setTooltip(Widget *tooltip)
@@ -1115,6 +1407,47 @@ Widget* Window::mouseoverWidget() const
     return mImpl->mouseoverWidget;
 }
 
+size_t Window::drawingCacheBudget() const { return mImpl->drawingCacheBudget; }
+
+void Window::setDrawingCacheBudget(size_t bytes)
+{
+    mImpl->drawingCacheBudget = bytes;
+    while (mImpl->cachedDrawingBytes > bytes && !mImpl->cachedDrawings.empty()) {
+        mImpl->cachedDrawings.back().widget->discardDrawingCache();  // calls removeCachedDrawing()
+    }
+}
+
+void Window::useCachedDrawing(Widget *w, size_t bytes)
+{
+    auto it = mImpl->cachedDrawingsByWidget.find(w);
+    if (it != mImpl->cachedDrawingsByWidget.end()) {
+        mImpl->cachedDrawingBytes -= it->second->bytes;
+        it->second->bytes = bytes;
+        mImpl->cachedDrawings.splice(mImpl->cachedDrawings.begin(), mImpl->cachedDrawings, it->second);
+    } else {
+        mImpl->cachedDrawings.push_front({ w, bytes });
+        mImpl->cachedDrawingsByWidget[w] = mImpl->cachedDrawings.begin();
+    }
+    mImpl->cachedDrawingBytes += bytes;
+
+    while (mImpl->cachedDrawingBytes > mImpl->drawingCacheBudget
+           && mImpl->cachedDrawings.back().widget != w) {
+        mImpl->cachedDrawings.back().widget->discardDrawingCache();  // calls removeCachedDrawing()
+    }
+}
+
+void Window::removeCachedDrawing(Widget *w)
+{
+    auto it = mImpl->cachedDrawingsByWidget.find(w);
+    if (it != mImpl->cachedDrawingsByWidget.end()) {
+        mImpl->cachedDrawingBytes -= it->second->bytes;
+        mImpl->cachedDrawings.erase(it->second);
+        mImpl->cachedDrawingsByWidget.erase(it);
+    }
+}
+
+bool Window::hasCachedDrawings() const { return !mImpl->cachedDrawings.empty(); }
+
 IPopupWindow* Window::popupWindow() const { return mImpl->activePopup; }
 
 void Window::setPopupWindow(IPopupWindow *popup)
@@ -1192,6 +1525,11 @@ Dialog* Window::endModalDialog()
 
 void Window::onMouse(const MouseEvent& eOrig)
 {
+    ScopedEventTime timer(&mImpl->eventSecsSinceFrame);
+    if (shouldRecordInput()) {
+        Application::instance().instrumentation().recordMouse(*this, eOrig);
+    }
+
     // macOS and Windows do not send events to a window under a dialog, but
     // X11 does.
     if (mImpl->dialog.dialog || mImpl->dialog.window) {
@@ -1227,6 +1565,7 @@ void Window::onMouse(const MouseEvent& eOrig)
                 } else {
                     ePopup.pos.y -= -PicaPt::fromPixels(popupUL.y - thisWindowUL.y, dpi);
                 }
+                ScopedForwardToPopup forwarding;
                 w->onMouse(ePopup);
             }
         }
@@ -1324,6 +1663,10 @@ void Window::onMouse(const MouseEvent& eOrig)
 
     mImpl->inMouse = false;
     if (mImpl->needsDraw) {
+        if (timer.isInstrumenting()) {
+            Application::instance().instrumentation().addInputAwaitingFrame(
+                    this, Instrumentation::InputType::kMouse, timer.eventTime(eOrig.time));
+        }
         postRedraw();
         mImpl->needsDraw = false;
     }
@@ -1331,6 +1674,11 @@ void Window::onMouse(const MouseEvent& eOrig)
 
 void Window::onKey(const KeyEvent &e)
 {
+    ScopedEventTime timer(&mImpl->eventSecsSinceFrame);
+    if (shouldRecordInput()) {
+        Application::instance().instrumentation().recordKey(*this, e);
+    }
+
     int menuId;
     if (!mImpl->dialog.dialog && e.type == KeyEvent::Type::kKeyDown && Application::instance().keyboardShortcuts().hasShortcut(e, &menuId)) {
         onMenuWillShow();  // make sure items are enabled/disabled for *this current* window
@@ -1347,6 +1695,7 @@ void Window::onKey(const KeyEvent &e)
     // Key events may be sent to the main window, instead of the popup window,
     // in which case we need to forward the event on.
     if (mImpl->activePopup) {
+        ScopedForwardToPopup forwarding;
         mImpl->activePopup->window()->onKey(e);
     } else {
         mImpl->inKey = true;
@@ -1381,6 +1730,10 @@ void Window::onKey(const KeyEvent &e)
         
         mImpl->inKey = false;
         if (mImpl->needsDraw) {
+            if (timer.isInstrumenting()) {
+                Application::instance().instrumentation().addInputAwaitingFrame(
+                        this, Instrumentation::InputType::kKey, timer.eventTime(e.time));
+            }
             postRedraw();
             mImpl->needsDraw = false;
         }
@@ -1389,9 +1742,15 @@ void Window::onKey(const KeyEvent &e)
 
 void Window::onText(const TextEvent& e)
 {
+    ScopedEventTime timer(&mImpl->eventSecsSinceFrame);
+    if (shouldRecordInput()) {
+        Application::instance().instrumentation().recordText(*this, e);
+    }
+
     // Text events may be sent to the main window, instead of the popup window,
     // in which case we need to forward the event on.
     if (mImpl->activePopup) {
+        ScopedForwardToPopup forwarding;
         mImpl->activePopup->window()->onText(e);
     } else {
         mImpl->inKey = true; // these are usually generated from key events
@@ -1400,6 +1759,10 @@ void Window::onText(const TextEvent& e)
         }
         mImpl->inKey = false;
         if (mImpl->needsDraw) {
+            if (timer.isInstrumenting()) {
+                Application::instance().instrumentation().addInputAwaitingFrame(
+                        this, Instrumentation::InputType::kText, timer.eventTime(e.time));
+            }
             postRedraw();
             mImpl->needsDraw = false;
         }
@@ -1415,6 +1778,12 @@ void Window::onResize(const DrawContext& dc)
     mImpl->inResize = true;
     onLayout(dc);
     mImpl->inResize = false;
+    mImpl->damageEverything();  // even if only the backbuffer changed
+
+    // After layout, so that contentRect() is the new size
+    if (shouldRecordInput()) {
+        Application::instance().instrumentation().recordResize(*this, contentRect().size(), dc.dpi());
+    }
 }
 
 void Window::onLayout(const DrawContext& dc)
@@ -1422,19 +1791,35 @@ void Window::onLayout(const DrawContext& dc)
     auto contentRect = mImpl->window->contentRect();
     LayoutContext context = { *mImpl->theme, dc };
 
+    // Widgets are only laid out if they changed, but everything changes
+    // if the DPI does.
+    if (dc.dpi() != mImpl->layoutDPI) {
+        mImpl->rootWidget->setSubtreeNeedsLayout();
+        if (mImpl->menubarWidget) {
+            mImpl->menubarWidget->setSubtreeNeedsLayout();
+        }
+        mImpl->layoutDPI = dc.dpi();
+        mImpl->damageEverything();
+    }
+
     auto y = contentRect.y;
     auto menubarHeight = PicaPt::kZero;
     if (mImpl->menubarWidget) {
-        menubarHeight = mImpl->menubarWidget->preferredSize(context).height;
+        menubarHeight = mImpl->menubarWidget->cachedPreferredSize(context).height;
         mImpl->menubarWidget->setFrame(Rect(contentRect.x, y, contentRect.width, menubarHeight));
-        mImpl->menubarWidget->layout(context);
+        mImpl->menubarWidget->layoutIfNeeded(context);
         y += menubarHeight;
         contentRect.height -= menubarHeight;
     }
 
     assert(y == dc.roundToNearestPixel(y));
-    mImpl->rootWidget->setFrame(Rect(contentRect.x, y,
-                                     contentRect.width, contentRect.height));
+    Rect rootFrame(contentRect.x, y, contentRect.width, contentRect.height);
+    if (!(rootFrame == mImpl->rootWidget->frame())) {
+        // The root widget has no parent to damage, so setFrame() will not.
+        // (This is normally from a resize, but the menubar may have changed.)
+        mImpl->damageEverything();
+    }
+    mImpl->rootWidget->setFrame(rootFrame);
     if (mImpl->onLayout) {
         mImpl->onLayout(*this, context);
     } else {
@@ -1446,9 +1831,39 @@ void Window::onLayout(const DrawContext& dc)
         }
     }
 
-    mImpl->rootWidget->layout(context);
+    {
+        Instrumentation::ScopedWidgetCall profile(mImpl->rootWidget.get(),
+                                                  Instrumentation::WidgetCall::kLayout);
+        mImpl->rootWidget->layout(context);
+    }
     mImpl->needsLayout = false;
+    // Anything that moved damaged its old and new frames in setFrame().
 
+    onLayoutChanged();
+}
+
+void Window::layoutWidgetsNeedingLayout(const DrawContext& dc)
+{
+    // Widget::setNeedsLayout() marked the layout boundaries that need layout,
+    // and also damaged them, so there is no need to redraw everything.
+    // (If the root widget itself needed layout, mImpl->needsLayout would
+    // be set instead.)
+    Widget* topLevel[] = { mImpl->rootWidget.get(), mImpl->menubarWidget.get() };
+    bool didLayout = false;
+    LayoutContext context = { *mImpl->theme, dc };
+    for (auto *w : topLevel) {
+        if (w && w->layoutIfNeeded(context)) {
+            didLayout = true;
+        }
+    }
+
+    if (didLayout) {
+        onLayoutChanged();
+    }
+}
+
+void Window::onLayoutChanged()
+{
     setNeedsAccessibilityUpdate();
     
     // Focus widget's frame may have changed; update so that IME position
@@ -1459,25 +1874,43 @@ void Window::onLayout(const DrawContext& dc)
     }
 }
 
-void Window::onDraw(DrawContext& dc)
+std::vector<Rect> Window::onDraw(DrawContext& realDC)
 {
     // Store global GetBorderTheme object so that we do not have to recreate it
     static GetBorderTheme gGetBorderTheme;
 
+    // If instrumenting, draw through a context that counts the calls.
+    auto &app = Application::instance();
+    auto &instr = app.instrumentation();
+    bool instrumenting = instr.isEnabled();
+    std::unique_ptr<DrawContext> countingDC;
+    FrameRecord frame{};
+    Instrumentation::Counts counts0;
+    if (instrumenting) {
+        countingDC = instr.countingDrawContext(realDC);
+        counts0 = instr.counts();
+        frame.startTime = Instrumentation::now();
+    }
+    DrawContext& dc = (countingDC ? *countingDC : realDC);
+
     // It's not clear when to re-layout. We could send a user message for layout,
     // but it's still going to delay a draw (since it is all done by the same
     // thread), so it seems like it is simpler just to do it on a draw.
-    if (mImpl->needsLayout) {
+    // Widgets often call setNeedsDraw() while laying out; since we are about
+    // to draw, mark that we are drawing so that those do not post another draw.
+    mImpl->inDraw = true;
+    if (mImpl->needsLayout || dc.dpi() != mImpl->layoutDPI) {
         onLayout(dc);
+    } else {
+        layoutWidgetsNeedingLayout(dc);
     }
+    double tLayoutEnd = (instrumenting ? Instrumentation::now() : 0.0);
 
-    Rect drawRect(PicaPt::kZero, PicaPt::kZero,
-                  mImpl->rootWidget->frame().width, mImpl->rootWidget->frame().height);
-    UIContext context { *mImpl->theme, dc, drawRect, mImpl->isActive };
-    auto size = Size(PicaPt::fromPixels(float(dc.width()), dc.dpi()),
-                     PicaPt::fromPixels(float(dc.height()), dc.dpi()));
+    // Use the window's size, not the context's: the backbuffer may be larger
+    // than the window while it is being resized.
+    auto size = mImpl->window->contentRect().size();
     auto rootUL = mImpl->rootWidget->frame().upperLeft();
-    mImpl->inDraw = true;
+    auto drawRects = mImpl->takeDrawRects(dc, size);
 
     // --- start draw ---
     dc.beginDraw();
@@ -1489,23 +1922,14 @@ void Window::onDraw(DrawContext& dc)
         dc.clipToRect(Rect(PicaPt::kZero, PicaPt::kZero, frame.width, frame.height));
     }
 
-    // Draw the background
-    if (mImpl->flags & Window::Flags::kPopup) {
-        mImpl->theme->drawMenuBackground(context, size);
-    } else {
-        mImpl->theme->drawWindowBackground(context, size);
-    }
-
-    // Draw the widgets
-    dc.translate(rootUL.x, rootUL.y);
-    mImpl->rootWidget->draw(context);
-    dc.translate(-rootUL.x, -rootUL.y);
-
-    // Draw the focus (if necessary). This is a bit of a hack: since there is no
+    // Find the focus (if necessary). This is a bit of a hack: since there is no
     // way to get the border path of a Widget, since the theme functions draw
     // the frame. So, we have a special Theme that just records the frame.
     bool cancelFocus = false;
-    if (context.isWindowActive && mImpl->focusedWidget && mImpl->showFocusRing) {
+    bool drawFocus = false;
+    Rect focusRect;
+    PicaPt focusRadius;
+    if (!drawRects.empty() && mImpl->isActive && mImpl->focusedWidget && mImpl->showFocusRing) {
         if (mImpl->focusedWidget->visible() && mImpl->focusedWidget->enabled()) {
             auto *w = mImpl->focusedWidget;
             while (w && w->showFocusRingOnParent()) {
@@ -1513,7 +1937,7 @@ void Window::onDraw(DrawContext& dc)
             }
             auto ul = w->convertToWindowFromLocal(Point::kZero);
 
-            gGetBorderTheme.setTheme(&context.theme);
+            gGetBorderTheme.setTheme(mImpl->theme.get());
             dc.save();
             dc.clipToRect(Rect()); // do not draw anything
             std::shared_ptr<DrawContext> fakeDC = gGetBorderTheme.drawContext(dc);
@@ -1522,7 +1946,7 @@ void Window::onDraw(DrawContext& dc)
             dc.restore();
 
             auto &path = gGetBorderTheme.path();
-            auto focusRect = path.rect;
+            focusRect = path.rect;
             if (path.type == GetBorderTheme::Type::kPath
                 || focusRect.width <= PicaPt::kZero || focusRect.height <= PicaPt::kZero)
             {
@@ -1530,10 +1954,11 @@ void Window::onDraw(DrawContext& dc)
                 focusRect = Rect(PicaPt::kZero, PicaPt::kZero, w->frame().width, w->frame().height);
             }
             focusRect.translate(ul.x, ul.y);
+            focusRadius = path.rectRadius;
             switch (gGetBorderTheme.path().type) {
                 case GetBorderTheme::Type::kRect:
                 case GetBorderTheme::Type::kEllipse:
-                    context.theme.drawFocusFrame(context, focusRect, path.rectRadius);
+                    drawFocus = true;
                     break;
                 case GetBorderTheme::Type::kPath:
                     // do nothing; we do not support this yet
@@ -1548,10 +1973,50 @@ void Window::onDraw(DrawContext& dc)
             cancelFocus = true;
         }
     }
+    double tFocusEnd = (instrumenting ? Instrumentation::now() : 0.0);
 
-    // Draw the menubar (if necessary)
-    if (mImpl->menubarWidget) {
-        mImpl->menubarWidget->draw(context);
+    // Draw each damaged area. The rects are in window coordinates, and the
+    // draw rect for each widget is in its own coordinates, so widgets that
+    // are outside the damaged area will not be drawn at all.
+    for (auto &drawRect : drawRects) {
+        UIContext context { *mImpl->theme, dc, drawRect, mImpl->isActive };
+        dc.save();
+        dc.clipToRect(drawRect);
+
+        // Draw the background
+        if (mImpl->flags & Window::Flags::kPopup) {
+            mImpl->theme->drawMenuBackground(context, size);
+        } else {
+            mImpl->theme->drawWindowBackground(context, size);
+        }
+
+        // Draw the widgets
+        dc.translate(rootUL.x, rootUL.y);
+        UIContext rootContext { *mImpl->theme, dc, drawRect.translated(-rootUL.x, -rootUL.y),
+                                mImpl->isActive };
+        {
+            Instrumentation::ScopedWidgetCall profile(mImpl->rootWidget.get(),
+                                                      Instrumentation::WidgetCall::kDraw);
+            mImpl->rootWidget->draw(rootContext);
+        }
+        dc.translate(-rootUL.x, -rootUL.y);
+
+        // Draw the focus (if necessary)
+        if (drawFocus) {
+            context.theme.drawFocusFrame(context, focusRect, focusRadius);
+        }
+
+        // Draw the menubar (if necessary)
+        if (mImpl->menubarWidget && drawRect.intersects(mImpl->menubarWidget->frame())) {
+            mImpl->menubarWidget->draw(context);
+        }
+
+        if (instr.showsHeatmap() && instr.isProfilingWidgets()) {
+            auto font = mImpl->theme->params().labelFont;
+            instr.drawWidgetHeatmap(*this, dc, drawRect, font.fontWithScaledPointSize(0.75f));
+        }
+
+        dc.restore();
     }
 
     if (mImpl->drawContextMightBeShared) {
@@ -1563,9 +2028,28 @@ void Window::onDraw(DrawContext& dc)
 
     mImpl->needsDraw = false;  // should be false anyway, just in case
 
+    if (instrumenting) {
+        auto &counts = instr.counts();
+        frame.window = this;
+        frame.windowTitle = mImpl->title;
+        frame.frameNumber = ++mImpl->frameNumber;
+        frame.eventSecs = mImpl->eventSecsSinceFrame;
+        frame.layoutSecs = tLayoutEnd - frame.startTime;
+        frame.focusRingSecs = tFocusEnd - tLayoutEnd;
+        frame.drawSecs = Instrumentation::now() - tFocusEnd;
+        frame.presentSecs = 0.0;
+        frame.nPreferredSizeCalls = counts.preferredSize - counts0.preferredSize;
+        frame.nTextLayouts = counts.textLayouts - counts0.textLayouts;
+        frame.nDrawCalls = counts.drawCalls - counts0.drawCalls;
+        instr.addFrame(frame);
+    }
+    mImpl->eventSecsSinceFrame = 0.0;
+
     if (cancelFocus) {  // this *will* require a redraw, so do last.
         setFocusWidget(nullptr);
     }
+
+    return drawRects;
 }
 
 void Window::onActivated(const Point& currentMousePos)
@@ -1625,6 +2109,7 @@ void Window::onActivated(const Point& currentMousePos)
     }
 
     // Always redraw, so that the accent color returns back from grey.
+    mImpl->damageEverything();
     postRedraw();
 }
 
@@ -1643,6 +2128,7 @@ void Window::onDeactivated()
     if (mImpl->onDidDeactivate) {
         mImpl->onDidDeactivate(*this);
     }
+    mImpl->damageEverything();
     postRedraw();
 }
 
@@ -1693,7 +2179,8 @@ void Window::onMenuActivated(MenuId id)
 void Window::onThemeChanged()
 {
     mImpl->rootWidget->themeChanged(*mImpl->theme);
-    setNeedsDraw();
+    setNeedsLayout();  // sizes may have changed
+    setNeedsDraw();  // and everything looks different
 }
 
 void Window::onUpdateAccessibility()
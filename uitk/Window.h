@@ -216,10 +216,20 @@ public:
     /// Remove child (if it is a child), and returns ownership to the caller.
     Widget* removeChild(Widget *child);
 
-    /// Schedules a redraw.
+    /// Schedules a redraw of the entire window.
     void setNeedsDraw();
 
-    /// Schedules a layout
+    /// Schedules a redraw of the rectangle, which is in window coordinates
+    /// (the coordinate system of contentRect()). If the platform keeps the
+    /// window contents between draws, only the areas that have been passed
+    /// to this function since the last draw will be redrawn. Generally you
+    /// should call Widget::setNeedsDraw() instead.
+    void setNeedsDraw(const Rect& windowRect);
+
+    /// Schedules a layout of the window's contents. Widgets are only laid out
+    /// if they need it (see Widget::setNeedsLayout()) or their size changes,
+    /// and only the widgets that move or resize are redrawn; also call
+    /// setNeedsDraw() if the whole window needs to be redrawn.
     void setNeedsLayout();
 
     /// Updates accessibility information (if active). Mouse presses, key events,
@@ -227,6 +237,25 @@ public:
     /// call this directly.
     void setNeedsAccessibilityUpdate();
 
+    using AnimationFrameId = unsigned long;
+    static constexpr AnimationFrameId kInvalidAnimationFrameId = 0;
+
+    /// Calls f once at the start of the next frame, before the window lays
+    /// out and draws. The timestamp is the time of the frame, in seconds, on
+    /// the same clock as Application::microTime(); all the callbacks in a
+    /// frame get the same timestamp, so animations in a window stay in sync.
+    /// To keep animating, request another frame from the callback.
+    /// All the requests for the window are handled in one tick per frame,
+    /// paced to the refresh rate of the window's screen (or 60 Hz if the
+    /// platform does not report one), and the tick stops while there are
+    /// no requests. This is the preferred way to animate; scheduleLater()
+    /// is not precise enough, and each timer causes its own redraw.
+    /// If f refers to an object, cancel the request before the object is
+    /// deleted.
+    AnimationFrameId requestAnimationFrame(std::function<void(double)> f);
+    /// Cancels the request, if it has not been called yet.
+    void cancelAnimationFrame(AnimationFrameId id);
+
     PicaPt borderWidth() const;
 
     /// Shows the tooltip based on the current mouse point. Takes ownership of
@@ -239,6 +268,10 @@ public:
     OSWindow* nativeWindow();
     void* nativeHandle();
 
+    /// Returns the accumulated draw and present times of the window's frames
+    /// (see OSFrameStats). Currently only X11 records these.
+    OSFrameStats frameStats() const;
+
     /// Sets a callback that will be called whenever a menu item needs to
     /// update its checked or enabled state; currently this is right before
     /// the menu is opened, and is called for all menu items.
@@ -298,6 +331,20 @@ public:
     /// previous if negative.
     void moveKeyFocus(int dir);
 
+    /// The memory budget for the drawings of this window's widgets that are
+    /// cached with Widget::setCachesDrawing(), in bytes. When the cached
+    /// drawings exceed it, the least recently drawn are discarded (and drawn
+    /// again when needed). Default is 64 MB.
+    size_t drawingCacheBudget() const;
+    void setDrawingCacheBudget(size_t bytes);
+
+    /// These are internal, for Widget::setCachesDrawing(). Records that the
+    /// widget's cached drawing was used, discarding the least recently used
+    /// drawings if over the budget.
+    void useCachedDrawing(Widget *w, size_t bytes);
+    void removeCachedDrawing(Widget *w);
+    bool hasCachedDrawings() const;
+
     // On macOS windows without a titlebar do not get activated/deactivated
     // messages, so we need to register the popup window
     void setPopupWindow(IPopupWindow *popup);
@@ -315,7 +362,7 @@ public:
 
     void onResize(const DrawContext& dc) override;
     void onLayout(const DrawContext& dc) override;
-    void onDraw(DrawContext& dc) override;
+    std::vector<Rect> onDraw(DrawContext& dc) override;
     void onMouse(const MouseEvent& e) override;
     void onKey(const KeyEvent& e) override;
     void onText(const TextEvent& e) override;
@@ -335,6 +382,10 @@ protected:
     void postRedraw() const;
 
 private:
+    void postRedrawUnlessHandlingEvent();
+    void layoutWidgetsNeedingLayout(const DrawContext& dc);
+    void onLayoutChanged();
+
     struct Impl;
     std::unique_ptr<Impl> mImpl;
 };
@@ -0,0 +1,349 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "HeadlessApplication.h"
+
+#include "HeadlessWindow.h"
+#include "../Application.h"
+#include "../Clipboard.h"
+#include "../Events.h"
+#include "../Sound.h"
+#include "../themes/EmpireTheme.h"
+#include "../private/PlatformUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace uitk {
+
+namespace {
+static const char *kHeadlessEnvVar = "UITK_HEADLESS";
+
+static bool gHeadlessRequested = false;
+
+class HeadlessClipboard : public Clipboard
+{
+public:
+    bool hasString() const override { return !mString.empty(); }
+    std::string string() const override { return mString; }
+    void setString(const std::string& utf8) override { mString = utf8; }
+
+    bool supportsX11SelectionString() const override { return false; }
+    void setX11SelectionString(const std::string& utf8) override {}
+    std::string x11SelectionString() const override { return ""; }
+
+private:
+    std::string mString;
+};
+
+class HeadlessSound : public Sound
+{
+public:
+    void play(int16_t *samples, uint32_t count, int rateHz, int nChannels, Loop loop = Loop::kNo) override {}
+    void stop() override {}
+};
+
+HeadlessWindow* headlessWindow(Window& w)
+{
+    return static_cast<HeadlessWindow*>(w.nativeHandle());
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+struct HeadlessApplication::Impl
+{
+    TimePoint t0;
+    // Only the main thread advances the clock, but scheduleLater() reads it
+    // from whatever thread it is called on (such as a background task).
+    std::atomic<TimePoint> now;
+    HeadlessClipboard clipboard;
+    mutable HeadlessSound sound;
+    DeferredFunctions<HeadlessWindow*> postedLater;
+    std::vector<HeadlessWindow*> windows;  // we do not own these
+    std::vector<HeadlessWindow*> needsDraw;
+    bool exitWhenLastWindowCloses = true;
+    bool exitRequested = false;
+
+    bool isRegistered(HeadlessWindow *w) const
+    {
+        return (std::find(windows.begin(), windows.end(), w) != windows.end());
+    }
+
+    int nShowingWindows() const
+    {
+        return int(std::count_if(windows.begin(), windows.end(),
+                                 [](HeadlessWindow *w) { return w->isShowing(); }));
+    }
+
+    void drawWindows()
+    {
+        // Drawing can post another redraw (or, in principle, close a
+        // window), so work from a copy.
+        auto windowsToDraw = std::move(needsDraw);
+        needsDraw.clear();
+        for (auto *w : windowsToDraw) {
+            if (isRegistered(w) && w->isShowing()) {
+                w->onDraw();
+            }
+        }
+    }
+};
+
+bool HeadlessApplication::isRequested()  // static
+{
+    if (gHeadlessRequested) {
+        return true;
+    }
+    auto *env = getenv(kHeadlessEnvVar);
+    return (env && env[0] != '\0' && strcmp(env, "0") != 0);
+}
+
+void HeadlessApplication::setRequested(bool requested)  // static
+{
+    gHeadlessRequested = requested;
+}
+
+HeadlessApplication::HeadlessApplication()
+    : mImpl(new Impl())
+{
+    mImpl->t0 = std::chrono::steady_clock::now();
+    mImpl->now = mImpl->t0;
+    auto *impl = mImpl.get();
+    mImpl->postedLater.setClock([impl]() { return impl->now.load(); });
+}
+
+HeadlessApplication::~HeadlessApplication()
+{
+}
+
+void HeadlessApplication::setExitWhenLastWindowCloses(bool exits)
+{
+    mImpl->exitWhenLastWindowCloses = exits;
+}
+
+int HeadlessApplication::run()
+{
+    mImpl->exitRequested = false;
+    while (true) {
+        processEvents();
+
+        if (mImpl->exitRequested) {
+            break;
+        }
+        if (mImpl->exitWhenLastWindowCloses && mImpl->nShowingWindows() == 0) {
+            break;
+        }
+
+        TimePoint next;
+        if (mImpl->postedLater.nextTime(&next)) {
+            mImpl->now = std::max(mImpl->now.load(), next);
+        } else if (mImpl->needsDraw.empty()) {
+            // Background tasks that are still running will schedule their
+            // completions, so wait for them before deciding that nothing can
+            // ever happen again.
+            Application::instance().waitForBackgroundTasks();
+            if (!mImpl->postedLater.nextTime(&next)) {
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+void HeadlessApplication::exitRun()
+{
+    mImpl->exitRequested = true;
+}
+
+void HeadlessApplication::scheduleLater(Window* w, std::function<void()> f)
+{
+    scheduleLater(w, 0, false, [f](SchedulingId) { f(); });
+}
+
+OSApplication::SchedulingId HeadlessApplication::scheduleLater(
+                                            Window* w, float delay, bool repeat,
+                                            std::function<void(SchedulingId)> f)
+{
+    HeadlessWindow *hw = nullptr;
+    if (w) {
+        hw = headlessWindow(*w);
+    }
+    return mImpl->postedLater.add(hw, delay, repeat, f);
+}
+
+void HeadlessApplication::cancelScheduled(SchedulingId id)
+{
+    mImpl->postedLater.remove(id);
+}
+
+std::string HeadlessApplication::applicationName() const
+{
+    return "App";  // This is only used on menus on macOS
+}
+
+std::string HeadlessApplication::appDataPath() const
+{
+    return "./";
+}
+
+std::string HeadlessApplication::tempDir() const
+{
+    for (auto *var : { "TMPDIR", "TEMP", "TMP" }) {
+        auto *dir = getenv(var);
+        if (dir && dir[0] != '\0') {
+            return dir;
+        }
+    }
+    return "/tmp";
+}
+
+std::vector<std::string> HeadlessApplication::availableFontFamilies() const
+{
+    return Font::availableFontFamilies();
+}
+
+void HeadlessApplication::beep()
+{
+}
+
+Sound& HeadlessApplication::sound() const
+{
+    return mImpl->sound;
+}
+
+void HeadlessApplication::printDocument(const PrintSettings& settings) const
+{
+    debugPrint("[uitk] HeadlessApplication::printDocument(): there is no printer");
+}
+
+void HeadlessApplication::debugPrint(const std::string& s) const
+{
+    std::cout << s << std::endl;
+}
+
+bool HeadlessApplication::isOriginInUpperLeft() const { return true; }
+
+bool HeadlessApplication::isWindowBorderInsideWindowFrame() const { return true; }
+
+bool HeadlessApplication::windowsMightUseSameDrawContext() const { return false; }
+
+// Each window has its own bitmap, which is only recreated on resize.
+bool HeadlessApplication::windowContentsPersistBetweenDraws() const { return true; }
+
+bool HeadlessApplication::shouldHideScrollbars() const { return false; }
+
+bool HeadlessApplication::canKeyFocusEverything() const { return true; }
+
+bool HeadlessApplication::platformHasMenubar() const { return true; }
+
+Clipboard& HeadlessApplication::clipboard() const { return mImpl->clipboard; }
+
+Theme::Params HeadlessApplication::themeParams() const
+{
+    // Always the same, regardless of the system settings, so that results
+    // are reproducible.
+    return EmpireTheme::defaultParams();
+}
+
+HeadlessApplication::TimePoint HeadlessApplication::now() const
+{
+    return mImpl->now;
+}
+
+double HeadlessApplication::currentTime() const
+{
+    return double(std::chrono::duration_cast<std::chrono::microseconds>(mImpl->now.load() - mImpl->t0).count()) / 1e6;
+}
+
+void HeadlessApplication::processEvents()
+{
+    mImpl->postedLater.executeTick();
+    mImpl->drawWindows();
+}
+
+void HeadlessApplication::advanceTime(double secs)
+{
+    auto end = mImpl->now.load() + std::chrono::microseconds(int64_t(std::round(secs * 1e6)));
+    TimePoint next;
+    while (mImpl->postedLater.nextTime(&next) && next <= end) {
+        mImpl->now = std::max(mImpl->now.load(), next);
+        processEvents();
+    }
+    mImpl->now = std::max(mImpl->now.load(), end);
+    processEvents();
+}
+
+void HeadlessApplication::injectMouse(Window& w, const MouseEvent& e)
+{
+    headlessWindow(w)->onMouse(e);
+}
+
+void HeadlessApplication::injectKey(Window& w, const KeyEvent& e)
+{
+    headlessWindow(w)->onKey(e);
+}
+
+void HeadlessApplication::injectText(Window& w, const TextEvent& e)
+{
+    headlessWindow(w)->onText(e);
+}
+
+void HeadlessApplication::injectResize(Window& w, int widthPx, int heightPx)
+{
+    headlessWindow(w)->onResize(widthPx, heightPx);
+}
+
+std::shared_ptr<DrawContext> HeadlessApplication::windowBitmap(Window& w) const
+{
+    return headlessWindow(w)->bitmap();
+}
+
+void HeadlessApplication::registerWindow(HeadlessWindow *w)
+{
+    mImpl->windows.push_back(w);
+}
+
+void HeadlessApplication::unregisterWindow(HeadlessWindow *w)
+{
+    auto &windows = mImpl->windows;
+    windows.erase(std::remove(windows.begin(), windows.end(), w), windows.end());
+    auto &needsDraw = mImpl->needsDraw;
+    needsDraw.erase(std::remove(needsDraw.begin(), needsDraw.end(), w), needsDraw.end());
+    mImpl->postedLater.removeForWindow(w);
+}
+
+void HeadlessApplication::postRedraw(HeadlessWindow *w)
+{
+    auto &needsDraw = mImpl->needsDraw;
+    if (std::find(needsDraw.begin(), needsDraw.end(), w) == needsDraw.end()) {
+        needsDraw.push_back(w);
+    }
+}
+
+}  // namespace uitk
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef UITK_HEADLESS_APPLICATION_H
+#define UITK_HEADLESS_APPLICATION_H
+
+#include "../OSApplication.h"
+
+#include <chrono>
+#include <memory>
+
+namespace uitk {
+
+struct KeyEvent;
+struct MouseEvent;
+struct TextEvent;
+class HeadlessWindow;
+
+/// An OSApplication that does not connect to a window system: windows draw
+/// into offscreen bitmaps, events only arrive by being injected, and time is
+/// a virtual clock that only moves when advanced. This makes it suitable for
+/// benchmarks and for tests that run in CI, since the results do not depend
+/// on the machine's display or on how long anything took to run.
+///
+/// The headless backend is used if the UITK_HEADLESS environment variable is
+/// set (to anything other than "0"), or if HeadlessApplication::setRequested()
+/// was called before creating the Application. Application::isHeadless()
+/// returns true when it is in use, and then
+///   auto &headless = static_cast<HeadlessApplication&>(app.osApplication());
+/// gives access to the functions below.
+class HeadlessApplication : public OSApplication
+{
+public:
+    using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
+
+    /// Returns true if the headless backend should be used.
+    static bool isRequested();
+    /// Requests (or un-requests) the headless backend regardless of the
+    /// environment. Must be called before the Application is created.
+    static void setRequested(bool requested);
+
+    HeadlessApplication();
+    ~HeadlessApplication();
+
+    void setExitWhenLastWindowCloses(bool exits) override;
+    /// Runs until exitRun() is called or there is nothing left to do,
+    /// jumping the virtual clock forward to each scheduled function instead
+    /// of waiting for it. Note that a repeating function (such as a blinking
+    /// cursor or an animation) means there is always something left to do,
+    /// so usually it is better to use advanceTime(). Background tasks that
+    /// are still running count as something left to do, since they will
+    /// schedule their onDone functions; run() waits for them in real time.
+    int run() override;
+    void exitRun() override;
+
+    void scheduleLater(Window* w, std::function<void()> f) override;
+    SchedulingId scheduleLater(Window* w, float delay, bool repeat,
+                               std::function<void(SchedulingId)> f) override;
+    void cancelScheduled(SchedulingId id) override;
+
+    std::string applicationName() const override;
+    std::string appDataPath() const override;
+    std::string tempDir() const override;
+    std::vector<std::string> availableFontFamilies() const override;
+
+    void beep() override;
+    Sound& sound() const override;
+
+    void printDocument(const PrintSettings& settings) const override;
+
+    void debugPrint(const std::string& s) const override;
+
+    bool isOriginInUpperLeft() const override;
+    bool isWindowBorderInsideWindowFrame() const override;
+    bool windowsMightUseSameDrawContext() const override;
+    bool windowContentsPersistBetweenDraws() const override;
+    bool shouldHideScrollbars() const override;
+    bool canKeyFocusEverything() const override;
+    bool platformHasMenubar() const override;
+
+    Clipboard& clipboard() const override;
+
+    Theme::Params themeParams() const override;
+
+public:
+    /// Returns the virtual time. This starts at the (real) time the object
+    /// was created and only changes in advanceTime() and run().
+    TimePoint now() const;
+    /// Returns the number of seconds of virtual time since creation.
+    double currentTime() const;
+
+    /// Runs the functions that are due at the current virtual time, and
+    /// then draws the windows that need drawing. This is one iteration of
+    /// the event loop.
+    void processEvents();
+    /// Moves the virtual clock forward by `secs`, running each scheduled
+    /// function at the time it is due (and drawing after it, like a real
+    /// event loop would), and then calls processEvents().
+    void advanceTime(double secs);
+
+    /// Delivers the event to the window, as if the window system had sent
+    /// it. Positions are in window coordinates. Events are delivered
+    /// immediately; call processEvents() to draw the results.
+    void injectMouse(Window& w, const MouseEvent& e);
+    void injectKey(Window& w, const KeyEvent& e);
+    void injectText(Window& w, const TextEvent& e);
+    /// Resizes the window's content area (in pixels), as if the user had
+    /// resized it.
+    void injectResize(Window& w, int widthPx, int heightPx);
+
+    /// Returns the bitmap the window draws into, for reading back pixels
+    /// with pixelAt() or copyToImage(). The bitmap is recreated when the
+    /// window is resized.
+    std::shared_ptr<DrawContext> windowBitmap(Window& w) const;
+
+public:
+    // This is roughly equivalent to the OS API
+    void registerWindow(HeadlessWindow *w);
+    void unregisterWindow(HeadlessWindow *w);
+    void postRedraw(HeadlessWindow *w);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+} // namespace uitk
+#endif // UITK_HEADLESS_APPLICATION_H
@@ -0,0 +1,82 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "HeadlessCursor.h"
+
+#include "../OSWindow.h"
+
+namespace uitk {
+
+namespace {
+static const float kCursorSizePx = 32.0f;
+}  // namespace
+
+HeadlessCursor::HeadlessCursor(OSCursor::System id)
+    : mId(id)
+{
+}
+
+HeadlessCursor::~HeadlessCursor()
+{
+}
+
+void HeadlessCursor::set(OSWindow *oswindow /*= nullptr*/, void *windowSystem /*= nullptr*/) const
+{
+}
+
+void HeadlessCursor::getHotspotPx(float *x, float *y) const
+{
+    // The arrow points at the upper left, everything else is centered.
+    float hotspot = (mId == OSCursor::System::kArrow ? 0.0f : 0.5f * kCursorSizePx);
+    if (x) {
+        *x = hotspot;
+    }
+    if (y) {
+        *y = hotspot;
+    }
+}
+
+void HeadlessCursor::getSizePx(float *width, float *height) const
+{
+    if (width) {
+        *width = kCursorSizePx;
+    }
+    if (height) {
+        *height = kCursorSizePx;
+    }
+}
+
+Rect HeadlessCursor::rectForPosition(OSWindow *oswindow, const Point& pos) const
+{
+    auto dpi = oswindow->dpi();
+    float hotspotX, hotspotY;
+    getHotspotPx(&hotspotX, &hotspotY);
+    Rect r(pos.x, pos.y,
+           PicaPt::fromPixels(kCursorSizePx, dpi),
+           PicaPt::fromPixels(kCursorSizePx, dpi));
+    r.translate(PicaPt::fromPixels(-hotspotX, dpi),
+                PicaPt::fromPixels(-hotspotY, dpi));
+    return r;
+}
+
+}  // namespace uitk
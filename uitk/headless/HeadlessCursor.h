@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef UITK_HEADLESS_CURSOR_H
+#define UITK_HEADLESS_CURSOR_H
+
+#include "../OSCursor.h"
+
+namespace uitk {
+
+// There is no pointer to show, so setting a cursor does nothing, but the
+// sizes are plausible so that tooltips and such are placed as usual.
+class HeadlessCursor : public OSCursor
+{
+public:
+    HeadlessCursor(OSCursor::System id);
+    ~HeadlessCursor();
+
+    void set(OSWindow *oswindow = nullptr, void *windowSystem = nullptr) const override;
+    void getHotspotPx(float *x, float *y) const override;
+    void getSizePx(float *width, float *height) const override;
+    Rect rectForPosition(OSWindow *oswindow, const Point& pos) const override;
+
+private:
+    OSCursor::System mId;
+};
+
+}  // namespace uitk
+#endif // UITK_HEADLESS_CURSOR_H
@@ -0,0 +1,305 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "HeadlessWindow.h"
+
+#include "HeadlessApplication.h"
+#include "../Application.h"
+#include "../Events.h"
+
+#include <nativedraw.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace uitk {
+
+namespace {
+// A fixed DPI, so that the layout (and therefore the pixels) does not
+// depend on the machine that is running the benchmark or test.
+static const float kHeadlessDPI = 96.0f;
+static const float kScreenWidthPx = 1920.0f;
+static const float kScreenHeightPx = 1080.0f;
+static const float kScreenRefreshRate = 60.0f;
+
+HeadlessApplication& getHeadlessApplication()
+{
+    return static_cast<HeadlessApplication&>(Application::instance().osApplication());
+}
+
+}  // namespace
+
+struct HeadlessWindow::Impl
+{
+    IWindowCallbacks& callbacks;
+    Window::Flags::Value flags;
+    std::string title;
+    OSRect frame;  // pixels; the content is the whole frame
+    std::shared_ptr<DrawContext> dc;
+#if !defined(__APPLE__) && !defined(_WIN32) && !defined(_WIN64)
+    // Cairo bitmaps are created from an existing context.
+    std::shared_ptr<DrawContext> cairoDC;
+#endif
+    bool showing = false;
+    bool needsLayout = true;
+    Point mouseLocation;
+    TextEditorLogic *textEditor = nullptr;
+    Rect textRect;
+
+    void resize(int w, int h)
+    {
+        // A zero-sized bitmap is not valid
+        w = std::max(1, w);
+        h = std::max(1, h);
+        this->frame.width = float(w);
+        this->frame.height = float(h);
+#if defined(__APPLE__)
+        this->dc = DrawContext::createCoreGraphicsBitmap(kBitmapRGBA, w, h, kHeadlessDPI);
+#elif defined(_WIN32) || defined(_WIN64)
+        this->dc = DrawContext::createDirect2DBitmap(kBitmapRGBA, w, h, kHeadlessDPI);
+#else
+        if (!this->cairoDC) {
+            this->cairoDC = DrawContext::createCairoPDF(nullptr, 1, 1, 72.0f);
+        }
+        this->dc = this->cairoDC->createBitmap(kBitmapRGBA, w, h, kHeadlessDPI);
+#endif
+        this->needsLayout = true;
+    }
+};
+
+HeadlessWindow::HeadlessWindow(IWindowCallbacks& callbacks,
+                               const std::string& title, int width, int height,
+                               Window::Flags::Value flags)
+    : HeadlessWindow(callbacks, title, -1, -1, width, height, flags)
+{}
+
+HeadlessWindow::HeadlessWindow(IWindowCallbacks& callbacks,
+                               const std::string& title, int x, int y,
+                               int width, int height,
+                               Window::Flags::Value flags)
+    : mImpl(new Impl{callbacks})
+{
+    mImpl->flags = flags;
+    mImpl->title = title;
+    mImpl->frame.x = float(std::max(0, x));
+    mImpl->frame.y = float(std::max(0, y));
+    mImpl->resize(width, height);
+
+    getHeadlessApplication().registerWindow(this);
+}
+
+HeadlessWindow::~HeadlessWindow()
+{
+    getHeadlessApplication().unregisterWindow(this);
+}
+
+bool HeadlessWindow::isShowing() const { return mImpl->showing; }
+
+void HeadlessWindow::show(bool show,
+                          std::function<void(const DrawContext&)> onWillShow)
+{
+    if (show == mImpl->showing) {
+        return;
+    }
+
+    if (show) {
+        if (onWillShow) {
+            onWillShow(*mImpl->dc);
+        }
+        mImpl->showing = true;
+        // A real window system sends a resize when the window is first
+        // mapped, which is what does the initial layout.
+        mImpl->callbacks.onResize(*mImpl->dc);
+        mImpl->needsLayout = false;
+        postRedraw();
+    } else {
+        mImpl->showing = false;
+    }
+}
+
+void HeadlessWindow::toggleMinimize()
+{
+}
+
+void HeadlessWindow::toggleMaximize()
+{
+    onResize(int(kScreenWidthPx), int(kScreenHeightPx));
+}
+
+void HeadlessWindow::close()
+{
+    if (onWindowShouldClose()) {
+        onWindowWillClose();
+        show(false, nullptr);
+    }
+}
+
+void HeadlessWindow::raiseToTop() const
+{
+}
+
+void HeadlessWindow::setTitle(const std::string& title)
+{
+    mImpl->title = title;
+}
+
+void HeadlessWindow::setCursor(const Cursor& cursor)
+{
+}
+
+Rect HeadlessWindow::contentRect() const
+{
+    return Rect(PicaPt::kZero, PicaPt::kZero,
+                PicaPt::fromPixels(mImpl->frame.width, kHeadlessDPI),
+                PicaPt::fromPixels(mImpl->frame.height, kHeadlessDPI));
+}
+
+OSRect HeadlessWindow::osContentRect() const
+{
+    return osFrame();
+}
+
+void HeadlessWindow::setContentSize(const Size& size)
+{
+    onResize(int(std::round(size.width.toPixels(kHeadlessDPI))),
+             int(std::round(size.height.toPixels(kHeadlessDPI))));
+}
+
+float HeadlessWindow::dpi() const { return kHeadlessDPI; }
+
+OSRect HeadlessWindow::osFrame() const { return mImpl->frame; }
+
+void HeadlessWindow::setOSFrame(float x, float y, float width, float height)
+{
+    mImpl->frame.x = x;
+    mImpl->frame.y = y;
+    onResize(int(std::round(width)), int(std::round(height)));
+}
+
+PicaPt HeadlessWindow::borderWidth() const { return PicaPt::kZero; }
+
+OSScreen HeadlessWindow::osScreen() const
+{
+    return { { 0.0f, 0.0f, kScreenWidthPx, kScreenHeightPx },
+             { 0.0f, 0.0f, kScreenWidthPx, kScreenHeightPx },
+             kHeadlessDPI,
+             kScreenRefreshRate
+           };
+}
+
+void HeadlessWindow::postRedraw() const
+{
+    getHeadlessApplication().postRedraw(const_cast<HeadlessWindow*>(this));
+}
+
+void HeadlessWindow::beginModalDialog(OSWindow *w)
+{
+    w->show(true, [](const uitk::DrawContext&) {});
+}
+
+void HeadlessWindow::endModalDialog(OSWindow *w)
+{
+    w->show(false, [](const uitk::DrawContext&) {});
+}
+
+Point HeadlessWindow::currentMouseLocation() const
+{
+    return mImpl->mouseLocation;
+}
+
+void* HeadlessWindow::nativeHandle() { return this; }
+IWindowCallbacks& HeadlessWindow::callbacks() { return mImpl->callbacks; }
+
+void HeadlessWindow::callWithLayoutContext(std::function<void(const DrawContext&)> f)
+{
+    f(*mImpl->dc);
+}
+
+void HeadlessWindow::setTextEditing(TextEditorLogic *te, const Rect& frame)
+{
+    mImpl->textEditor = te;
+    mImpl->textRect = frame;
+}
+
+void HeadlessWindow::setNeedsAccessibilityUpdate()
+{
+    // there is nobody to be accessible to
+}
+
+void HeadlessWindow::setAccessibleElements(const std::vector<AccessibilityInfo>& elements)
+{
+    // there is nobody to be accessible to
+}
+
+std::shared_ptr<DrawContext> HeadlessWindow::bitmap() const { return mImpl->dc; }
+
+void HeadlessWindow::onResize(int width, int height)
+{
+    if (float(width) == mImpl->frame.width && float(height) == mImpl->frame.height) {
+        return;
+    }
+
+    mImpl->resize(width, height);
+    if (mImpl->showing) {
+        mImpl->callbacks.onResize(*mImpl->dc);
+        mImpl->needsLayout = false;
+        postRedraw();
+    }
+}
+
+void HeadlessWindow::onDraw()
+{
+    if (mImpl->needsLayout) {
+        mImpl->callbacks.onLayout(*mImpl->dc);
+        mImpl->needsLayout = false;
+    }
+    mImpl->callbacks.onDraw(*mImpl->dc);
+}
+
+void HeadlessWindow::onMouse(const MouseEvent& e)
+{
+    mImpl->mouseLocation = e.pos;
+    mImpl->callbacks.onMouse(e);
+}
+
+void HeadlessWindow::onKey(const KeyEvent& e)
+{
+    mImpl->callbacks.onKey(e);
+}
+
+void HeadlessWindow::onText(const TextEvent& e)
+{
+    mImpl->callbacks.onText(e);
+}
+
+bool HeadlessWindow::onWindowShouldClose()
+{
+    return mImpl->callbacks.onWindowShouldClose();
+}
+
+void HeadlessWindow::onWindowWillClose()
+{
+    mImpl->callbacks.onWindowWillClose();
+}
+
+}  // namespace uitk
@@ -216,6 +216,8 @@ bool MacOSApplication::isWindowBorderInsideWindowFrame() const { return true; }
 
 bool MacOSApplication::windowsMightUseSameDrawContext() const { return false; }
 
+bool MacOSApplication::windowContentsPersistBetweenDraws() const { return false; }
+
 bool MacOSApplication::shouldHideScrollbars() const { return true; }
 
 bool MacOSApplication::canKeyFocusEverything() const
@@ -35,6 +35,7 @@
 #include "../OSCursor.h"
 #include "../TextEditorLogic.h"
 #include "../Widget.h"
+#include "../private/PlatformUtils.h"
 #include "../private/Utils.h"
 #include <nativedraw.h>
 
@@ -114,6 +115,13 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     }
 }
 
+uitk::EventClock gEventClock;
+
+double toUITKTime(NSEvent *e)
+{
+    return gEventClock.toNow(e.timestamp);  // seconds since boot
+}
+
 }  // namespace
 
 //-----------------------------------------------------------------------------
@@ -386,6 +394,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     me.pos = uitk::Point(uitk::PicaPt::fromPixels(pt.x, dpi),
                          uitk::PicaPt::fromPixels(self.frame.size.height - pt.y, dpi));
     me.keymods = toKeymods(e.modifierFlags);
+    me.time = toUITKTime(e);
 
     [self doOnMouse:me];
 }
@@ -416,6 +425,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     me.pos = uitk::Point(uitk::PicaPt::fromPixels(pt.x, dpi),
                          uitk::PicaPt::fromPixels(self.frame.size.height - pt.y, dpi));
     me.keymods = toKeymods(e.modifierFlags);
+    me.time = toUITKTime(e);
     me.button.button = toUITKMouseButton(e.buttonNumber);
     me.button.nClicks = int(e.clickCount);
 
@@ -434,6 +444,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     me.pos = uitk::Point(uitk::PicaPt::fromPixels(pt.x, dpi),
                          uitk::PicaPt::fromPixels(self.frame.size.height - pt.y, dpi));
     me.keymods = toKeymods(e.modifierFlags);
+    me.time = toUITKTime(e);
     me.drag.buttons = 0;
     if (NSEvent.pressedMouseButtons & (1 << 0)) {
         me.drag.buttons |= int(uitk::MouseButton::kLeft);
@@ -480,6 +491,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     me.pos = uitk::Point(uitk::PicaPt::fromPixels(pt.x, dpi),
                          uitk::PicaPt::fromPixels(self.frame.size.height - pt.y, dpi));
     me.keymods = toKeymods(e.modifierFlags);
+    me.time = toUITKTime(e);
     me.button.button = toUITKMouseButton(e.buttonNumber);
 
     [self doOnMouse:me];
@@ -497,6 +509,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     me.pos = uitk::Point(uitk::PicaPt::fromPixels(pt.x, dpi),
                          uitk::PicaPt::fromPixels(self.frame.size.height - pt.y, dpi));
     me.keymods = toKeymods(e.modifierFlags);
+    me.time = toUITKTime(e);
     CGFloat dx, dy;
     if (e.hasPreciseScrollingDeltas) {  // trackpad
         dx = e.scrollingDeltaX;
@@ -549,6 +562,7 @@ uitk::MouseButton toUITKMouseButton(NSInteger buttonNumber)
     ke.keymods = toKeymods(e.modifierFlags);
     ke.isRepeat = (e.isARepeat == YES ? true : false);
     ke.key = toKey(e);
+    ke.time = toUITKTime(e);
 
     self.inEvent = true;
     self.callbacks->onKey(ke);
@@ -1084,12 +1098,17 @@ OSScreen MacOSWindow::osScreen() const
         DrawContext::getScreenDPI((__bridge void *)screen, &uiDPI, nullptr, nullptr);
         auto desktop = screen.visibleFrame;
         auto fullscreen = screen.frame;
+        float refreshRate = 0.0f;
+        if (@available(macOS 12.0, *)) {
+            refreshRate = float(screen.maximumFramesPerSecond);
+        }
         return {
             { float(desktop.origin.x), float(desktop.origin.y),
               float(desktop.size.width), float(desktop.size.height) },
             { float(fullscreen.origin.x), float(fullscreen.origin.y),
               float(fullscreen.size.width), float(fullscreen.size.height) },
-            uiDPI
+            uiDPI,
+            refreshRate
         };
     } else {
         return { OSRect{0, 0, 0, 0}, OSRect{0, 0, 0, 0}, 96.0f };
@@ -0,0 +1,479 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "DisplayList.h"
+
+namespace uitk {
+
+void DisplayList::clear()
+{
+    mCommands.clear();
+    mColors.clear();
+    mLengths.clear();
+    mPoints.clear();
+    mFonts.clear();
+    mStrings.clear();
+    mPaths.clear();
+    mImages.clear();
+    mGradients.clear();
+    mLayouts.clear();
+    mOwnedLayouts.clear();
+}
+
+DisplayList::Command& DisplayList::add(Op op)
+{
+    mCommands.emplace_back();
+    mCommands.back().op = op;
+    return mCommands.back();
+}
+
+Gradient& DisplayList::gradient(DrawContext& dc, uint32_t index) const
+{
+    auto &ref = mGradients[index];
+    if (!ref.stops.empty()) {
+        return dc.getGradient(ref.stops);
+    }
+    return *ref.gradient;
+}
+
+void DisplayList::replay(DrawContext& dc) const
+{
+    auto rect = [](const Command& c) {
+        return Rect(PicaPt(c.args[0]), PicaPt(c.args[1]), PicaPt(c.args[2]), PicaPt(c.args[3]));
+    };
+    auto point = [](const Command& c, int i) {
+        return Point(PicaPt(c.args[i]), PicaPt(c.args[i + 1]));
+    };
+
+    for (auto &c : mCommands) {
+        switch (c.op) {
+            case Op::kSave:
+                dc.save();
+                break;
+            case Op::kRestore:
+                dc.restore();
+                break;
+            case Op::kTranslate:
+                dc.translate(PicaPt(c.args[0]), PicaPt(c.args[1]));
+                break;
+            case Op::kRotate:
+                dc.rotate(c.args[0]);
+                break;
+            case Op::kScale:
+                dc.scale(c.args[0], c.args[1]);
+                break;
+            case Op::kSetFillColor:
+                dc.setFillColor(mColors[c.index]);
+                break;
+            case Op::kSetStrokeColor:
+                dc.setStrokeColor(mColors[c.index]);
+                break;
+            case Op::kSetStrokeWidth:
+                dc.setStrokeWidth(PicaPt(c.args[0]));
+                break;
+            case Op::kSetStrokeEndCap:
+                dc.setStrokeEndCap(EndCapStyle(c.mode));
+                break;
+            case Op::kSetStrokeJoinStyle:
+                dc.setStrokeJoinStyle(JoinStyle(c.mode));
+                break;
+            case Op::kSetStrokeDashes:
+                dc.setStrokeDashes(std::vector<PicaPt>(mLengths.begin() + c.index,
+                                                       mLengths.begin() + c.index + c.count),
+                                   PicaPt(c.args[0]));
+                break;
+            case Op::kFill:
+                dc.fill(mColors[c.index]);
+                break;
+            case Op::kClearRect:
+                dc.clearRect(rect(c));
+                break;
+            case Op::kDrawLines:
+                dc.drawLines(std::vector<Point>(mPoints.begin() + c.index,
+                                                mPoints.begin() + c.index + c.count));
+                break;
+            case Op::kDrawRect:
+                dc.drawRect(rect(c), PaintMode(c.mode));
+                break;
+            case Op::kDrawRoundedRect:
+                // The radius does not fit in args, so it is in mLengths
+                dc.drawRoundedRect(rect(c), mLengths[c.index], PaintMode(c.mode));
+                break;
+            case Op::kDrawEllipse:
+                dc.drawEllipse(rect(c), PaintMode(c.mode));
+                break;
+            case Op::kDrawPath:
+                dc.drawPath(mPaths[c.index], PaintMode(c.mode));
+                break;
+            case Op::kDrawLinearGradientPath:
+                dc.drawLinearGradientPath(mPaths[c.index], gradient(dc, c.count),
+                                          point(c, 0), point(c, 2));
+                break;
+            case Op::kDrawRadialGradientPath:
+                dc.drawRadialGradientPath(mPaths[c.index], gradient(dc, c.count),
+                                          point(c, 0), PicaPt(c.args[2]), PicaPt(c.args[3]));
+                break;
+            case Op::kDrawText:
+                dc.drawText(mStrings[c.index].c_str(), point(c, 0), mFonts[c.count],
+                            PaintMode(c.mode));
+                break;
+            case Op::kDrawTextLayout:
+                dc.drawText(*mLayouts[c.index], point(c, 0));
+                break;
+            case Op::kDrawImage:
+                dc.drawImage(mImages[c.index], rect(c));
+                break;
+            case Op::kClipToRect:
+                dc.clipToRect(rect(c));
+                break;
+            case Op::kClipToPath:
+                dc.clipToPath(mPaths[c.index]);
+                break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+namespace {
+
+void setRect(float *args, const Rect& r)
+{
+    args[0] = r.x.asFloat();
+    args[1] = r.y.asFloat();
+    args[2] = r.width.asFloat();
+    args[3] = r.height.asFloat();
+}
+
+void setPoint(float *args, const Point& p)
+{
+    args[0] = p.x.asFloat();
+    args[1] = p.y.asFloat();
+}
+
+}  // namespace
+
+RecordingDrawContext::RecordingDrawContext(DrawContext& realDC, DisplayList *list)
+    : DrawContext(nullptr, realDC.width(), realDC.height(), realDC.dpi(), realDC.dpi())
+    , mRealDC(realDC), mList(list)
+{
+}
+
+std::shared_ptr<TextLayout> RecordingDrawContext::created(std::shared_ptr<TextLayout> layout) const
+{
+    if (layout) {
+        mCreatedLayouts.push_back(layout);
+    }
+    return layout;
+}
+
+uint32_t RecordingDrawContext::addGradient(Gradient& gradient)
+{
+    DisplayList::GradientRef ref = { &gradient, {} };
+    for (auto &created : mCreatedGradients) {
+        if (created.gradient == &gradient) {
+            ref.stops = created.stops;
+            break;
+        }
+    }
+    mList->mGradients.push_back(ref);
+    return uint32_t(mList->mGradients.size() - 1);
+}
+
+std::shared_ptr<DrawContext> RecordingDrawContext::createBitmap(BitmapType type, int width, int height,
+                                                                float dpi /*= 72.0f*/)
+    { return mRealDC.createBitmap(type, width, height, dpi); }
+
+std::shared_ptr<DrawableImage> RecordingDrawContext::createDrawableImage(const Image& image) const
+    { return mRealDC.createDrawableImage(image); }
+
+std::shared_ptr<BezierPath> RecordingDrawContext::createBezierPath() const
+    { return mRealDC.createBezierPath(); }
+
+std::shared_ptr<TextLayout> RecordingDrawContext::createTextLayout(
+            const char *utf8, const Font& font, const Color& color,
+            const Size& size /*= Size::kZero*/,
+            int alignment /*= Alignment::kLeft | Alignment::kTop*/,
+            TextWrapping wrap /*= kWrapWord*/) const
+    { return created(mRealDC.createTextLayout(utf8, font, color, size, alignment, wrap)); }
+
+std::shared_ptr<TextLayout> RecordingDrawContext::createTextLayout(
+            const Text& t,
+            const Size& size /*= Size::kZero*/,
+            int alignment /*= Alignment::kLeft | Alignment::kTop*/,
+            TextWrapping wrap /*= kWrapWord*/) const
+    { return created(mRealDC.createTextLayout(t, size, alignment, wrap)); }
+
+std::shared_ptr<TextLayout> RecordingDrawContext::createTextLayout(
+            const Text& t,
+            const Font& defaultReplacementFont,
+            const Color& defaultReplacementColor,
+            const Size& size /*= Size::kZero*/,
+            int alignment /*= Alignment::kLeft | Alignment::kTop*/,
+            TextWrapping wrap /*= kWrapWord*/) const
+{
+    return created(mRealDC.createTextLayout(t, defaultReplacementFont, defaultReplacementColor,
+                                            size, alignment, wrap));
+}
+
+Gradient& RecordingDrawContext::getGradient(const std::vector<Gradient::Stop>& stops)
+{
+    auto &gradient = mRealDC.getGradient(stops);
+    mCreatedGradients.push_back({ &gradient, stops });
+    return gradient;
+}
+
+Gradient& RecordingDrawContext::getGradient(size_t id) const
+    { return mRealDC.getGradient(id); }
+
+void RecordingDrawContext::beginDraw() { mRealDC.beginDraw(); }
+void RecordingDrawContext::endDraw() { mRealDC.endDraw(); }
+
+void RecordingDrawContext::save()
+{
+    mList->add(DisplayList::Op::kSave);
+    mRealDC.save();
+}
+
+void RecordingDrawContext::restore()
+{
+    mList->add(DisplayList::Op::kRestore);
+    mRealDC.restore();
+}
+
+void RecordingDrawContext::translate(const PicaPt& dx, const PicaPt& dy)
+{
+    auto &c = mList->add(DisplayList::Op::kTranslate);
+    c.args[0] = dx.asFloat();
+    c.args[1] = dy.asFloat();
+    mRealDC.translate(dx, dy);
+}
+
+void RecordingDrawContext::rotate(float degrees)
+{
+    mList->add(DisplayList::Op::kRotate).args[0] = degrees;
+    mRealDC.rotate(degrees);
+}
+
+void RecordingDrawContext::scale(float sx, float sy)
+{
+    auto &c = mList->add(DisplayList::Op::kScale);
+    c.args[0] = sx;
+    c.args[1] = sy;
+    mRealDC.scale(sx, sy);
+}
+
+void RecordingDrawContext::setFillColor(const Color& color)
+{
+    mList->add(DisplayList::Op::kSetFillColor).index = uint32_t(mList->mColors.size());
+    mList->mColors.push_back(color);
+    mRealDC.setFillColor(color);
+}
+
+void RecordingDrawContext::setStrokeColor(const Color& color)
+{
+    mList->add(DisplayList::Op::kSetStrokeColor).index = uint32_t(mList->mColors.size());
+    mList->mColors.push_back(color);
+    mRealDC.setStrokeColor(color);
+}
+
+void RecordingDrawContext::setStrokeWidth(const PicaPt& w)
+{
+    mList->add(DisplayList::Op::kSetStrokeWidth).args[0] = w.asFloat();
+    mRealDC.setStrokeWidth(w);
+}
+
+void RecordingDrawContext::setStrokeEndCap(EndCapStyle cap)
+{
+    mList->add(DisplayList::Op::kSetStrokeEndCap).mode = uint8_t(cap);
+    mRealDC.setStrokeEndCap(cap);
+}
+
+void RecordingDrawContext::setStrokeJoinStyle(JoinStyle join)
+{
+    mList->add(DisplayList::Op::kSetStrokeJoinStyle).mode = uint8_t(join);
+    mRealDC.setStrokeJoinStyle(join);
+}
+
+void RecordingDrawContext::setStrokeDashes(const std::vector<PicaPt> lengths, const PicaPt& offset)
+{
+    auto &c = mList->add(DisplayList::Op::kSetStrokeDashes);
+    c.index = uint32_t(mList->mLengths.size());
+    c.count = uint32_t(lengths.size());
+    c.args[0] = offset.asFloat();
+    mList->mLengths.insert(mList->mLengths.end(), lengths.begin(), lengths.end());
+    mRealDC.setStrokeDashes(lengths, offset);
+}
+
+Color RecordingDrawContext::fillColor() const { return mRealDC.fillColor(); }
+Color RecordingDrawContext::strokeColor() const { return mRealDC.strokeColor(); }
+PicaPt RecordingDrawContext::strokeWidth() const { return mRealDC.strokeWidth(); }
+EndCapStyle RecordingDrawContext::strokeEndCap() const { return mRealDC.strokeEndCap(); }
+JoinStyle RecordingDrawContext::strokeJoinStyle() const { return mRealDC.strokeJoinStyle(); }
+
+void RecordingDrawContext::fill(const Color& color)
+{
+    mList->add(DisplayList::Op::kFill).index = uint32_t(mList->mColors.size());
+    mList->mColors.push_back(color);
+    mRealDC.fill(color);
+}
+
+void RecordingDrawContext::clearRect(const Rect& rect)
+{
+    setRect(mList->add(DisplayList::Op::kClearRect).args, rect);
+    mRealDC.clearRect(rect);
+}
+
+void RecordingDrawContext::drawLines(const std::vector<Point>& lines)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawLines);
+    c.index = uint32_t(mList->mPoints.size());
+    c.count = uint32_t(lines.size());
+    mList->mPoints.insert(mList->mPoints.end(), lines.begin(), lines.end());
+    mRealDC.drawLines(lines);
+}
+
+void RecordingDrawContext::drawRect(const Rect& rect, PaintMode mode)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawRect);
+    c.mode = uint8_t(mode);
+    setRect(c.args, rect);
+    mRealDC.drawRect(rect, mode);
+}
+
+void RecordingDrawContext::drawRoundedRect(const Rect& rect, const PicaPt& radius, PaintMode mode)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawRoundedRect);
+    c.mode = uint8_t(mode);
+    c.index = uint32_t(mList->mLengths.size());
+    setRect(c.args, rect);
+    mList->mLengths.push_back(radius);
+    mRealDC.drawRoundedRect(rect, radius, mode);
+}
+
+void RecordingDrawContext::drawEllipse(const Rect& rect, PaintMode mode)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawEllipse);
+    c.mode = uint8_t(mode);
+    setRect(c.args, rect);
+    mRealDC.drawEllipse(rect, mode);
+}
+
+void RecordingDrawContext::drawPath(std::shared_ptr<BezierPath> path, PaintMode mode)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawPath);
+    c.mode = uint8_t(mode);
+    c.index = uint32_t(mList->mPaths.size());
+    mList->mPaths.push_back(path);
+    mRealDC.drawPath(path, mode);
+}
+
+void RecordingDrawContext::drawLinearGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                                  const Point& start, const Point& end)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawLinearGradientPath);
+    c.index = uint32_t(mList->mPaths.size());
+    c.count = addGradient(gradient);
+    setPoint(c.args, start);
+    setPoint(c.args + 2, end);
+    mList->mPaths.push_back(path);
+    mRealDC.drawLinearGradientPath(path, gradient, start, end);
+}
+
+void RecordingDrawContext::drawRadialGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                                  const Point& center, const PicaPt& startRadius,
+                                                  const PicaPt& endRadius)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawRadialGradientPath);
+    c.index = uint32_t(mList->mPaths.size());
+    c.count = addGradient(gradient);
+    setPoint(c.args, center);
+    c.args[2] = startRadius.asFloat();
+    c.args[3] = endRadius.asFloat();
+    mList->mPaths.push_back(path);
+    mRealDC.drawRadialGradientPath(path, gradient, center, startRadius, endRadius);
+}
+
+void RecordingDrawContext::drawText(const char *textUTF8, const Point& topLeft, const Font& font,
+                                    PaintMode mode)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawText);
+    c.mode = uint8_t(mode);
+    c.index = uint32_t(mList->mStrings.size());
+    c.count = uint32_t(mList->mFonts.size());
+    setPoint(c.args, topLeft);
+    mList->mStrings.push_back(textUTF8);
+    mList->mFonts.push_back(font);
+    mRealDC.drawText(textUTF8, topLeft, font, mode);
+}
+
+void RecordingDrawContext::drawText(const TextLayout& layout, const Point& topLeft)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawTextLayout);
+    c.index = uint32_t(mList->mLayouts.size());
+    setPoint(c.args, topLeft);
+    mList->mLayouts.push_back(&layout);
+    for (auto &created : mCreatedLayouts) {
+        if (created.get() == &layout) {
+            mList->mOwnedLayouts.push_back(created);
+            break;
+        }
+    }
+    mRealDC.drawText(layout, topLeft);
+}
+
+void RecordingDrawContext::drawImage(std::shared_ptr<DrawableImage> image, const Rect& destRect)
+{
+    auto &c = mList->add(DisplayList::Op::kDrawImage);
+    c.index = uint32_t(mList->mImages.size());
+    setRect(c.args, destRect);
+    mList->mImages.push_back(image);
+    mRealDC.drawImage(image, destRect);
+}
+
+void RecordingDrawContext::clipToRect(const Rect& rect)
+{
+    setRect(mList->add(DisplayList::Op::kClipToRect).args, rect);
+    mRealDC.clipToRect(rect);
+}
+
+void RecordingDrawContext::clipToPath(std::shared_ptr<BezierPath> path)
+{
+    mList->add(DisplayList::Op::kClipToPath).index = uint32_t(mList->mPaths.size());
+    mList->mPaths.push_back(path);
+    mRealDC.clipToPath(path);
+}
+
+Color RecordingDrawContext::pixelAt(int x, int y) { return mRealDC.pixelAt(x, y); }
+
+std::shared_ptr<DrawableImage> RecordingDrawContext::copyToImage() { return mRealDC.copyToImage(); }
+
+Font::Metrics RecordingDrawContext::fontMetrics(const Font& font) const
+    { return mRealDC.fontMetrics(font); }
+
+TextMetrics RecordingDrawContext::textMetrics(const char *textUTF8, const Font& font,
+                                              PaintMode mode /*= kPaintFill*/) const
+    { return mRealDC.textMetrics(textUTF8, font, mode); }
+
+void RecordingDrawContext::calcContextPixel(const Point& point, float *x, float *y)
+    { mRealDC.calcContextPixel(point, x, y); }
+
+}  // namespace uitk
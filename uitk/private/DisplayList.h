@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_DISPLAY_LIST_H
+#define UITK_DISPLAY_LIST_H
+
+#define ND_NAMESPACE uitk
+#include <nativedraw.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace uitk {
+
+// A recording of the calls made to a DrawContext, which can be replayed into
+// a DrawContext later without redoing whatever work produced the calls.
+// Paths, images, and text layouts created while recording are kept alive by
+// the list; text layouts created before recording began are only referenced,
+// so the list must be cleared (or at least never replayed again) once the
+// owner of such a layout releases it. Widget does this by invalidating the
+// recording when a descendant is resized, added, or removed.
+// Gradients are owned by the context that made them, so gradients requested
+// while recording are requested again by their stops when replaying; others
+// are only referenced, like text layouts.
+class DisplayList
+{
+public:
+    void clear();
+    bool empty() const { return mCommands.empty(); }
+    size_t size() const { return mCommands.size(); }
+
+    void replay(DrawContext& dc) const;
+
+private:
+    friend class RecordingDrawContext;
+
+    enum class Op : uint8_t {
+        kSave, kRestore, kTranslate, kRotate, kScale,
+        kSetFillColor, kSetStrokeColor, kSetStrokeWidth, kSetStrokeEndCap,
+        kSetStrokeJoinStyle, kSetStrokeDashes,
+        kFill, kClearRect, kDrawLines, kDrawRect, kDrawRoundedRect, kDrawEllipse,
+        kDrawPath, kDrawLinearGradientPath, kDrawRadialGradientPath,
+        kDrawText, kDrawTextLayout, kDrawImage, kClipToRect, kClipToPath
+    };
+    // The meaning of the fields depends on the op; index (and count) refer
+    // to one of the arrays below.
+    struct Command {
+        Op op;
+        uint8_t mode = 0;  // PaintMode, EndCapStyle, or JoinStyle
+        uint32_t index = 0;
+        uint32_t count = 0;
+        float args[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    };
+
+    std::vector<Command> mCommands;
+    std::vector<Color> mColors;
+    std::vector<PicaPt> mLengths;  // dashes
+    std::vector<Point> mPoints;
+    std::vector<Font> mFonts;
+    std::vector<std::string> mStrings;
+    std::vector<std::shared_ptr<BezierPath>> mPaths;
+    std::vector<std::shared_ptr<DrawableImage>> mImages;
+    struct GradientRef {
+        Gradient *gradient;
+        std::vector<Gradient::Stop> stops;  // if not empty, get the gradient from these instead
+    };
+    std::vector<GradientRef> mGradients;
+    std::vector<const TextLayout*> mLayouts;
+    std::vector<std::shared_ptr<TextLayout>> mOwnedLayouts;
+
+    Command& add(Op op);
+    Gradient& gradient(DrawContext& dc, uint32_t index) const;
+};
+
+// Forwards everything to the real context, recording the calls that affect
+// the drawing into the display list.
+class RecordingDrawContext : public DrawContext
+{
+public:
+    RecordingDrawContext(DrawContext& realDC, DisplayList *list);
+
+    std::shared_ptr<DrawContext> createBitmap(BitmapType type, int width, int height,
+                                              float dpi = 72.0f) override;
+    std::shared_ptr<DrawableImage> createDrawableImage(const Image& image) const override;
+    std::shared_ptr<BezierPath> createBezierPath() const override;
+    std::shared_ptr<TextLayout> createTextLayout(
+                const char *utf8, const Font& font, const Color& color,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override;
+    std::shared_ptr<TextLayout> createTextLayout(
+                const Text& t,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override;
+    std::shared_ptr<TextLayout> createTextLayout(
+                const Text& t,
+                const Font& defaultReplacementFont,
+                const Color& defaultReplacementColor,
+                const Size& size = Size::kZero,
+                int alignment = Alignment::kLeft | Alignment::kTop,
+                TextWrapping wrap = kWrapWord) const override;
+    Gradient& getGradient(const std::vector<Gradient::Stop>& stops) override;
+    Gradient& getGradient(size_t id) const override;
+
+    void beginDraw() override;
+    void endDraw() override;
+
+    void save() override;
+    void restore() override;
+    void translate(const PicaPt& dx, const PicaPt& dy) override;
+    void rotate(float degrees) override;
+    void scale(float sx, float sy) override;
+    void setFillColor(const Color& color) override;
+    void setStrokeColor(const Color& color) override;
+    void setStrokeWidth(const PicaPt& w) override;
+    void setStrokeEndCap(EndCapStyle cap) override;
+    void setStrokeJoinStyle(JoinStyle join) override;
+    void setStrokeDashes(const std::vector<PicaPt> lengths, const PicaPt& offset) override;
+    Color fillColor() const override;
+    Color strokeColor() const override;
+    PicaPt strokeWidth() const override;
+    EndCapStyle strokeEndCap() const override;
+    JoinStyle strokeJoinStyle() const override;
+    void fill(const Color& color) override;
+    void clearRect(const Rect& rect) override;
+    void drawLines(const std::vector<Point>& lines) override;
+    void drawRect(const Rect& rect, PaintMode mode) override;
+    void drawRoundedRect(const Rect& rect, const PicaPt& radius, PaintMode mode) override;
+    void drawEllipse(const Rect& rect, PaintMode mode) override;
+    void drawPath(std::shared_ptr<BezierPath> path, PaintMode mode) override;
+    void drawLinearGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                const Point& start, const Point& end) override;
+    void drawRadialGradientPath(std::shared_ptr<BezierPath> path, Gradient& gradient,
+                                const Point& center, const PicaPt& startRadius,
+                                const PicaPt& endRadius) override;
+    void drawText(const char *textUTF8, const Point& topLeft, const Font& font, PaintMode mode) override;
+    void drawText(const TextLayout& layout, const Point& topLeft) override;
+    void drawImage(std::shared_ptr<DrawableImage> image, const Rect& destRect) override;
+    void clipToRect(const Rect& rect) override;
+    void clipToPath(std::shared_ptr<BezierPath> path) override;
+    Color pixelAt(int x, int y) override;
+    std::shared_ptr<DrawableImage> copyToImage() override;
+    Font::Metrics fontMetrics(const Font& font) const override;
+    TextMetrics textMetrics(const char *textUTF8, const Font& font,
+                            PaintMode mode = kPaintFill) const override;
+    void calcContextPixel(const Point& point, float *x, float *y) override;
+
+private:
+    DrawContext& mRealDC;
+    DisplayList *mList;
+    // Layouts created while recording, so that the list can keep the ones
+    // that get drawn.
+    mutable std::vector<std::shared_ptr<TextLayout>> mCreatedLayouts;
+    // Likewise the stops of gradients requested while recording.
+    std::vector<DisplayList::GradientRef> mCreatedGradients;
+
+    std::shared_ptr<TextLayout> created(std::shared_ptr<TextLayout> layout) const;
+    uint32_t addGradient(Gradient& gradient);
+};
+
+}  // namespace uitk
+#endif // UITK_DISPLAY_LIST_H
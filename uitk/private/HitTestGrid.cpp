@@ -0,0 +1,169 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "HitTestGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uitk {
+
+namespace {
+static const int kMaxCellsPerSide = 256;
+static const int kMaxCellsPerRect = 16;  // larger rects go in mLarge
+}  // namespace
+
+void HitTestGrid::reset(const std::vector<Rect>& rects)
+{
+    clear();
+    mRects = rects;
+
+    int nValid = 0;
+    PicaPt minX, minY, maxX, maxY;
+    for (auto &r : mRects) {
+        if (r.width <= PicaPt::kZero || r.height <= PicaPt::kZero) {
+            continue;  // cannot contain anything
+        }
+        if (nValid == 0) {
+            minX = r.x;  minY = r.y;  maxX = r.maxX();  maxY = r.maxY();
+        } else {
+            minX = std::min(minX, r.x);
+            minY = std::min(minY, r.y);
+            maxX = std::max(maxX, r.maxX());
+            maxY = std::max(maxY, r.maxY());
+        }
+        nValid += 1;
+    }
+    if (nValid == 0) {
+        return;
+    }
+
+    mBounds = Rect(minX, minY, maxX - minX, maxY - minY);
+    int side = int(std::ceil(std::sqrt(double(nValid))));
+    side = std::max(1, std::min(kMaxCellsPerSide, side));
+    mNCols = side;
+    mNRows = side;
+    mCellWidth = std::max(PicaPt(1e-3f), mBounds.width / float(mNCols));
+    mCellHeight = std::max(PicaPt(1e-3f), mBounds.height / float(mNRows));
+
+    // Count the items in each cell, then fill them in. Iterating over the
+    // rects in order keeps each cell's indices in increasing order.
+    std::vector<int> counts(size_t(mNCols * mNRows), 0);
+    auto forEachCell = [this](const Rect& r, auto f) {
+        int c0, c1, r0, r1;
+        cellRange(r.x, r.width, mBounds.x, mCellWidth, mNCols, &c0, &c1);
+        cellRange(r.y, r.height, mBounds.y, mCellHeight, mNRows, &r0, &r1);
+        if ((c1 - c0 + 1) * (r1 - r0 + 1) > kMaxCellsPerRect) {
+            return false;
+        }
+        for (int row = r0;  row <= r1;  ++row) {
+            for (int col = c0;  col <= c1;  ++col) {
+                f(row * mNCols + col);
+            }
+        }
+        return true;
+    };
+
+    for (int i = 0;  i < int(mRects.size());  ++i) {
+        auto &r = mRects[i];
+        if (r.width <= PicaPt::kZero || r.height <= PicaPt::kZero) {
+            continue;
+        }
+        if (!forEachCell(r, [&counts](int cell) { counts[cell] += 1; })) {
+            mLarge.push_back(i);
+        }
+    }
+
+    mCellStarts.resize(counts.size() + 1);
+    mCellStarts[0] = 0;
+    for (size_t cell = 0;  cell < counts.size();  ++cell) {
+        mCellStarts[cell + 1] = mCellStarts[cell] + counts[cell];
+        counts[cell] = mCellStarts[cell];  // now the next slot to fill
+    }
+    mCellItems.resize(size_t(mCellStarts.back()));
+
+    size_t nextLarge = 0;
+    for (int i = 0;  i < int(mRects.size());  ++i) {
+        auto &r = mRects[i];
+        if (r.width <= PicaPt::kZero || r.height <= PicaPt::kZero) {
+            continue;
+        }
+        if (nextLarge < mLarge.size() && mLarge[nextLarge] == i) {
+            ++nextLarge;
+            continue;
+        }
+        forEachCell(r, [this, &counts, i](int cell) { mCellItems[counts[cell]++] = i; });
+    }
+}
+
+void HitTestGrid::clear()
+{
+    mRects.clear();
+    mBounds = Rect();
+    mNCols = 0;
+    mNRows = 0;
+    mCellStarts.clear();
+    mCellItems.clear();
+    mLarge.clear();
+}
+
+void HitTestGrid::indicesAt(const Point& p, std::vector<int> *indices) const
+{
+    indices->clear();
+    if (mNCols == 0 || !mBounds.contains(p)) {
+        return;
+    }
+
+    int col, row, unused;
+    cellRange(p.x, PicaPt::kZero, mBounds.x, mCellWidth, mNCols, &col, &unused);
+    cellRange(p.y, PicaPt::kZero, mBounds.y, mCellHeight, mNRows, &row, &unused);
+    int cell = row * mNCols + col;
+
+    // Merge the cell's items with the large items, both of which are sorted.
+    auto it = mCellItems.begin() + mCellStarts[cell];
+    auto end = mCellItems.begin() + mCellStarts[cell + 1];
+    auto largeIt = mLarge.begin();
+    while (it != end || largeIt != mLarge.end()) {
+        int idx;
+        if (largeIt == mLarge.end() || (it != end && *it < *largeIt)) {
+            idx = *it++;
+        } else {
+            idx = *largeIt++;
+        }
+        if (mRects[idx].contains(p)) {
+            indices->push_back(idx);
+        }
+    }
+}
+
+void HitTestGrid::cellRange(const PicaPt& start, const PicaPt& length, const PicaPt& gridStart,
+                            const PicaPt& cellSize, int nCells, int *first, int *last) const
+{
+    auto toCell = [&](const PicaPt& v) {
+        int cell = int(std::floor((v - gridStart) / cellSize));
+        return std::max(0, std::min(nCells - 1, cell));
+    };
+    *first = toCell(start);
+    *last = toCell(start + length);
+}
+
+}  // namespace uitk
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_HIT_TEST_GRID_H
+#define UITK_HIT_TEST_GRID_H
+
+#define ND_NAMESPACE uitk
+#include <nativedraw.h>
+
+#include <vector>
+
+namespace uitk {
+
+// A uniform grid over a set of rectangles (the frames of a widget's
+// children), so that finding the rectangles containing a point only needs to
+// look at the ones overlapping the point's cell instead of all of them. The
+// grid has about one cell per rectangle, so for rectangles that are spread
+// out a lookup is O(1) on average. Rectangles that would cover too many
+// cells are kept in a separate list that every lookup checks.
+class HitTestGrid
+{
+public:
+    // Rebuilds the grid, in O(n) for rectangles no larger than a cell or so.
+    void reset(const std::vector<Rect>& rects);
+    void clear();
+
+    // Sets *indices to the indices of the rectangles that contain p, in
+    // increasing order.
+    void indicesAt(const Point& p, std::vector<int> *indices) const;
+
+private:
+    std::vector<Rect> mRects;
+    Rect mBounds;
+    int mNCols = 0;
+    int mNRows = 0;
+    PicaPt mCellWidth;
+    PicaPt mCellHeight;
+    // The indices in cell i are mCellItems[mCellStarts[i] .. mCellStarts[i + 1]),
+    // in increasing order.
+    std::vector<int> mCellStarts;
+    std::vector<int> mCellItems;
+    std::vector<int> mLarge;  // in increasing order
+
+    // Returns the range of cells overlapping [start, start + length]
+    void cellRange(const PicaPt& start, const PicaPt& length, const PicaPt& gridStart,
+                   const PicaPt& cellSize, int nCells, int *first, int *last) const;
+};
+
+}  // namespace uitk
+#endif // UITK_HIT_TEST_GRID_H
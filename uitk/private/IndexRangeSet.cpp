@@ -0,0 +1,199 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include "IndexRangeSet.h"
+
+#include <algorithm>
+
+namespace uitk {
+
+bool IndexRangeSet::contains(int i) const
+{
+    auto it = mRanges.upper_bound(i);
+    if (it == mRanges.begin()) {
+        return false;
+    }
+    --it;
+    return (i < it->second);
+}
+
+int IndexRangeSet::first() const
+{
+    return (mRanges.empty() ? -1 : mRanges.begin()->first);
+}
+
+void IndexRangeSet::clear()
+{
+    mRanges.clear();
+    mCount = 0;
+}
+
+void IndexRangeSet::insert(int first, int end)
+{
+    if (first >= end) {
+        return;
+    }
+
+    // Merge with a range that overlaps or abuts the start.
+    auto it = mRanges.upper_bound(first);
+    if (it != mRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= first) {
+            if (prev->second >= end) {
+                return;  // already contained
+            }
+            first = prev->first;
+            it = prev;
+        }
+    }
+    // Absorb every range that starts inside or abuts [first, end).
+    while (it != mRanges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        mCount -= it->second - it->first;
+        it = mRanges.erase(it);
+    }
+    mRanges[first] = end;
+    mCount += end - first;
+}
+
+void IndexRangeSet::erase(int first, int end)
+{
+    if (first >= end || mRanges.empty()) {
+        return;
+    }
+
+    auto it = mRanges.upper_bound(first);
+    if (it != mRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second > first) {
+            // prev straddles first: keep its head, and its tail if it
+            // extends past end.
+            int prevEnd = prev->second;
+            prev->second = first;
+            mCount -= prevEnd - first;
+            if (prev->first == prev->second) {
+                mRanges.erase(prev);
+            }
+            if (prevEnd > end) {
+                mRanges[end] = prevEnd;
+                mCount += prevEnd - end;
+                return;
+            }
+        }
+    }
+    while (it != mRanges.end() && it->first < end) {
+        int rEnd = it->second;
+        mCount -= rEnd - it->first;
+        it = mRanges.erase(it);
+        if (rEnd > end) {
+            mRanges[end] = rEnd;
+            mCount += rEnd - end;
+            break;
+        }
+    }
+}
+
+void IndexRangeSet::invert(int first, int end)
+{
+    if (first >= end) {
+        return;
+    }
+    auto existing = ranges(first, end);
+    insert(first, end);
+    for (auto &r : existing) {
+        erase(r.first, r.end);
+    }
+}
+
+void IndexRangeSet::insertGap(int index, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    // Split a range that straddles index; the gap will separate the halves.
+    auto it = mRanges.upper_bound(index);
+    if (it != mRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first < index && prev->second > index) {
+            mRanges[index] = prev->second;
+            prev->second = index;
+        }
+    }
+
+    auto start = mRanges.lower_bound(index);
+    std::vector<std::pair<int, int>> moved(start, mRanges.end());
+    mRanges.erase(start, mRanges.end());
+    for (auto &r : moved) {
+        mRanges[r.first + count] = r.second + count;
+    }
+}
+
+void IndexRangeSet::removeGap(int first, int end)
+{
+    if (first >= end) {
+        return;
+    }
+
+    erase(first, end);
+    auto start = mRanges.lower_bound(end);
+    std::vector<std::pair<int, int>> moved(start, mRanges.end());
+    mRanges.erase(start, mRanges.end());
+    int n = end - first;
+    for (auto &r : moved) {
+        mCount -= r.second - r.first;
+    }
+    // insert() merges the first moved range with one ending at first.
+    for (auto &r : moved) {
+        insert(r.first - n, r.second - n);
+    }
+}
+
+std::vector<IndexRangeSet::Range> IndexRangeSet::ranges() const
+{
+    std::vector<Range> out;
+    out.reserve(mRanges.size());
+    for (auto &r : mRanges) {
+        out.push_back({ r.first, r.second });
+    }
+    return out;
+}
+
+std::vector<IndexRangeSet::Range> IndexRangeSet::ranges(int first, int end) const
+{
+    std::vector<Range> out;
+    auto it = mRanges.upper_bound(first);
+    if (it != mRanges.begin()) {
+        --it;
+    }
+    for (;  it != mRanges.end() && it->first < end;  ++it) {
+        int f = std::max(first, it->first);
+        int e = std::min(end, it->second);
+        if (f < e) {
+            out.push_back({ f, e });
+        }
+    }
+    return out;
+}
+
+}  // namespace uitk
@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#ifndef UITK_INDEX_RANGE_SET_H
+#define UITK_INDEX_RANGE_SET_H
+
+#include <map>
+#include <vector>
+
+namespace uitk {
+
+// A set of integers stored as sorted, non-overlapping, non-adjacent ranges,
+// so that large contiguous selections (e.g. select all) are cheap. Membership
+// is O(log ranges), and adding or removing a range is O(log ranges) plus the
+// number of ranges it merges or splits.
+class IndexRangeSet
+{
+public:
+    // A half-open range [first, end)
+    struct Range
+    {
+        int first;
+        int end;
+    };
+
+    bool empty() const { return mRanges.empty(); }
+    // Returns the number of integers in the set
+    int count() const { return mCount; }
+    bool contains(int i) const;
+    // Returns the smallest integer in the set, or -1 if empty
+    int first() const;
+
+    void clear();
+    void insert(int i) { insert(i, i + 1); }
+    void insert(int first, int end);
+    void erase(int i) { erase(i, i + 1); }
+    void erase(int first, int end);
+    // Removes the members of [first, end) and adds the non-members.
+    void invert(int first, int end);
+
+    // Shifts the members >= index up by count, as if count items had been
+    // inserted at index. O(ranges after index).
+    void insertGap(int index, int count);
+    // Removes [first, end) and shifts the members >= end down to close the
+    // gap, as if those items had been deleted. O(ranges after first).
+    void removeGap(int first, int end);
+
+    std::vector<Range> ranges() const;
+    // Returns the ranges clipped to [first, end)
+    std::vector<Range> ranges(int first, int end) const;
+
+private:
+    std::map<int, int> mRanges;  // first -> end
+    int mCount = 0;
+};
+
+}  // namespace uitk
+#endif // UITK_INDEX_RANGE_SET_H
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_MPSC_QUEUE_H
+#define UITK_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace uitk {
+
+// A lock-free multiple-producer, single-consumer queue. Producers push onto
+// a linked list with compare-and-swap; the consumer takes the whole list at
+// once with takeAll(). Since the consumer never removes individual nodes
+// there is no ABA problem, and a batch of pushes costs the consumer one
+// atomic exchange.
+template <typename T>
+class MPSCQueue
+{
+public:
+    MPSCQueue() {}
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    ~MPSCQueue()
+    {
+        takeAll([](T&&) {});
+    }
+
+    // Thread-safe
+    void push(T value)
+    {
+        auto *node = new Node{ std::move(value), mHead.load(std::memory_order_relaxed) };
+        while (!mHead.compare_exchange_weak(node->next, node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+            ;  // node->next was updated to the current head, try again
+        }
+    }
+
+    // Thread-safe, but may be stale by the time it returns.
+    bool empty() const { return (mHead.load(std::memory_order_relaxed) == nullptr); }
+
+    // Consumer only. Removes everything that has been pushed and calls
+    // f(T&&) on each item, in the order they were pushed. Items pushed while
+    // this is running (including by f) are left for the next call.
+    template <typename F>
+    void takeAll(F f)
+    {
+        Node *node = mHead.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is newest-first; reverse it.
+        Node *oldestFirst = nullptr;
+        while (node) {
+            Node *next = node->next;
+            node->next = oldestFirst;
+            oldestFirst = node;
+            node = next;
+        }
+        while (oldestFirst) {
+            Node *next = oldestFirst->next;
+            f(std::move(oldestFirst->value));
+            delete oldestFirst;
+            oldestFirst = next;
+        }
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+
+    std::atomic<Node*> mHead{ nullptr };
+};
+
+}  // namespace uitk
+#endif // UITK_MPSC_QUEUE_H
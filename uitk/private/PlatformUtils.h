@@ -20,30 +20,79 @@
 // IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
+#include "../Instrumentation.h"
 #include "../OSApplication.h"
 
+#include <algorithm>
 #include <chrono>
-#include <list>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace uitk {
 
+// Converts the timestamps of native events, which are on the platform's own
+// monotonic clock, to Instrumentation::now()'s clock. The clocks have
+// different origins, so the offset is estimated as the smallest difference
+// seen between when an event is received and its timestamp, since an event
+// cannot be received before it happens. If the native clock goes backwards
+// (X11 and Win32 timestamps wrap after 49.7 days), the estimate starts over.
+class EventClock
+{
+public:
+    double toNow(double nativeSecs)
+    {
+        auto offset = Instrumentation::now() - nativeSecs;
+        if (!mHasOffset || nativeSecs < mLastNativeSecs || offset < mOffset) {
+            mOffset = offset;
+            mHasOffset = true;
+        }
+        mLastNativeSecs = nativeSecs;
+        return nativeSecs + mOffset;
+    }
+
+private:
+    double mOffset = 0.0;
+    double mLastNativeSecs = 0.0;
+    bool mHasOffset = false;
+};
+
 template <typename W>  // W must be (efficiently) copyable
-class DeferredFunctions // has it's own lock
+class DeferredFunctions // has it's own lock; all functions are thread-safe
 {
+    // The functions are in a binary min-heap ordered by the time they next
+    // run, so adding is O(log n) and finding the next one is O(1). Removing
+    // is O(1): the function is removed from mFunctions and the heap entry is
+    // discarded when it reaches the top. Ids are never reused, and each heap
+    // entry records the generation of the function it was pushed for, so a
+    // stale entry (removed, or a repeating function that has already been
+    // rescheduled) can never run the wrong function.
 public:
+    using Clock = std::function<std::chrono::time_point<std::chrono::steady_clock>()>;
+
+    // Replaces the clock used to decide when functions are due, which is
+    // std::chrono::steady_clock::now() by default. (The headless backend
+    // uses this for its virtual clock.) Must be called before add().
+    void setClock(Clock clock)
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        mClock = clock;
+    }
+
     OSApplication::SchedulingId add(W win, float delaySecs, bool repeats,
                                     std::function<void(OSApplication::SchedulingId)> f)
     {
         std::lock_guard<std::mutex> locker(mLock);
 
         auto id = ++mNextId;
-        auto now = std::chrono::steady_clock::now();
-        mFunctions.push_back(std::make_shared<Func>(id, f, win, delaySecs,
-                                                    repeats, now, now));
-        updateNextTime(mFunctions.back().get());
-        reSort_locked();
+        auto now = mClock();
+        auto func = std::make_shared<Func>(id, f, win, delaySecs, repeats, now, now);
+        updateNextTime(func.get());
+        mFunctions[id] = func;
+        push_locked(*func);
 
         return id;
     }
@@ -52,69 +101,88 @@ public:
     {
         std::lock_guard<std::mutex> locker(mLock);
 
-        for (auto it = mFunctions.begin();  it != mFunctions.end();  ++it) {
-            if ((*it)->id == id) {
-                it = mFunctions.erase(it);  // mFunctions is still sorted afterwards
-                break;
-            }
-        }
+        mFunctions.erase(id);
+        compactIfNeeded_locked();
     }
 
     void removeForWindow(W win)
     {
         std::lock_guard<std::mutex> locker(mLock);
 
-        for (auto it = mFunctions.begin();  it != mFunctions.end();  ++it) {
-            if ((*it)->win == win) {
-                it = mFunctions.erase(it);  // mFunctions is still sorted afterwards
+        for (auto it = mFunctions.begin();  it != mFunctions.end();  ) {
+            if (it->second->win == win) {
+                it = mFunctions.erase(it);
+            } else {
+                ++it;
             }
         }
+        compactIfNeeded_locked();
     }
 
-    void executeTick()
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        return mFunctions.size();
+    }
+
+    // Returns false if nothing is scheduled, otherwise sets *t to the time
+    // that the next function needs to run.
+    bool nextTime(std::chrono::time_point<std::chrono::steady_clock> *t)
     {
-        if (mFunctions.empty()) {
-            return;
+        std::lock_guard<std::mutex> locker(mLock);
+
+        discardStaleTop_locked();
+        if (mHeap.empty()) {
+            return false;
         }
+        *t = mHeap.front().time;
+        return true;
+    }
 
-        auto now = std::chrono::steady_clock::now();
-        int nCallbacksRun = 0;
+    void executeTick()
+    {
+        auto now = currentTime();
 
-        // A callback may close the window that other callbacks are using,
-        // or it may remove itself or other callbacks. In both cases we should
-        // not execute any of those other callbacks. There seem to be two
-        // options for this:
-        // a) the (current) simple algorithm that starts over from the beginning
-        //    after running a callback. It is potentially O(n^2), although
-        //    large N is unlikely.
-        // b) store all the callbacks that need to be executed in an instance
-        //    variable, and removing a callback should also remove it from the
-        //    mToExecute queue.
-
-        while (true) {
-            std::shared_ptr<Func> f;
-            for (auto it = mFunctions.begin();  it != mFunctions.end();  ++it) {
-                if (now >= (*it)->nextTime) {
-                    f = (*it);
-                    if ((*it)->repeats) {
-                        updateNextTime(it->get());
-                    } else {
-                        it = mFunctions.erase(it);
-                    }
+        // Take everything that is due now. Functions that a callback
+        // reschedules for a time <= now wait for the next tick, so a
+        // callback cannot keep us here forever.
+        std::vector<Entry> due;
+        {
+            std::lock_guard<std::mutex> locker(mLock);
+            while (true) {
+                discardStaleTop_locked();
+                if (mHeap.empty() || mHeap.front().time > now) {
                     break;
                 }
-            }
-            if (f) {
-                f->f(f->id);
-                nCallbacksRun += 1;
-            } else {
-                break;  // didn't execute anything; break: nothing else is ready
+                std::pop_heap(mHeap.begin(), mHeap.end(), Later());
+                due.push_back(mHeap.back());
+                mHeap.pop_back();
             }
         }
 
-        if (nCallbacksRun > 0) {
-            std::lock_guard<std::mutex> locker(mLock);
-            reSort_locked();
+        // A callback may close the window that other callbacks are using,
+        // or it may remove itself or other callbacks, so check each one is
+        // still scheduled immediately before running it. Note that we do not
+        // hold the lock while calling, so that the callback can add and
+        // remove functions.
+        for (auto &entry : due) {
+            std::shared_ptr<Func> f;
+            {
+                std::lock_guard<std::mutex> locker(mLock);
+                auto it = mFunctions.find(entry.id);
+                if (it == mFunctions.end() || it->second->generation != entry.generation) {
+                    continue;
+                }
+                f = it->second;
+                if (f->repeats) {
+                    updateNextTime(f.get());
+                    f->generation += 1;
+                    push_locked(*f);
+                } else {
+                    mFunctions.erase(it);
+                }
+            }
+            f->f(f->id);
         }
     }
 
@@ -126,6 +194,7 @@ private:
         W win;
         float delaySec;
         bool repeats;
+        uint32_t generation = 0;
         std::chrono::time_point<std::chrono::steady_clock> startTime;
         std::chrono::time_point<std::chrono::steady_clock> nextTime;
 
@@ -139,18 +208,69 @@ private:
         {}
     };
 
+    struct Entry
+    {
+        std::chrono::time_point<std::chrono::steady_clock> time;
+        OSApplication::SchedulingId id;
+        uint32_t generation;
+    };
+
+    struct Later  // std::*_heap() make max-heaps, so reverse the order
+    {
+        bool operator()(const Entry& x, const Entry& y) const
+        {
+            if (x.time != y.time) {
+                return (x.time > y.time);
+            }
+            return (x.id > y.id);  // same time: run in the order added
+        }
+    };
+
     OSApplication::SchedulingId mNextId = OSApplication::kInvalidSchedulingId;
-    std::mutex mLock;
-    // Should always be sorted. Uses shared_ptr<> so that an executing callback
-    // can safely unschedule itself.
-    std::list<std::shared_ptr<Func>> mFunctions;
+    Clock mClock = []() { return std::chrono::steady_clock::now(); };
+    mutable std::mutex mLock;
+    // Uses shared_ptr<> so that an executing callback can safely unschedule
+    // itself.
+    std::unordered_map<OSApplication::SchedulingId, std::shared_ptr<Func>> mFunctions;
+    std::vector<Entry> mHeap;  // may contain stale entries; see above
 
-    void reSort_locked()
+    std::chrono::time_point<std::chrono::steady_clock> currentTime()
     {
-        mFunctions.sort([](const std::shared_ptr<Func>& x,
-                           const std::shared_ptr<Func>& y) -> bool {
-            return (x->nextTime < y->nextTime);
-        });
+        std::lock_guard<std::mutex> locker(mLock);
+        return mClock();
+    }
+
+    void push_locked(const Func& func)
+    {
+        mHeap.push_back({ func.nextTime, func.id, func.generation });
+        std::push_heap(mHeap.begin(), mHeap.end(), Later());
+    }
+
+    bool isStale_locked(const Entry& entry) const
+    {
+        auto it = mFunctions.find(entry.id);
+        return (it == mFunctions.end() || it->second->generation != entry.generation);
+    }
+
+    void discardStaleTop_locked()
+    {
+        while (!mHeap.empty() && isStale_locked(mHeap.front())) {
+            std::pop_heap(mHeap.begin(), mHeap.end(), Later());
+            mHeap.pop_back();
+        }
+    }
+
+    // Each function has exactly one current entry in the heap, so anything
+    // beyond that is stale. Rebuilding when the heap is mostly stale keeps
+    // the memory bounded, and the O(n) cost is amortized over the removals.
+    void compactIfNeeded_locked()
+    {
+        if (mHeap.size() > 64 && mHeap.size() > 2 * mFunctions.size()) {
+            mHeap.erase(std::remove_if(mHeap.begin(), mHeap.end(),
+                                       [this](const Entry& e) { return isStale_locked(e); }),
+                        mHeap.end());
+            std::make_heap(mHeap.begin(), mHeap.end(), Later());
+        }
     }
 
     void updateNextTime(Func *func)
@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "RowHeightIndex.h"
+
+namespace uitk {
+
+void RowHeightIndex::reset(int nRows, std::function<PicaPt(int)> rowHeight)
+{
+    if (nRows < 0) {
+        nRows = 0;
+    }
+    mHeights.resize(size_t(nRows));
+    mTree.assign(size_t(nRows) + 1, PicaPt::kZero);
+    for (int i = 0;  i < nRows;  ++i) {
+        mHeights[i] = rowHeight(i);
+    }
+
+    // Linear-time construction: each node pushes its sum to its parent.
+    for (int i = 1;  i <= nRows;  ++i) {
+        mTree[i] += mHeights[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= nRows) {
+            mTree[parent] += mTree[i];
+        }
+    }
+
+    mHighBit = 1;
+    while (mHighBit * 2 <= nRows) {
+        mHighBit *= 2;
+    }
+}
+
+void RowHeightIndex::clear()
+{
+    mHeights.clear();
+    mTree.clear();
+    mHighBit = 0;
+}
+
+void RowHeightIndex::setHeight(int row, const PicaPt& height)
+{
+    auto delta = height - mHeights[row];
+    mHeights[row] = height;
+    int n = size();
+    for (int i = row + 1;  i <= n;  i += (i & -i)) {
+        mTree[i] += delta;
+    }
+}
+
+PicaPt RowHeightIndex::offset(int row) const
+{
+    PicaPt sum = PicaPt::kZero;
+    for (int i = row;  i > 0;  i -= (i & -i)) {
+        sum += mTree[i];
+    }
+    return sum;
+}
+
+int RowHeightIndex::rowAt(const PicaPt& y) const
+{
+    if (y < PicaPt::kZero) {
+        return -1;
+    }
+
+    // Descend the tree to find the largest count of rows whose heights sum
+    // to <= y; that count is the index of the row containing y.
+    int n = size();
+    int pos = 0;
+    PicaPt remaining = y;
+    for (int step = mHighBit;  step > 0;  step /= 2) {
+        int next = pos + step;
+        if (next <= n && mTree[next] <= remaining) {
+            pos = next;
+            remaining -= mTree[next];
+        }
+    }
+    return pos;
+}
+
+}  // namespace uitk
@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_ROW_HEIGHT_INDEX_H
+#define UITK_ROW_HEIGHT_INDEX_H
+
+#define ND_NAMESPACE uitk
+#include <nativedraw.h>
+
+#include <functional>
+#include <vector>
+
+namespace uitk {
+
+// Keeps the y offsets of a column of rows with varying heights, so that the
+// offset of a row and the row at a given y are O(log n), and changing the
+// height of one row is O(log n) instead of recomputing all the offsets.
+// (This is a Fenwick tree, also called a binary indexed tree, of the heights.)
+class RowHeightIndex
+{
+public:
+    // Rebuilds the index, in O(n).
+    void reset(int nRows, std::function<PicaPt(int)> rowHeight);
+    void clear();
+
+    int size() const { return int(mHeights.size()); }
+
+    PicaPt height(int row) const { return mHeights[row]; }
+    void setHeight(int row, const PicaPt& height);
+
+    // Returns the sum of the heights of the rows before row. Passing size()
+    // returns the total height.
+    PicaPt offset(int row) const;
+    PicaPt totalHeight() const { return offset(size()); }
+
+    // Returns the row containing y, which is the last row whose offset is
+    // <= y. Returns -1 if y < 0 and size() if y >= totalHeight().
+    int rowAt(const PicaPt& y) const;
+
+private:
+    std::vector<PicaPt> mHeights;
+    std::vector<PicaPt> mTree;  // 1-based; mTree[i] is the sum of heights (i - lsb(i), i]
+    int mHighBit = 0;  // largest power of two <= size()
+};
+
+}  // namespace uitk
+#endif // UITK_ROW_HEIGHT_INDEX_H
@@ -0,0 +1,228 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace uitk {
+
+ThreadPool::ThreadPool()
+{
+    // Leave a core for the UI thread.
+    mMaxConcurrent = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        mQuit = true;
+        for (auto &q : mQueues) {
+            for (auto &task : q) {
+                task.cancelled->store(true);
+            }
+            q.clear();
+        }
+        for (auto *task : mRunning) {
+            task->cancelled->store(true);
+        }
+    }
+    mWakeWorker.notify_all();
+    for (auto &t : mThreads) {
+        t.join();
+    }
+}
+
+ThreadPool::TaskId ThreadPool::add(const void *owner, int priority,
+                                   std::shared_ptr<std::atomic<bool>> cancelled,
+                                   std::function<void()> task)
+{
+    priority = std::max(0, std::min(kNPriorities - 1, priority));
+    TaskId id;
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        id = ++mNextId;
+        mQueues[priority].push_back({ id, owner, cancelled, std::move(task) });
+        // A notified worker is still idle until it wakes up and takes a
+        // task, so several adds in a row can all notify the same worker;
+        // compare the queued tasks against the idle workers instead.
+        if (nQueued_locked() > mNIdle && int(mThreads.size()) < mMaxConcurrent) {
+            startWorker_locked();
+        }
+    }
+    mWakeWorker.notify_one();
+    return id;
+}
+
+void ThreadPool::cancel(TaskId id)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    for (auto &q : mQueues) {
+        for (auto it = q.begin();  it != q.end();  ++it) {
+            if (it->id == id) {
+                it->cancelled->store(true);
+                q.erase(it);
+                notifyIfIdle_locked();
+                return;
+            }
+        }
+    }
+    for (auto *task : mRunning) {
+        if (task->id == id) {
+            task->cancelled->store(true);
+            return;
+        }
+    }
+}
+
+void ThreadPool::cancelForOwner(const void *owner)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    for (auto &q : mQueues) {
+        auto newEnd = std::remove_if(q.begin(), q.end(), [owner](const Task& task) {
+            if (task.owner == owner) {
+                task.cancelled->store(true);
+                return true;
+            }
+            return false;
+        });
+        q.erase(newEnd, q.end());
+    }
+    notifyIfIdle_locked();
+    for (auto *task : mRunning) {
+        if (task->owner == owner) {
+            task->cancelled->store(true);
+        }
+    }
+}
+
+int ThreadPool::maxConcurrent() const
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    return mMaxConcurrent;
+}
+
+void ThreadPool::setMaxConcurrent(int n)
+{
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        mMaxConcurrent = std::max(1, n);
+        // Create threads for any work that can now run
+        int nWanted = std::min(mMaxConcurrent, int(mRunning.size()) + nQueued_locked());
+        while (int(mThreads.size()) < nWanted) {
+            startWorker_locked();
+        }
+    }
+    mWakeWorker.notify_all();
+}
+
+int ThreadPool::nQueued_locked() const
+{
+    int n = 0;
+    for (auto &q : mQueues) {
+        n += int(q.size());
+    }
+    return n;
+}
+
+void ThreadPool::startWorker_locked()
+{
+    // The new worker counts as idle from now, not from when the thread
+    // gets around to waiting, so that add() does not start another one
+    // for the same task.
+    mNIdle += 1;
+    mThreads.emplace_back([this]() { runWorker(); });
+}
+
+void ThreadPool::waitUntilIdle()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mBecameIdle.wait(locker, [this]() { return isIdle_locked(); });
+}
+
+bool ThreadPool::isIdle_locked() const
+{
+    return (mRunning.empty() && nQueued_locked() == 0);
+}
+
+void ThreadPool::notifyIfIdle_locked()
+{
+    if (isIdle_locked()) {
+        mBecameIdle.notify_all();
+    }
+}
+
+bool ThreadPool::hasWork_locked() const
+{
+    if (int(mRunning.size()) >= mMaxConcurrent) {
+        return false;
+    }
+    for (auto &q : mQueues) {
+        if (!q.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runWorker()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    while (true) {
+        // startWorker_locked() or the end of the previous task counted us as idle
+        mWakeWorker.wait(locker, [this]() { return mQuit || hasWork_locked(); });
+        mNIdle -= 1;
+        if (mQuit) {
+            return;
+        }
+
+        Task task;
+        for (int p = kNPriorities - 1;  p >= 0;  --p) {
+            if (!mQueues[p].empty()) {
+                task = std::move(mQueues[p].front());
+                mQueues[p].pop_front();
+                break;
+            }
+        }
+        if (task.cancelled->load()) {
+            mNIdle += 1;
+            notifyIfIdle_locked();
+            continue;
+        }
+
+        mRunning.push_back(&task);
+        locker.unlock();
+        task.f();
+        locker.lock();
+        mRunning.erase(std::find(mRunning.begin(), mRunning.end(), &task));
+        mNIdle += 1;
+        notifyIfIdle_locked();
+        // A slot opened up, which another worker may be waiting on if
+        // maxConcurrent was lowered.
+        if (hasWork_locked()) {
+            mWakeWorker.notify_one();
+        }
+    }
+}
+
+}  // namespace uitk
@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// Copyright 2021 Eight Brains Studios, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef UITK_THREAD_POOL_H
+#define UITK_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uitk {
+
+// Runs tasks on background threads, highest priority first and in the order
+// added within a priority. Threads are created as needed, up to
+// maxConcurrent(). Tasks are expected to be coarse (loading a file, decoding
+// an image), so one shared queue is used; that keeps the priority order
+// exact, which per-thread work-stealing queues would not.
+class ThreadPool
+{
+public:
+    using TaskId = unsigned long;
+    static constexpr int kNPriorities = 3;
+
+    ThreadPool();
+    // Cancels the queued tasks and waits for the running tasks to finish.
+    ~ThreadPool();
+
+    // The task is not run if cancelled is set before it starts. Tasks with
+    // the same owner can be cancelled together.
+    TaskId add(const void *owner, int priority,
+               std::shared_ptr<std::atomic<bool>> cancelled, std::function<void()> task);
+    // Sets the task's cancel flag and removes it if it has not started.
+    void cancel(TaskId id);
+    void cancelForOwner(const void *owner);
+
+    int maxConcurrent() const;
+    void setMaxConcurrent(int n);
+
+    // Blocks until no tasks are queued or running.
+    void waitUntilIdle();
+
+private:
+    struct Task
+    {
+        TaskId id;
+        const void *owner;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        std::function<void()> f;
+    };
+
+    mutable std::mutex mLock;
+    std::condition_variable mWakeWorker;
+    std::condition_variable mBecameIdle;
+    std::deque<Task> mQueues[kNPriorities];  // [0] is lowest priority
+    std::vector<Task*> mRunning;  // owned by the worker running it
+    std::vector<std::thread> mThreads;
+    int mMaxConcurrent;
+    int mNIdle = 0;  // includes workers that have been notified but not woken yet
+    TaskId mNextId = 0;
+    bool mQuit = false;
+
+    int nQueued_locked() const;
+    void startWorker_locked();
+    bool hasWork_locked() const;
+    bool isIdle_locked() const;
+    void notifyIfIdle_locked();
+    void runWorker();
+};
+
+}  // namespace uitk
+#endif // UITK_THREAD_POOL_H
@@ -26,8 +26,19 @@
 #include "../Application.h"
 #include "../UIContext.h"
 
+#include <atomic>
+
 namespace uitk {
 
+namespace {
+std::atomic<uint64_t> gNextThemeGeneration(1);
+}  // namespace
+
+Theme::Theme()
+    : mGeneration(gNextThemeGeneration++)
+{
+}
+
 Theme::WidgetStyle Theme::WidgetStyle::merge(const WidgetStyle& s) const
 {
     WidgetStyle newStyle;
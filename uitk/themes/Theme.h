@@ -27,6 +27,7 @@
 
 #include <nativedraw.h>
 
+#include <cstdint>
 #include <functional>
 
 namespace uitk {
@@ -217,9 +218,13 @@ public:
     };
 
 public:
-    Theme() {}
+    Theme();
     virtual ~Theme() {}
 
+    /// Identifies this theme object. Unlike the theme's address, this is
+    /// never reused by another theme, so caches can be keyed on it.
+    uint64_t generation() const { return mGeneration; }
+
     virtual const Params& params() const = 0;
     virtual void setParams(const Params& params) = 0;
 
@@ -374,6 +379,9 @@ public:
     virtual void drawMenubarItem(UIContext& ui, const Rect& frame, const std::string& text,
                                  WidgetState state) const = 0;
     virtual void drawTooltip(UIContext& ui, const Rect& frame) const = 0;
+
+private:
+    uint64_t mGeneration;
 };
 
 }  // namespace uitk
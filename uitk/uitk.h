@@ -43,6 +43,8 @@
 #include "Icon.h"
 #include "IconAndText.h"
 #include "ImageView.h"
+#include "InputTrace.h"
+#include "Instrumentation.h"
 #include "Label.h"
 #include "Layout.h"
 #include "ListView.h"
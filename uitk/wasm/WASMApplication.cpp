@@ -205,6 +205,13 @@ private:
     PicaPt mLastClickY;
 };
 
+static EventClock gEventClock;
+
+double toUITKTime(EmVal e)
+{
+    return gEventClock.toNow(e["timeStamp"].as<double>() / 1000.0);  // milliseconds
+}
+
 } // namespace
 
 int OnJSResize(int eventType, const EmscriptenUiEvent *e, void *userData);
@@ -855,7 +862,7 @@ public:
                 // .data is empty for backspace, enter, etc
                 if (e["data"].as<bool>() && !e["isComposing"].as<bool>()) {
                     auto utf8 = e["data"].as<std::string>();
-                    wi->window->onText(TextEvent{ utf8 });
+                    wi->window->onText(TextEvent{ utf8, toUITKTime(e) });
                     mTextEntry.set("value", EmVal(""));
                 }
                 break;
@@ -1057,6 +1064,7 @@ private:
             if (dragButtons & 0b10000) { b |= int(MouseButton::kButton5); }
             me.drag.buttons = b;
         }
+        me.time = toUITKTime(e);
         auto x = e["offsetX"].as<long>();  // from edge of textarea frame 
         auto y = e["offsetY"].as<long>();
 
@@ -1128,6 +1136,7 @@ private:
         } else {
             ke.key = Key::kUnknown;
         }
+        ke.time = toUITKTime(e);
 
         ((WASMScreen*)obj)->key(ke);
     }
@@ -1335,6 +1344,8 @@ bool WASMApplication::isWindowBorderInsideWindowFrame() const { return true; }
 
 bool WASMApplication::windowsMightUseSameDrawContext() const { return true; }
 
+bool WASMApplication::windowContentsPersistBetweenDraws() const { return false; }
+
 bool WASMApplication::shouldHideScrollbars() const { return false; }
 
 bool WASMApplication::canKeyFocusEverything() const { return true; }
@@ -129,7 +129,7 @@ struct Win32Application::Impl {
 
         {
             std::lock_guard<std::mutex> locker(this->postedFunctionsLock);
-            this->postedLaterFunctions[win32id] = { f, id, (HWND)w->nativeHandle(), repeat };
+            this->postedLaterFunctions[win32id] = { f, id, (w ? (HWND)w->nativeHandle() : NULL), repeat };
         }
 
         return id;
@@ -574,6 +574,8 @@ bool Win32Application::isWindowBorderInsideWindowFrame() const { return false; }
 
 bool Win32Application::windowsMightUseSameDrawContext() const { return false; }
 
+bool Win32Application::windowContentsPersistBetweenDraws() const { return false; }
+
 bool Win32Application::shouldHideScrollbars() const { return false; }
 
 bool Win32Application::canKeyFocusEverything() const { return true; }
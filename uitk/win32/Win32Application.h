@@ -61,6 +61,7 @@ public:
     bool isOriginInUpperLeft() const override;
     bool isWindowBorderInsideWindowFrame() const override;
     bool windowsMightUseSameDrawContext() const override;
+    bool windowContentsPersistBetweenDraws() const override;
     bool shouldHideScrollbars() const override;
     bool canKeyFocusEverything() const override;
     bool platformHasMenubar() const override;
@@ -27,6 +27,7 @@
 #include "../Events.h"
 #include "../OSCursor.h"
 #include "../TextEditorLogic.h"
+#include "../private/PlatformUtils.h"
 #include "Win32Application.h"
 #include "Win32Menubar.h"
 #include "Win32Utils.h"
@@ -484,9 +485,17 @@ OSScreen Win32Window::osScreen() const
 {
     auto hMonitor = MonitorFromWindow(mImpl->hwnd, MONITOR_DEFAULTTONULL);
     if (hMonitor) {
-        MONITORINFO monitor;
+        MONITORINFOEXW monitor;
         monitor.cbSize = sizeof(monitor);
-        GetMonitorInfo(hMonitor, &monitor);
+        GetMonitorInfoW(hMonitor, &monitor);
+        DEVMODEW mode;
+        ZeroMemory(&mode, sizeof(mode));
+        mode.dmSize = sizeof(mode);
+        float refreshRate = 0.0f;
+        // 0 and 1 mean "hardware default"
+        if (EnumDisplaySettingsW(monitor.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+            refreshRate = float(mode.dmDisplayFrequency);
+        }
         return {
             { float(monitor.rcWork.left),
               float(monitor.rcWork.top),
@@ -496,7 +505,8 @@ OSScreen Win32Window::osScreen() const
               float(monitor.rcMonitor.top),
               float(monitor.rcMonitor.right - monitor.rcMonitor.left),
               float(monitor.rcMonitor.bottom - monitor.rcMonitor.top) },
-            dpi()
+            dpi(),
+            refreshRate
         };
     } else {
         return { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f }, 96.0f };
@@ -770,6 +780,14 @@ int getButtons(WPARAM wParam)
     return buttons;
 }
 
+static EventClock gEventClock;
+
+// Returns the time of the message being handled
+double messageTime()
+{
+    return gEventClock.toNow(double(DWORD(GetMessageTime())) / 1000.0);  // milliseconds
+}
+
 MouseButton getXButton(WPARAM wParam)
 {
     if (GET_XBUTTON_WPARAM(wParam) & XBUTTON1) { return MouseButton::kButton4; }
@@ -802,6 +820,7 @@ MouseEvent makeMouseEvent(MouseEvent::Type type, MouseButton b, int nClicks, WPA
         e.scroll.dy = PicaPt(float(GET_WHEEL_DELTA_WPARAM(wParam)) / float(WHEEL_DELTA));
     }
     e.keymods = getKeymods(wParam);
+    e.time = messageTime();
     return e;
 }
 
@@ -813,6 +832,7 @@ KeyEvent makeKeyEvent(KeyEvent::Type type, bool isRepeat, WPARAM wParam)
     e.nativeKey = int(wParam);
     e.keymods = 0;
     e.key = Key::kUnknown;
+    e.time = messageTime();
     if (GetKeyState(VK_SHIFT) & 0x8000) { e.keymods |= KeyModifier::kShift; }
     if (GetKeyState(VK_CONTROL) & 0x8000) { e.keymods |= KeyModifier::kCtrl; }
 
@@ -1043,6 +1063,7 @@ LRESULT CALLBACK UITKWndProc(HWND hwnd, UINT message,
 
             TextEvent e;
             e.utf8 = utf8FromWin32Unicode(utf16bytes);
+            e.time = messageTime();
             w->onText(e);
             return 0;
         }
@@ -1080,6 +1101,7 @@ LRESULT CALLBACK UITKWndProc(HWND hwnd, UINT message,
                     }
                     utf8bytes[utf8index] = '\0';
                     e.utf8 = utf8bytes;
+                    e.time = messageTime();
                     w->onText(e);
 
                 }
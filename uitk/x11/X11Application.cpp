@@ -28,6 +28,7 @@
 #include "../Events.h"
 #include "../openal/OpenALSound.h"
 #include "../themes/EmpireTheme.h"
+#include "../private/MPSCQueue.h"
 #include "../private/PlatformUtils.h"
 
 // For print dialog
@@ -48,19 +49,21 @@
 #include <X11/Xatom.h>
 #include <X11/Xresource.h>
 #include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
 
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <dirent.h>
 #include <locale.h>
+#include <poll.h>
 #include <string.h>  // for memset()
 #include <unistd.h>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <iostream>
-#include <list>
 #include <map>
-#include <mutex>
-#include <thread>
 #include <unordered_map>
 
 // How do we get the binary name? argv[0] may actually be null or incorrect
@@ -81,6 +84,10 @@ static const char *kDB_XftDPI_alt = "Xft.Dpi";
 
 static const long kDoubleClickMaxMillisecs = 500;  // Windows' default
 static const uitk::PicaPt kDoubleClickMaxRadiusPicaPt(2);  // 2/72 inch
+
+// Leaves most of a 60 Hz frame for handling input and drawing when other
+// threads are posting functions faster than we can run them.
+static const auto kPostedFunctionsTimeBudget = std::chrono::milliseconds(8);
 }  // namespace
 
 static std::unordered_map<KeySym, Key> gKeysym2key = {
@@ -489,16 +496,101 @@ struct X11Application::Impl
     std::vector<std::map<std::string, std::string>> xrdbScreenStrings;
     std::unordered_map<::Window, X11Window*> xwin2window;
     ClickCounter clickCounter;
+    EventClock eventClock;  // X server timestamps are in milliseconds
+    std::vector<XMotionEvent> coalescedMotion;
+    std::vector<MouseEvent::PastMotion> motionHistory;
     std::unique_ptr<X11Clipboard> clipboard;
     std::unique_ptr<OpenALSound> sound;
 
-    Atom postedFuncAtom;
-    std::mutex postedFunctionsLock;
-    // This is a linked list because adding and removing does not invalidate
-    // iterators.
-    std::list<std::function<void()>> postedFunctions;
+    // Functions posted with scheduleLater() from any thread. A burst of
+    // posts only wakes the event loop once: whoever sets wakePending
+    // writes to wakeFd, and the loop clears it before taking the functions.
+    MPSCQueue<std::function<void()>> postedFunctions;
+    std::atomic<bool> wakePending{ false };
+    // Functions taken from postedFunctions that did not fit in the time
+    // budget. Only used by the event loop thread.
+    std::deque<std::function<void()>> readyFunctions;
 
     DeferredFunctions<::Window> postedLater;  // note: has its own lock
+
+    // Writing to this wakes up the event loop; this is safe from any thread.
+    int wakeFd = -1;
+
+    bool supportsShm = false;
+    int shmCompletionType = -1;
+
+    void wake()
+    {
+        uint64_t one = 1;
+        (void)write(this->wakeFd, &one, sizeof(one));
+    }
+
+    void post(std::function<void()>&& f)
+    {
+        this->postedFunctions.push(std::move(f));
+        if (!this->wakePending.exchange(true)) {
+            wake();
+        }
+    }
+
+    void runPostedFunctions()
+    {
+        // The posted function might generate another posted function
+        // (for example, an animation), so we only run the functions
+        // that we have right now; takeAll() does that for us.
+        this->wakePending.store(false);
+        this->postedFunctions.takeAll([this](std::function<void()>&& f) {
+            this->readyFunctions.push_back(std::move(f));
+        });
+
+        // A worker thread might post faster than we can run them, so stop
+        // after a while to handle input. Whatever is left runs first next time.
+        auto start = std::chrono::steady_clock::now();
+        while (!this->readyFunctions.empty()) {
+            auto f = std::move(this->readyFunctions.front());
+            this->readyFunctions.pop_front();
+            f();
+            if (!this->readyFunctions.empty() &&
+                std::chrono::steady_clock::now() - start > kPostedFunctionsTimeBudget) {
+                // Make sure that waitForEvents() does not sleep before we
+                // get back to these.
+                this->wakePending.store(true);
+                wake();
+                break;
+            }
+        }
+    }
+
+    // Sleeps until the X server sends something, a function is posted, or
+    // the next scheduled function is due. The caller must have checked that
+    // XPending() is zero, which also flushes our requests to the server.
+    void waitForEvents()
+    {
+        struct pollfd fds[2];
+        fds[0].fd = ConnectionNumber(this->display);
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = this->wakeFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        struct timespec timeout;
+        struct timespec *timeoutPtr = nullptr;  // wait forever
+        std::chrono::time_point<std::chrono::steady_clock> next;
+        if (this->postedLater.nextTime(&next)) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    next - std::chrono::steady_clock::now()).count();
+            ns = std::max(decltype(ns)(0), ns);
+            timeout.tv_sec = time_t(ns / 1000000000);
+            timeout.tv_nsec = long(ns % 1000000000);
+            timeoutPtr = &timeout;
+        }
+
+        if (ppoll(fds, 2, timeoutPtr, nullptr) > 0 && (fds[1].revents & POLLIN)) {
+            uint64_t count;
+            (void)read(this->wakeFd, &count, sizeof(count));  // reset the counter
+        }
+    }
 };
 
 X11Application::X11Application()
@@ -513,7 +605,16 @@ X11Application::X11Application()
     mImpl->clipboard = std::make_unique<X11Clipboard>(mImpl->display);
     mImpl->sound = std::make_unique<OpenALSound>();
 
-    mImpl->postedFuncAtom = XInternAtom(mImpl->display, "PostedFunction", False);
+    mImpl->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // Shared memory pixmaps let windows present without sending the pixels
+    // through the socket. Note that the extension is also reported for
+    // remote servers (e.g. over ssh), where it cannot work, so X11Window
+    // still needs to check that attaching the memory succeeds.
+    if (XShmQueryExtension(mImpl->display)) {
+        mImpl->supportsShm = true;
+        mImpl->shmCompletionType = XShmGetEventBase(mImpl->display) + ShmCompletion;
+    }
 
     // Read the resource databases from each screen.
     int nScreens = XScreenCount(mImpl->display);
@@ -566,6 +667,7 @@ X11Application::~X11Application()
 {
     XCloseIM(mImpl->xim);
     XCloseDisplay(mImpl->display);
+    close(mImpl->wakeFd);
 }
 
 void X11Application::setExitWhenLastWindowCloses(bool exits)
@@ -710,6 +812,10 @@ bool X11Application::isWindowBorderInsideWindowFrame() const { return true; }
 
 bool X11Application::windowsMightUseSameDrawContext() const { return false; }
 
+// X11Window draws into its own offscreen bitmap, which is only recreated when
+// the window is resized, so anything that was not redrawn is still valid.
+bool X11Application::windowContentsPersistBetweenDraws() const { return true; }
+
 bool X11Application::shouldHideScrollbars() const { return false; }
 
 bool X11Application::canKeyFocusEverything() const { return true; }
@@ -720,45 +826,18 @@ Clipboard& X11Application::clipboard() const { return *mImpl->clipboard; }
 
 void X11Application::scheduleLater(uitk::Window* w, std::function<void()> f)
 {
-    {
-    std::lock_guard<std::mutex> locker(mImpl->postedFunctionsLock);
-    mImpl->postedFunctions.push_back(f);
-    }
-
-    bool canSend = true;
-    ::Window to;
-    if (w) {
-        to = (::Window)w->nativeHandle();
-    } else {
-        // Any window will do, we just want an event so that the event loop
-        // handles the message soon. We know that we have at least one
-        // window, otherwise we would no longer be runing.
-        auto it = mImpl->xwin2window.begin();
-        if (it != mImpl->xwin2window.end()) {  // check, just in case...
-            to = it->first;
-        } else {
-            canSend = false;
-        }
-    }
-
-    if (canSend) {
-        XEvent xe;
-        xe.type = ClientMessage;
-        xe.xclient.type = ClientMessage;  // maybe X server sets this?
-        xe.xclient.window = to;
-        xe.xclient.message_type = mImpl->postedFuncAtom;
-        xe.xclient.format = 32;  // 8, 16, 32 (size of xclient.data), we do
-                                 // not use that, so this does not matter
-        XSendEvent(mImpl->display, xe.xclient.window, False, NoEventMask, &xe);
-    }
-    // Else: the function is still posted, we just have no way to send an event
+    // Unlike XSendEvent(), this is safe from other threads and does not
+    // need a window.
+    mImpl->post(std::move(f));
 }
 
 OSApplication::SchedulingId X11Application::scheduleLater(
                                Window* w, float delay, bool repeat,
                                std::function<void(SchedulingId)> f)
 {
-    return mImpl->postedLater.add((::Window)w->nativeHandle(), delay, repeat, f);
+    auto id = mImpl->postedLater.add((w ? (::Window)w->nativeHandle() : ::Window(0)), delay, repeat, f);
+    mImpl->wake();  // so that the event loop recalculates its timeout
+    return id;
 }
 
 void X11Application::cancelScheduled(SchedulingId id)
@@ -774,27 +853,38 @@ int X11Application::run()
     Atom kPrimary = XInternAtom(mImpl->display, "PRIMARY", False);
     Atom kClipboardTargets = XInternAtom(mImpl->display, "TARGETS", False);
 
+    // The application may start with no windows and open one from a posted
+    // function, so only exit once a window has been open and closed.
+    bool hadWindow = false;
+    auto lastWindowClosed = [this, &hadWindow]() {
+        hadWindow = hadWindow || !mImpl->xwin2window.empty();
+        return (hadWindow && mImpl->xwin2window.empty());
+    };
+
     bool done = false;
     XEvent event;
     while (!done) {
-        // There is a way to use select() to timeout on the file descriptors
-        // Xlib uses under the hood, but small timeouts caused large latencies.
-        // Anyway, this method is simpler and does not require arcane knowledge
-        // gathered from dusty tomes.
-        // (See https://www.linuxquestions.org/questions/programming-9/xnextevent-select-409355)
+        // Xlib reads events from the connection into its own queue, so the
+        // connection may not be readable even though there are events;
+        // only sleep when XPending() says the queue is empty. (XPending()
+        // also flushes our output, which must happen before sleeping.)
+        // The sleep ends when the server sends something, when a function is
+        // posted, or when the next scheduled function is due, so an idle
+        // application does not wake up at all.
+        mImpl->runPostedFunctions();
         while (!XPending(mImpl->display)) {
             mImpl->postedLater.executeTick();
+            mImpl->runPostedFunctions();
+            if (lastWindowClosed()) {
+                break;  // a function closed the last window
+            }
             if (!XPending(mImpl->display)) {
-                // std::this_thread::yield() produces fairly high CPU usage,
-                // since multicore CPUs generally can reschedule the thread
-                // immediately. Even 1 ms is enough to drop CPU usage down to
-                // almost the level if this loop is eliminated. (Using a magic
-                // number here because this is highly context dependent and
-                // it we put it anywhere else we'd have to explain this whole
-                // thing about the timers anyway.)
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                mImpl->waitForEvents();
             }
         }
+        if (lastWindowClosed()) {
+            break;
+        }
 
         XNextEvent(mImpl->display, &event);
 
@@ -823,16 +913,34 @@ int X11Application::run()
             }
         }
 
+        // Not a constant, so cannot be in the switch. The drawable of the
+        // completion is in the same place as xany.window, so w is correct.
+        if (event.type == mImpl->shmCompletionType) {
+            w->onShmCompletion();
+            continue;
+        }
+
         switch (event.type) {
             case Expose:  // GraphicsExpose only happens for XCopyArea/XCopyPlane
-                w->onDraw();
+                // Exposes from the server are parts of the window that need
+                // to be copied again from our backbuffer. Several may be
+                // sent at once; count is the number still to come, so
+                // accumulate them and draw on the last one. Our own redraw
+                // requests (see X11Window::postRedraw()) are sent with
+                // send_event and have no area.
+                if (!event.xexpose.send_event) {
+                    w->addExposedArea(event.xexpose.x, event.xexpose.y,
+                                      event.xexpose.width, event.xexpose.height);
+                }
+                if (event.xexpose.count == 0) {
+                    w->onDraw();
+                }
                 break;
             case ConfigureNotify:
                 // This gets called when a window is moved, resized, raised,
                 // lowered, or border width is changed. We only need to resize
-                // on resize (and move if moved to a different screen),
-                // but the others are rare enough.
-                w->onResize();
+                // on resize; X11Window::onResize() ignores the others.
+                w->onResize(event.xconfigure.width, event.xconfigure.height);
                 break;
             //case ResizeRequest:
             //    // Determine proper size here (e.g. enforce minimum size
@@ -843,6 +951,25 @@ int X11Application::run()
             //    w->onResize();
             //    break;
             case MotionNotify: {
+                // A fast drag sends many more motion events than we can draw
+                // frames, and each one goes through the whole widget tree.
+                // Coalesce the motion events already queued for this window
+                // into the last one, keeping the earlier ones as its history.
+                // Only consecutive events with the same buttons and modifiers
+                // are coalesced, so the order of events is unchanged.
+                mImpl->coalescedMotion.clear();
+                while (XEventsQueued(mImpl->display, QueuedAfterReading) > 0) {
+                    XEvent next;
+                    XPeekEvent(mImpl->display, &next);
+                    if (next.type != MotionNotify
+                        || next.xmotion.window != event.xmotion.window
+                        || next.xmotion.state != event.xmotion.state) {
+                        break;
+                    }
+                    mImpl->coalescedMotion.push_back(event.xmotion);
+                    XNextEvent(mImpl->display, &event);
+                }
+
                 int buttons = 0;
                 if (event.xmotion.state & Button1MotionMask) {
                     buttons |= int(MouseButton::kLeft);
@@ -867,6 +994,18 @@ int X11Application::run()
                     me.drag.buttons = buttons;
                 }
                 me.keymods = toKeymods(event.xmotion.state);
+                me.time = mImpl->eventClock.toNow(double(event.xmotion.time) / 1000.0);
+                if (!mImpl->coalescedMotion.empty()) {
+                    auto dpi = w->dpi();
+                    mImpl->motionHistory.clear();
+                    for (auto &past : mImpl->coalescedMotion) {
+                        mImpl->motionHistory.push_back({
+                            Point(PicaPt::fromPixels(float(past.x - event.xmotion.x), dpi),
+                                  PicaPt::fromPixels(float(past.y - event.xmotion.y), dpi)),
+                            me.time - double(event.xmotion.time - past.time) / 1000.0 });
+                    }
+                    me.history = &mImpl->motionHistory;
+                }
                 w->onMouse(me, event.xmotion.x, event.xmotion.y);
                 break;
             }
@@ -882,6 +1021,7 @@ int X11Application::run()
                     me.button.nClicks = 0;
                 }
                 me.keymods = toKeymods(event.xmotion.state);
+                me.time = mImpl->eventClock.toNow(double(event.xbutton.time) / 1000.0);
                 switch (event.xbutton.button) {
                     default:
                     case Button1:
@@ -963,6 +1103,7 @@ int X11Application::run()
                 ke.nativeKey = ksym;
                 ke.keymods = toKeymods(event.xkey.state);
                 ke.isRepeat = false;  // TODO: figure this out
+                ke.time = mImpl->eventClock.toNow(double(event.xkey.time) / 1000.0);
                 if (!isIMEConversion) {
                     w->onKey(ke);
                 }
@@ -982,6 +1123,7 @@ int X11Application::run()
 
                     TextEvent te;
                     te.utf8 = utf8;
+                    te.time = ke.time;
                     w->onText(te);
                 }
 
@@ -1076,39 +1218,17 @@ int X11Application::run()
                     if (event.xclient.data.l[0] == kWMDeleteMsg) {
                         w->close();
                     }
-                } else if (event.xclient.message_type == mImpl->postedFuncAtom) {
-                    // The posted function might generate another posted function
-                    // (for example, an animation), so we only run the functions
-                    // that we have right now. Also, we need to not be holding
-                    // the lock when we run the function, otherwise posting a
-                    // function will deadlock.
-                    size_t n = 0;
-                    mImpl->postedFunctionsLock.lock();
-                    n = mImpl->postedFunctions.size();
-                    mImpl->postedFunctionsLock.unlock();
-
-                    for (size_t i = 0; i < n; ++i) {
-                        std::function<void()> f;
-                        mImpl->postedFunctionsLock.lock();
-                        f = *mImpl->postedFunctions.begin();  // copy
-                        mImpl->postedFunctionsLock.unlock();
-
-                        f();
-
-                        mImpl->postedFunctionsLock.lock();
-                        mImpl->postedFunctions.erase(mImpl->postedFunctions.begin());
-                        mImpl->postedFunctionsLock.unlock();
-                    }
                 }
                 break;
             default:
                 break;
         }
 
-        if (mImpl->xwin2window.empty()) {
+        if (lastWindowClosed()) {
             done = true;
         }
     }
+    return 0;
 }
 
 void X11Application::exitRun()
@@ -1145,6 +1265,16 @@ void X11Application::unregisterWindow(long unsigned int xwindow)
     mImpl->postedLater.removeForWindow(xwindow);
 }
 
+bool X11Application::supportsSharedMemory() const
+{
+    return mImpl->supportsShm;
+}
+
+int X11Application::shmCompletionEventType() const
+{
+    return mImpl->shmCompletionType;
+}
+
 float X11Application::dpiForScreen(int screen)
 {
     if (screen >= mImpl->xrdbScreenStrings.size()) {
@@ -61,6 +61,7 @@ public:
     bool isOriginInUpperLeft() const override;
     bool isWindowBorderInsideWindowFrame() const override;
     bool windowsMightUseSameDrawContext() const override;
+    bool windowContentsPersistBetweenDraws() const override;
     bool shouldHideScrollbars() const override;
     bool canKeyFocusEverything() const override;
     bool platformHasMenubar() const override;
@@ -80,6 +81,15 @@ public:
 
     float dpiForScreen(int screen);
 
+    /// Returns true if the MIT-SHM extension is available. This does not
+    /// guarantee that attaching a segment will succeed (it will not if the
+    /// server is remote).
+    bool supportsSharedMemory() const;
+    /// Returns the event type of XShmCompletionEvent, or -1 if MIT-SHM is
+    /// not available. The event loop passes these to
+    /// X11Window::onShmCompletion().
+    int shmCompletionEventType() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> mImpl;
@@ -26,14 +26,23 @@
 #include "../Application.h"
 #include "../Cursor.h"
 #include "../Events.h"
+#include "../Instrumentation.h"
 #include "../OSCursor.h"
 #include "../TextEditorLogic.h"
 #include "../private/Utils.h"
 #include "X11Application.h"
 
-#include <string.h>  // for memset()
+#include <cairo.h>
+#include <string.h>  // for memset(), memcpy()
+#include <sys/ipc.h>
+#include <sys/shm.h>
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace uitk {
 
@@ -46,6 +55,31 @@ static const int _NET_WM_STATE_REMOVE = 0;
 static const int _NET_WM_STATE_ADD = 1;
 static const int _NET_WM_STATE_TOGGLE = 2;
 
+// More exposed rects than this are presented as their bounding rect
+static const size_t kMaxExposedRects = 16;
+
+// XShmAttach() fails asynchronously if the server cannot access our memory
+// (for instance, if it is remote), so we need an error handler to find out.
+bool gShmAttachFailed = false;
+
+int onShmAttachError(Display *d, XErrorEvent *e)
+{
+    gShmAttachFailed = true;
+    return 0;
+}
+
+struct ShmCompletionMatch
+{
+    int type;
+    ::Window xwindow;
+};
+
+Bool isShmCompletion(Display *d, XEvent *e, XPointer arg)
+{
+    auto *match = (ShmCompletionMatch*)arg;
+    return (e->type == match->type && e->xany.window == match->xwindow);
+}
+
 bool hasWMProperty(Display *d, ::Window xwin, const char *prop)
 {
     long maxLen = 64;
@@ -244,6 +278,11 @@ struct X11Window::Impl {
     int xscreenNo = 0;
     int width;
     int height;
+    int depth = 24;
+    Visual *visual = nullptr;
+    // The backbuffer may be larger than the window, see resize()
+    int bufferWidth = 0;
+    int bufferHeight = 0;
     int flags = 0;
     float dpi = 96.0f;
     // X11 does not have any kind of double-buffering, so everything draws
@@ -257,29 +296,279 @@ struct X11Window::Impl {
     // 5 - 10% faster in the non-release build.)
     std::shared_ptr<DrawContext> windowDC;
     std::shared_ptr<DrawContext> dc;
+    // `dc` is a bitmap in our memory. If the server is local, presenting
+    // copies the damaged areas into a shared memory XImage and sends it with
+    // XShmPutImage(), so the server reads the pixels directly from the
+    // segment instead of them being sent through the socket. (nativedraw
+    // allocates the bitmap's memory, so cairo cannot render into the segment
+    // itself, but copying the damaged rows is cheap compared to sending them.)
+    struct {
+        XShmSegmentInfo info;
+        XImage *image = nullptr;
+        GC gc = nullptr;
+        bool failed = false;  // do not keep trying if it did not work
+        // The server reads the segment when it processes the XShmPutImage()
+        // requests, so the segment may not be written again until it has.
+        bool awaitingCompletion = false;
+    } shm;
+    OSFrameStats frameStats;
     std::string title;
     TextEditorLogic *textEditor = nullptr;
     Rect textRect;
     bool showing = false;
 
+    // Areas that the X server has asked us to repaint (in addition to
+    // whatever was redrawn).
+    std::vector<Rect> exposed;
+
     bool drawRequested = false;
     bool needsLayout = true;
 
+    // This requires a round-trip to the server, so only call when the
+    // screen might have changed. Use resize() for size changes.
     void updateDrawContext()
     {
         XWindowAttributes attrs;
         XGetWindowAttributes(this->display, this->xwindow, &attrs);
-        this->width = attrs.width;
-        this->height = attrs.height;
         this->xscreenNo = XScreenNumberOfScreen(attrs.screen);
         X11Application& x11app = static_cast<X11Application&>(Application::instance().osApplication());
         this->dpi = x11app.dpiForScreen(this->xscreenNo);
+        this->depth = attrs.depth;
+        this->visual = attrs.visual;
+
+        this->dc = nullptr;  // DPI may have changed, so force a new backbuffer
+        resize(attrs.width, attrs.height);
+    }
 
+    void resize(int w, int h)
+    {
+        this->width = w;
+        this->height = h;
         this->windowDC = DrawContext::fromX11(this->display, &this->xwindow,
                                               this->width, this->height,
                                               this->dpi);
-        this->dc = this->windowDC->createBitmap(
-                        kBitmapRGBA, this->width, this->height, this->dpi);
+
+        // Dragging the edge of the window resizes it by a few pixels at a
+        // time, so reallocating the backbuffer each time would be slow.
+        // Instead, grow it geometrically and keep it if the window gets
+        // smaller, unless it gets a lot smaller. (Window draws using the
+        // window's size, not the backbuffer's.)
+        bool isTooSmall = (w > this->bufferWidth || h > this->bufferHeight);
+        bool isTooLarge = (long(w) * long(h) < long(this->bufferWidth) * long(this->bufferHeight) / 4);
+        if (this->dc && !isTooSmall && !isTooLarge) {
+            return;
+        }
+        int bufferW = w;
+        int bufferH = h;
+        if (this->dc && isTooSmall) {
+            if (w > this->bufferWidth) {
+                bufferW = std::max(w, this->bufferWidth + this->bufferWidth / 2);
+            } else {
+                bufferW = this->bufferWidth;
+            }
+            if (h > this->bufferHeight) {
+                bufferH = std::max(h, this->bufferHeight + this->bufferHeight / 2);
+            } else {
+                bufferH = this->bufferHeight;
+            }
+        }
+        createBackbuffer(bufferW, bufferH);
+    }
+
+    void createBackbuffer(int w, int h)
+    {
+        this->dc = nullptr;
+        destroyShmImage();
+
+        this->dc = this->windowDC->createBitmap(kBitmapRGBA, w, h, this->dpi);
+        X11Application& x11app = static_cast<X11Application&>(Application::instance().osApplication());
+        if (!this->shm.failed && x11app.supportsSharedMemory()) {
+            if (!createShmImage(w, h)) {
+                this->shm.failed = true;
+            }
+        }
+        this->bufferWidth = w;
+        this->bufferHeight = h;
+        this->frameStats.usesSharedMemory = (this->shm.image != nullptr);
+    }
+
+    // Returns the bitmap's pixels if they can be copied directly into the
+    // shared memory image, otherwise nullptr.
+    cairo_surface_t* bitmapSurface() const
+    {
+        // This depends on nativedraw's Cairo backend returning its cairo_t
+        // from nativeDC(), which nativedraw does not promise. The checks
+        // below keep a different surface from being used, but not a
+        // different kind of pointer.
+        auto *surface = cairo_get_target((cairo_t*)this->dc->nativeDC());
+        if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE) {
+            return nullptr;
+        }
+        auto format = cairo_image_surface_get_format(surface);
+        if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) {
+            return nullptr;
+        }
+        if (cairo_image_surface_get_width(surface) < this->bufferWidth ||
+            cairo_image_surface_get_height(surface) < this->bufferHeight) {
+            return nullptr;
+        }
+        return surface;
+    }
+
+    bool createShmImage(int w, int h)
+    {
+        // Cairo's ARGB32 is a native-endian 0xAARRGGBB, so the server's
+        // pixels need to be the same, otherwise we would need to convert.
+        if ((this->depth != 24 && this->depth != 32) || !this->visual ||
+            this->visual->red_mask != 0xff0000 || this->visual->green_mask != 0x00ff00 ||
+            this->visual->blue_mask != 0x0000ff) {
+            return false;
+        }
+
+        auto &shm = this->shm;
+        memset(&shm.info, 0, sizeof(shm.info));
+        shm.image = XShmCreateImage(this->display, this->visual, this->depth, ZPixmap,
+                                    nullptr, &shm.info, w, h);
+        if (!shm.image) {
+            return false;
+        }
+        const uint32_t kOne = 1;
+        int hostByteOrder = (*(const uint8_t*)&kOne == 1 ? LSBFirst : MSBFirst);
+        if (shm.image->bits_per_pixel != 32 || shm.image->byte_order != hostByteOrder) {
+            XDestroyImage(shm.image);
+            shm.image = nullptr;
+            return false;
+        }
+
+        size_t nBytes = size_t(shm.image->bytes_per_line) * size_t(h);
+        shm.info.shmid = shmget(IPC_PRIVATE, std::max(nBytes, size_t(4)), IPC_CREAT | 0600);
+        if (shm.info.shmid < 0) {
+            XDestroyImage(shm.image);
+            shm.image = nullptr;
+            return false;
+        }
+        shm.info.shmaddr = (char*)shmat(shm.info.shmid, nullptr, 0);
+        if (shm.info.shmaddr == (char*)-1) {
+            shmctl(shm.info.shmid, IPC_RMID, nullptr);
+            XDestroyImage(shm.image);
+            shm.image = nullptr;
+            return false;
+        }
+        shm.image->data = shm.info.shmaddr;
+        shm.info.readOnly = True;  // the server only reads from it
+
+        XSync(this->display, False);
+        gShmAttachFailed = false;
+        auto oldHandler = XSetErrorHandler(onShmAttachError);
+        Bool attached = XShmAttach(this->display, &shm.info);
+        XSync(this->display, False);
+        XSetErrorHandler(oldHandler);
+        // The segment is destroyed once both we and the server detach
+        shmctl(shm.info.shmid, IPC_RMID, nullptr);
+        if (!attached || gShmAttachFailed) {
+            shm.image->data = nullptr;  // not malloc'ed, XDestroyImage must not free it
+            XDestroyImage(shm.image);
+            shm.image = nullptr;
+            shmdt(shm.info.shmaddr);
+            return false;
+        }
+
+        if (!shm.gc) {
+            shm.gc = XCreateGC(this->display, this->xwindow, 0, nullptr);
+        }
+        return true;
+    }
+
+    // Blocks until the server has finished reading the segment. Normally the
+    // event loop has already received the completion by the next frame.
+    void waitForShmCompletion()
+    {
+        if (!this->shm.awaitingCompletion) {
+            return;
+        }
+        auto &x11app = static_cast<X11Application&>(Application::instance().osApplication());
+        ShmCompletionMatch match = { x11app.shmCompletionEventType(), this->xwindow };
+        XEvent event;
+        XIfEvent(this->display, &event, isShmCompletion, (XPointer)&match);
+        this->shm.awaitingCompletion = false;
+    }
+
+    void destroyShmImage()
+    {
+        if (this->shm.image) {
+            waitForShmCompletion();
+            XShmDetach(this->display, &this->shm.info);
+            XSync(this->display, False);  // server must detach before we do
+            this->shm.image->data = nullptr;
+            XDestroyImage(this->shm.image);
+            this->shm.image = nullptr;
+            shmdt(this->shm.info.shmaddr);
+        }
+    }
+
+    // Copies the areas from the backbuffer to the window.
+    void present(const std::vector<Rect>& rects)
+    {
+        if (rects.empty()) {
+            return;
+        }
+
+        cairo_surface_t *surface = (this->shm.image ? bitmapSurface() : nullptr);
+        if (surface) {
+            struct Box { int x0, y0, x1, y1; };
+            std::vector<Box> boxes;
+            boxes.reserve(rects.size());
+            for (auto &r : rects) {
+                int x0 = std::max(0, int(std::floor(r.x.toPixels(this->dpi))));
+                int y0 = std::max(0, int(std::floor(r.y.toPixels(this->dpi))));
+                int x1 = std::min(this->bufferWidth, int(std::ceil(r.maxX().toPixels(this->dpi))));
+                int y1 = std::min(this->bufferHeight, int(std::ceil(r.maxY().toPixels(this->dpi))));
+                if (x1 > x0 && y1 > y0) {
+                    boxes.push_back({ x0, y0, x1, y1 });
+                }
+            }
+            if (boxes.empty()) {
+                return;
+            }
+
+            waitForShmCompletion();  // the previous frame's pixels are still being read
+            cairo_surface_flush(surface);
+            auto *src = cairo_image_surface_get_data(surface);
+            int srcStride = cairo_image_surface_get_stride(surface);
+            auto *image = this->shm.image;
+            for (auto &b : boxes) {
+                size_t rowBytes = size_t(b.x1 - b.x0) * 4;
+                for (int y = b.y0;  y < b.y1;  ++y) {
+                    memcpy(image->data + y * image->bytes_per_line + b.x0 * 4,
+                           src + y * srcStride + b.x0 * 4, rowBytes);
+                }
+            }
+            // The server processes requests in order, so a completion for
+            // the last one means that it has read all of them.
+            for (size_t i = 0;  i < boxes.size();  ++i) {
+                auto &b = boxes[i];
+                XShmPutImage(this->display, this->xwindow, this->shm.gc, image,
+                             b.x0, b.y0, b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0,
+                             (i + 1 == boxes.size()) ? True : False);
+            }
+            this->shm.awaitingCompletion = true;
+            XFlush(this->display);
+            return;
+        }
+
+        // Clipping the window's context means that only the clipped areas
+        // are sent to the X server, which is the part that is slow.
+        // On X11 copyToImage() should be a simple pointer copy.
+        std::shared_ptr<DrawableImage> image = this->dc->copyToImage();
+        auto imageRect = Rect::fromPixels(0, 0, this->dc->width(), this->dc->height(), this->dpi);
+        this->windowDC->beginDraw();
+        for (auto &r : rects) {
+            this->windowDC->save();
+            this->windowDC->clipToRect(r);
+            this->windowDC->drawImage(image, imageRect);
+            this->windowDC->restore();
+        }
+        this->windowDC->endDraw();
     }
 
     void destroyWindow()
@@ -291,6 +580,11 @@ struct X11Window::Impl {
 
         this->dc = nullptr;
         this->windowDC = nullptr;
+        destroyShmImage();
+        if (this->shm.gc) {
+            XFreeGC(this->display, this->shm.gc);
+            this->shm.gc = nullptr;
+        }
 
         XDestroyIC(this->xic);
         this->xic = nullptr;
@@ -785,9 +1079,16 @@ void X11Window::setAccessibleElements(const std::vector<AccessibilityInfo>& elem
     // unsupported at this time
 }
 
-void X11Window::onResize()
+void X11Window::onResize(int width, int height)
 {
-    mImpl->updateDrawContext();
+    // ConfigureNotify is also sent when the window is moved or restacked,
+    // neither of which concerns us. (A move cannot change the DPI, since
+    // windows cannot move between X screens.)
+    if (width == mImpl->width && height == mImpl->height) {
+        return;
+    }
+
+    mImpl->resize(width, height);
     mImpl->callbacks.onResize(*mImpl->dc);
     // We need to relayout after a resize, but defer until the draw because
     // we are probably going to get another resize event immediately after
@@ -801,6 +1102,26 @@ void X11Window::onLayout()
     mImpl->needsLayout = false;
 }
 
+void X11Window::onShmCompletion()
+{
+    mImpl->shm.awaitingCompletion = false;
+}
+
+void X11Window::addExposedArea(int x, int y, int width, int height)
+{
+    auto r = Rect::fromPixels(float(x), float(y), float(width), float(height), mImpl->dpi);
+    auto &exposed = mImpl->exposed;
+    if (exposed.size() < kMaxExposedRects) {
+        exposed.push_back(r);
+    } else {
+        // Too many to do individually; grow the last one to include this one
+        auto &b = exposed.back();
+        auto x0 = std::min(b.x, r.x);
+        auto y0 = std::min(b.y, r.y);
+        b = Rect(x0, y0, std::max(b.maxX(), r.maxX()) - x0, std::max(b.maxY(), r.maxY()) - y0);
+    }
+}
+
 void X11Window::onDraw()
 {
     if (mImpl->needsLayout) {
@@ -811,17 +1132,32 @@ void X11Window::onDraw()
     // would work.
     mImpl->drawRequested = false;
 
-    mImpl->callbacks.onDraw(*mImpl->dc);
-    // On X11 copyToImage() should be a simple pointer copy
-    std::shared_ptr<DrawableImage> image = mImpl->dc->copyToImage();
-    mImpl->windowDC->beginDraw();
-    mImpl->windowDC->drawImage(
-                         image,
-                         Rect::fromPixels(0, 0, mImpl->dc->width(),
-                                          mImpl->dc->height(), mImpl->dpi));
-    mImpl->windowDC->endDraw();
+    auto &app = Application::instance();
+    auto t0 = app.microTime();
+
+    // Window only draws what changed (the backbuffer keeps everything else),
+    // so we only need to send the changed areas and any exposed areas.
+    auto rects = mImpl->callbacks.onDraw(*mImpl->dc);
+    if (!mImpl->exposed.empty()) {
+        rects.insert(rects.end(), mImpl->exposed.begin(), mImpl->exposed.end());
+        mImpl->exposed.clear();
+    }
+    auto t1 = app.microTime();
+    mImpl->present(rects);
+    auto t2 = app.microTime();
+
+    mImpl->frameStats.nFrames += 1;
+    mImpl->frameStats.drawSecs += t1 - t0;
+    mImpl->frameStats.presentSecs += t2 - t1;
+
+    auto &instr = app.instrumentation();
+    if (instr.isEnabled()) {
+        instr.addPresentTime(dynamic_cast<Window*>(&mImpl->callbacks), t2 - t1);
+    }
 }
 
+OSFrameStats X11Window::frameStats() const { return mImpl->frameStats; }
+
 void X11Window::onMouse(MouseEvent& e, int x, int y)
 {
     // Marking a popup window as transient (so it acts like a popup window)
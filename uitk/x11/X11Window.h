@@ -82,8 +82,11 @@ public:
     void setNeedsAccessibilityUpdate() override;
     void setAccessibleElements(const std::vector<AccessibilityInfo>& elements) override;
 
-    void onResize();
+    OSFrameStats frameStats() const override;
+
+    void onResize(int width, int height);
     void onLayout();
+    void addExposedArea(int x, int y, int width, int height);
     void onDraw();
     void onMouse(MouseEvent& e, int x, int y);
     void onKey(const KeyEvent& e);
@@ -92,6 +95,7 @@ public:
     void onDeactivated();
     bool onWindowShouldClose();
     void onWindowWillClose();
+    void onShmCompletion();
 
 public:
     void* xic() const;